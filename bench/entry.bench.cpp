@@ -0,0 +1,122 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+#include "int_node.h"
+#include "util.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+struct Counter : IntNode {
+    explicit Counter(int k) noexcept : IntNode(k), count(0) { }
+
+    int count;
+};
+
+enum class Update { GetMutThenModify, Entry };
+
+// counts random keys, deleting a counter once it drops back to zero
+void count(int num_keys, Update update, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    std::vector<int> keys;
+    std::vector<Counter> counters;
+    AvlTree tree;
+
+    std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+
+    for (int i = 0; i < num_keys; ++i) {
+        keys.push_back(key_dist(*urbg_ptr));
+        counters.emplace_back(i);
+    }
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (int i = 0; i < num_keys; i += 2) {
+        counters[i].count = 1;
+        AvlTree_insert(&tree, &counters[i]);
+    }
+
+    meter.measure([&] {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const int key = keys[i];
+            const bool increment = (i % 2 == 0);
+
+            if (update == Update::GetMutThenModify) {
+                Counter *const counter = static_cast<Counter*>(
+                    AvlTree_get_mut(&tree, &key, int_node_het_compare, nullptr)
+                );
+
+                if (!counter) {
+                    counters[key].count = 1;
+                    AvlTree_insert(&tree, &counters[key]);
+                } else if (increment) {
+                    ++counter->count;
+                } else if (--counter->count == 0) {
+                    AvlTree_remove(&tree, &key, int_node_het_compare, nullptr);
+                }
+            } else {
+                AvlEntry entry;
+                Counter *const counter = static_cast<Counter*>(
+                    AvlTree_entry(&tree, &key, int_node_het_compare, nullptr, &entry)
+                );
+
+                if (!counter) {
+                    counters[key].count = 1;
+                    AvlEntry_insert(&entry, &counters[key]);
+                } else if (increment) {
+                    ++counter->count;
+                } else if (--counter->count == 0) {
+                    AvlEntry_remove(&entry);
+                }
+            }
+        }
+
+        return tree.len;
+    });
+
+    AvlTree_drop(&tree);
+}
+
+} // namespace
+
+TEST_CASE("entry") {
+    BENCHMARK_ADVANCED("1024 keys, get_mut then insert or remove")(Catch::Benchmark::Chronometer meter) {
+        count(1024, Update::GetMutThenModify, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 keys, AvlTree_entry")(Catch::Benchmark::Chronometer meter) {
+        count(1024, Update::Entry, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 keys, get_mut then insert or remove")(Catch::Benchmark::Chronometer meter) {
+        count(65536, Update::GetMutThenModify, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 keys, AvlTree_entry")(Catch::Benchmark::Chronometer meter) {
+        count(65536, Update::Entry, meter);
+    };
+}
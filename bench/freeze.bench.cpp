@@ -0,0 +1,128 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+void extract_int_key(const AvlNode *node, void *key, void*) {
+    const int k = int_node_key(node);
+
+    std::memcpy(key, &k, sizeof(int));
+}
+
+int compare_int_keys(const void *lhs_v, const void *rhs_v, void*) {
+    const int lhs = *static_cast<const int*>(lhs_v);
+    const int rhs = *static_cast<const int*>(rhs_v);
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+AvlIntKey extract_int_key_value(const AvlNode *node, void*) {
+    return int_node_key(node);
+}
+
+enum class Search { Tree, Frozen, FrozenInts };
+
+// looks up every key in random order, in the tree or in a frozen snapshot of it
+void lookup(std::size_t num_nodes, Search search, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(num_nodes, *urbg_ptr);
+    const std::vector<int> queries = rand_iota(num_nodes, *urbg_ptr);
+    AvlNodePool pool;
+    AvlTree tree;
+    AvlFrozenTree frozen;
+    AvlFrozenIntTree frozen_ints;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&tree, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    for (int key : keys) {
+        AvlTree_insert(&tree, new (AvlNodePool_alloc(&pool)) IntNode(key));
+    }
+
+    AvlTree_freeze(&tree, &frozen, sizeof(int), extract_int_key, nullptr);
+    AvlTree_freeze_ints(&tree, &frozen_ints, extract_int_key_value, nullptr);
+
+    meter.measure([&] {
+        std::size_t num_found = 0;
+
+        for (int key : queries) {
+            switch (search) {
+            case Search::Tree:
+                num_found += AvlTree_get(&tree, &key, int_node_het_compare, nullptr) != nullptr;
+                break;
+            case Search::Frozen:
+                num_found += AvlFrozenTree_get(&frozen, &key, compare_int_keys, nullptr) != nullptr;
+                break;
+            case Search::FrozenInts:
+                num_found += AvlFrozenIntTree_get(&frozen_ints, key) != nullptr;
+                break;
+            }
+        }
+
+        return num_found;
+    });
+
+    AvlFrozenIntTree_drop(&frozen_ints);
+    AvlFrozenTree_drop(&frozen);
+    AvlTree_drop(&tree);
+    AvlNodePool_drop(&pool);
+}
+
+} // namespace
+
+TEST_CASE("frozen get") {
+    BENCHMARK_ADVANCED("1024 nodes, AvlTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Search::Tree, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, AvlFrozenTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Search::Frozen, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, AvlFrozenIntTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Search::FrozenInts, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AvlTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Search::Tree, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AvlFrozenTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Search::Frozen, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AvlFrozenIntTree_get")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Search::FrozenInts, meter);
+    };
+}
@@ -0,0 +1,116 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <new>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+AVL_DEFINE_TREE(int_tree, IntNode, (lhs->key > rhs->key) - (lhs->key < rhs->key))
+
+enum class Lookup { Get, Batched, Defined };
+
+// looks up every key of a tree of num_nodes pool allocated nodes in random order
+void lookup(std::size_t num_nodes, Lookup lookup, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(num_nodes, *urbg_ptr);
+    const std::vector<int> queries = rand_iota(num_nodes, *urbg_ptr);
+    std::vector<const void*> query_ptrs;
+    std::vector<const AvlNode*> found(num_nodes);
+    AvlNodePool pool;
+    AvlTree tree;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&tree, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    for (int key : keys) {
+        AvlTree_insert(&tree, new (AvlNodePool_alloc(&pool)) IntNode(key));
+    }
+
+    for (const int &query : queries) {
+        query_ptrs.push_back(&query);
+    }
+
+    meter.measure([&] {
+        switch (lookup) {
+        case Lookup::Get:
+            for (std::size_t i = 0; i < queries.size(); ++i) {
+                found[i] = AvlTree_get(&tree, &queries[i], int_node_het_compare, nullptr);
+            }
+
+            break;
+        case Lookup::Batched:
+            AvlTree_get_batch(&tree, query_ptrs.data(), query_ptrs.size(), int_node_het_compare,
+                              nullptr, found.data());
+
+            break;
+        case Lookup::Defined:
+            for (std::size_t i = 0; i < queries.size(); ++i) {
+                const IntNode probe(queries[i]);
+                found[i] = int_tree_get(&tree, &probe);
+            }
+
+            break;
+        }
+
+        return found.back();
+    });
+
+    AvlTree_drop(&tree);
+    AvlNodePool_drop(&pool);
+}
+
+} // namespace
+
+TEST_CASE("get") {
+    BENCHMARK_ADVANCED("1024 nodes")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Lookup::Get, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, batched")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Lookup::Batched, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, AVL_DEFINE_TREE")(Catch::Benchmark::Chronometer meter) {
+        lookup(1024, Lookup::Defined, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Lookup::Get, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, batched")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Lookup::Batched, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AVL_DEFINE_TREE")(Catch::Benchmark::Chronometer meter) {
+        lookup(262144, Lookup::Defined, meter);
+    };
+}
@@ -0,0 +1,176 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+enum class Insertion { Plain, Hinted, Built };
+
+// inserts num_nodes nodes in increasing order of key, then clears the tree
+void append(std::size_t num_nodes, Insertion insertion, Catch::Benchmark::Chronometer meter) {
+    std::vector<IntNode> nodes;
+    std::vector<AvlNode*> node_ptrs;
+
+    for (int key : iota(num_nodes)) {
+        nodes.emplace_back(key);
+    }
+
+    for (IntNode &node : nodes) {
+        node_ptrs.push_back(&node);
+    }
+
+    meter.measure([&] {
+        AvlTree tree;
+        AvlCursor end;
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+        AvlCursor_new(&end, &tree);
+
+        switch (insertion) {
+        case Insertion::Plain:
+            for (AvlNode *node : node_ptrs) {
+                AvlTree_insert(&tree, node);
+            }
+
+            break;
+        case Insertion::Hinted:
+            for (AvlNode *node : node_ptrs) {
+                AvlTree_insert_hint(&tree, &end, node);
+            }
+
+            break;
+        case Insertion::Built:
+            AvlTree_build_sorted(&tree, node_ptrs.data(), node_ptrs.size());
+
+            break;
+        }
+
+        const std::size_t len = tree.len;
+        AvlTree_drop(&tree);
+
+        return len;
+    });
+}
+
+// rebuilds a tree of even keys, then inserts a sorted batch of odd keys spread across it or,
+// if clustered, appended past its end
+void ingest(std::size_t num_nodes, std::size_t batch_size, bool clustered, bool batched,
+            Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    std::vector<int> batch_keys =
+        clustered ? iota(batch_size, static_cast<int>(num_nodes)) : rand_iota(num_nodes, *urbg_ptr);
+    std::vector<IntNode> nodes;
+    std::vector<IntNode> batch_nodes;
+    std::vector<AvlNode*> node_ptrs;
+    std::vector<AvlNode*> batch_ptrs;
+
+    batch_keys.resize(batch_size);
+    std::sort(batch_keys.begin(), batch_keys.end());
+
+    for (int key : iota(num_nodes)) {
+        nodes.emplace_back(2 * key);
+    }
+
+    for (int key : batch_keys) {
+        batch_nodes.emplace_back(2 * key + 1);
+    }
+
+    for (IntNode &node : nodes) {
+        node_ptrs.push_back(&node);
+    }
+
+    for (IntNode &node : batch_nodes) {
+        batch_ptrs.push_back(&node);
+    }
+
+    meter.measure([&] {
+        AvlTree tree;
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+        AvlTree_build_sorted(&tree, node_ptrs.data(), node_ptrs.size());
+
+        if (batched) {
+            AvlTree_insert_sorted_batch(&tree, batch_ptrs.data(), batch_ptrs.size());
+        } else {
+            for (AvlNode *node : batch_ptrs) {
+                AvlTree_insert(&tree, node);
+            }
+        }
+
+        const std::size_t len = tree.len;
+        AvlTree_drop(&tree);
+
+        return len;
+    });
+}
+
+} // namespace
+
+TEST_CASE("append") {
+    BENCHMARK_ADVANCED("262144 nodes, AvlTree_insert")(Catch::Benchmark::Chronometer meter) {
+        append(262144, Insertion::Plain, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AvlTree_insert_hint")(Catch::Benchmark::Chronometer meter) {
+        append(262144, Insertion::Hinted, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, AvlTree_build_sorted")(Catch::Benchmark::Chronometer meter) {
+        append(262144, Insertion::Built, meter);
+    };
+}
+
+TEST_CASE("sorted batch") {
+    BENCHMARK_ADVANCED("262144 nodes, 16384 new, AvlTree_insert")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 16384, false, false, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, 16384 new, AvlTree_insert_sorted_batch")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 16384, false, true, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, 131072 new, AvlTree_insert")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 131072, false, false, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, 131072 new, AvlTree_insert_sorted_batch")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 131072, false, true, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, 16384 appended, AvlTree_insert")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 16384, true, false, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 nodes, 16384 appended, AvlTree_insert_sorted_batch")(Catch::Benchmark::Chronometer meter) {
+        ingest(262144, 16384, true, true, meter);
+    };
+}
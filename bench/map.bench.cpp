@@ -0,0 +1,132 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "avl_map.h"
+#include "bloodhound.hpp"
+#include "util.h"
+
+#include <map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+enum class Container { Std, Template, Callback };
+
+// inserts num_nodes keys in random order, looks each one up, then removes them all
+void churn(std::size_t num_nodes, Container container, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(num_nodes, *urbg_ptr);
+    const std::vector<int> queries = rand_iota(num_nodes, *urbg_ptr);
+
+    meter.measure([&] {
+        long sum = 0;
+
+        switch (container) {
+        case Container::Std: {
+            std::map<int, int> map;
+
+            for (int key : keys) {
+                map.emplace(key, key);
+            }
+
+            for (int query : queries) {
+                sum += map.find(query)->second;
+            }
+
+            for (int query : queries) {
+                map.erase(query);
+            }
+
+            break;
+        }
+        case Container::Template: {
+            avl::map<int, int> map;
+
+            for (int key : keys) {
+                map.emplace(key, key);
+            }
+
+            for (int query : queries) {
+                sum += map.find(query)->second;
+            }
+
+            for (int query : queries) {
+                map.erase(query);
+            }
+
+            break;
+        }
+        case Container::Callback: {
+            avl::Map<int, int> map;
+
+            for (int key : keys) {
+                map.insert(key, key);
+            }
+
+            for (int query : queries) {
+                sum += *map.get(query);
+            }
+
+            for (int query : queries) {
+                map.remove(query);
+            }
+
+            break;
+        }
+        }
+
+        return sum;
+    });
+}
+
+} // namespace
+
+TEST_CASE("map") {
+    BENCHMARK_ADVANCED("1024 keys, std::map")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Container::Std, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 keys, avl::map")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Container::Template, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 keys, AvlTree callbacks")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Container::Callback, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 keys, std::map")(Catch::Benchmark::Chronometer meter) {
+        churn(262144, Container::Std, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 keys, avl::map")(Catch::Benchmark::Chronometer meter) {
+        churn(262144, Container::Template, meter);
+    };
+
+    BENCHMARK_ADVANCED("262144 keys, AvlTree callbacks")(Catch::Benchmark::Chronometer meter) {
+        churn(262144, Container::Callback, meter);
+    };
+}
@@ -0,0 +1,117 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <new>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+void delete_int_node(AvlNode *node, void*) {
+    delete static_cast<IntNode*>(node);
+}
+
+void build_and_clear_heap(const std::vector<int> &keys, Catch::Benchmark::Chronometer meter) {
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, delete_int_node, nullptr);
+
+    meter.measure([&] {
+        for (int key : keys) {
+            AvlTree_insert(&tree, new IntNode(key));
+        }
+
+        const std::size_t len = tree.len;
+        AvlTree_clear(&tree);
+
+        return len;
+    });
+}
+
+void build_and_clear_pool(const std::vector<int> &keys, Catch::Benchmark::Chronometer meter) {
+    AvlNodePool pool;
+    AvlTree tree;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&tree, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    meter.measure([&] {
+        for (int key : keys) {
+            AvlTree_insert(&tree, new (AvlNodePool_alloc(&pool)) IntNode(key));
+        }
+
+        const std::size_t len = tree.len;
+        AvlTree_clear(&tree);
+
+        return len;
+    });
+
+    AvlNodePool_drop(&pool);
+}
+
+void build_and_clear_arena(const std::vector<int> &keys, Catch::Benchmark::Chronometer meter) {
+    AvlArena arena;
+    AvlTree tree;
+
+    AvlArena_new(&arena, 0);
+    AvlTree_new_in_arena(&tree, int_node_compare, nullptr, &arena);
+
+    meter.measure([&] {
+        for (int key : keys) {
+            AvlTree_insert(&tree, new (AvlArena_alloc(&arena, sizeof(IntNode))) IntNode(key));
+        }
+
+        const std::size_t len = tree.len;
+        AvlTree_clear(&tree);
+        AvlArena_reset(&arena);
+
+        return len;
+    });
+
+    AvlArena_drop(&arena);
+}
+
+} // namespace
+
+TEST_CASE("build and clear") {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(65536, *urbg_ptr);
+
+    BENCHMARK_ADVANCED("65536 nodes, operator new")(Catch::Benchmark::Chronometer meter) {
+        build_and_clear_heap(keys, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, AvlNodePool")(Catch::Benchmark::Chronometer meter) {
+        build_and_clear_pool(keys, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, AvlArena")(Catch::Benchmark::Chronometer meter) {
+        build_and_clear_arena(keys, meter);
+    };
+}
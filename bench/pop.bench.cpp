@@ -0,0 +1,102 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+enum class Pop { RemoveKey, PopFirst, PopFirstCached };
+
+// a deadline queue: repeatedly takes the earliest node and requeues it num_nodes later
+void requeue(std::size_t num_nodes, Pop pop, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(num_nodes, *urbg_ptr));
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    if (pop == Pop::PopFirstCached) {
+        AvlTree_enable_extremes(&tree);
+    }
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+    }
+
+    meter.measure([&] {
+        for (std::size_t i = 0; i < num_nodes; ++i) {
+            IntNode *earliest;
+
+            if (pop == Pop::RemoveKey) {
+                const int key = int_node_key(AvlTree_first(&tree));
+                earliest = static_cast<IntNode*>(
+                    AvlTree_remove(&tree, &key, int_node_het_compare, nullptr)
+                );
+            } else {
+                earliest = static_cast<IntNode*>(AvlTree_pop_first(&tree));
+            }
+
+            earliest->key += static_cast<int>(num_nodes);
+            AvlTree_insert(&tree, earliest);
+        }
+
+        return tree.len;
+    });
+
+    AvlTree_drop(&tree);
+}
+
+} // namespace
+
+TEST_CASE("pop_first") {
+    BENCHMARK_ADVANCED("1024 nodes, AvlTree_remove")(Catch::Benchmark::Chronometer meter) {
+        requeue(1024, Pop::RemoveKey, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, AvlTree_pop_first")(Catch::Benchmark::Chronometer meter) {
+        requeue(1024, Pop::PopFirst, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, cached extremes")(Catch::Benchmark::Chronometer meter) {
+        requeue(1024, Pop::PopFirstCached, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, AvlTree_remove")(Catch::Benchmark::Chronometer meter) {
+        requeue(65536, Pop::RemoveKey, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, AvlTree_pop_first")(Catch::Benchmark::Chronometer meter) {
+        requeue(65536, Pop::PopFirst, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, cached extremes")(Catch::Benchmark::Chronometer meter) {
+        requeue(65536, Pop::PopFirstCached, meter);
+    };
+}
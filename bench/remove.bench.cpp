@@ -0,0 +1,146 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+enum class Removal { ByKey, ByKeyWithParents, ByNode };
+
+void churn(std::size_t num_nodes, Removal removal, Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(num_nodes, *urbg_ptr);
+    std::vector<ParentIntNode> nodes = make_int_nodes<ParentIntNode>(keys);
+    AvlTree tree;
+
+    AvlTree_new(&tree, parent_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    if (removal != Removal::ByKey) {
+        AvlTree_enable_parents(&tree);
+    }
+
+    for (ParentIntNode &node : nodes) {
+        AvlTree_insert(&tree, &node.base.node);
+    }
+
+    // remove and reinsert every node, keeping the tree at num_nodes
+    meter.measure([&] {
+        for (ParentIntNode &node : nodes) {
+            if (removal == Removal::ByNode) {
+                AvlTree_remove_node(&tree, &node.base.node);
+            } else {
+                AvlTree_remove(&tree, &node.key, parent_int_node_het_compare, nullptr);
+            }
+
+            AvlTree_insert(&tree, &node.base.node);
+        }
+
+        return tree.len;
+    });
+
+    AvlTree_drop(&tree);
+}
+
+// removes a window of consecutive keys, as a cache expiring entries would, then puts it back
+void expire(std::size_t num_nodes, std::size_t num_expired, bool by_range,
+            Catch::Benchmark::Chronometer meter) {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(iota(num_nodes));
+    const std::vector<int> insertion_order = rand_iota(num_nodes, *urbg_ptr);
+    std::size_t start = 0;
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (int key : insertion_order) {
+        AvlTree_insert(&tree, &nodes[static_cast<std::size_t>(key)]);
+    }
+
+    meter.measure([&] {
+        const int lo = static_cast<int>(start);
+        const int hi = static_cast<int>(start + num_expired);
+
+        if (by_range) {
+            AvlTree_remove_range(&tree, &lo, &hi, int_node_het_compare, nullptr);
+        } else {
+            for (int key = lo; key < hi; ++key) {
+                AvlTree_remove(&tree, &key, int_node_het_compare, nullptr);
+            }
+        }
+
+        for (int key = lo; key < hi; ++key) {
+            AvlTree_insert(&tree, &nodes[static_cast<std::size_t>(key)]);
+        }
+
+        start = (start + num_expired) % (num_nodes - num_expired);
+
+        return tree.len;
+    });
+
+    AvlTree_drop(&tree);
+}
+
+} // namespace
+
+TEST_CASE("remove and reinsert") {
+    BENCHMARK_ADVANCED("1024 nodes")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Removal::ByKey, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, parents")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Removal::ByKeyWithParents, meter);
+    };
+
+    BENCHMARK_ADVANCED("1024 nodes, AvlTree_remove_node")(Catch::Benchmark::Chronometer meter) {
+        churn(1024, Removal::ByNode, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes")(Catch::Benchmark::Chronometer meter) {
+        churn(65536, Removal::ByKey, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, parents")(Catch::Benchmark::Chronometer meter) {
+        churn(65536, Removal::ByKeyWithParents, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, AvlTree_remove_node")(Catch::Benchmark::Chronometer meter) {
+        churn(65536, Removal::ByNode, meter);
+    };
+}
+
+TEST_CASE("expire a range and reinsert it") {
+    BENCHMARK_ADVANCED("65536 nodes, 4096 expired, AvlTree_remove")(Catch::Benchmark::Chronometer meter) {
+        expire(65536, 4096, false, meter);
+    };
+
+    BENCHMARK_ADVANCED("65536 nodes, 4096 expired, AvlTree_remove_range")(Catch::Benchmark::Chronometer meter) {
+        expire(65536, 4096, true, meter);
+    };
+}
@@ -34,12 +34,55 @@
  *  intrusive nodes.
  */
 
+#include <limits.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ *  Upper bound on the height of any AvlTree.
+ *
+ *  An AVL tree of height h contains at least F(h + 2) - 1 nodes, where
+ *  F(n) is the nth Fibonacci number. A tree of height 92 would need
+ *  more than 2^64 nodes, so 96 levels is enough for any tree that can
+ *  be addressed.
+ */
+#define AVL_MAX_HEIGHT 96
+
+/* marks functions that may go unused, such as those defined by AVL_DEFINE_TREE */
+#ifdef __GNUC__
+#define AVL_UNUSED __attribute__((unused))
+#else
+#define AVL_UNUSED
+#endif
+
+/*
+ *  Read accessors for the links of an AvlNode.
+ *
+ *  If AVL_TAGGED_NODES is defined when building the library and every
+ *  program that includes this header, AvlNode has no balance_factor
+ *  member. The balance factor is instead stored in the low bits of the
+ *  left and right pointers, which shrinks AvlNode from three words to
+ *  two, and nodes must be aligned to at least four bytes. Code that
+ *  reads the children of nodes, such as an AvlAugmenter, should use
+ *  these macros so that it works with either layout. Zero-initialized
+ *  nodes have no children and a balance factor of zero in both.
+ */
+#ifdef AVL_TAGGED_NODES
+#define AVL_NODE_TAG_MASK ((size_t) 3)
+#define AVL_NODE_LEFT(N) ((AvlNode*) ((size_t) (N)->left & ~AVL_NODE_TAG_MASK))
+#define AVL_NODE_RIGHT(N) ((AvlNode*) ((size_t) (N)->right & ~AVL_NODE_TAG_MASK))
+#define AVL_NODE_BALANCE_FACTOR(N) \
+    ((int) (((size_t) (N)->left & 3) | (((size_t) (N)->right & 1) << 2)) \
+     - ((((size_t) (N)->right & 1) != 0) ? 8 : 0))
+#else
+#define AVL_NODE_LEFT(N) ((N)->left)
+#define AVL_NODE_RIGHT(N) ((N)->right)
+#define AVL_NODE_BALANCE_FACTOR(N) ((int) (N)->balance_factor)
+#endif
+
 /**
  *  AVL self-balancing binary search tree.
  *
@@ -69,10 +112,13 @@ typedef struct AvlTree AvlTree;
  *  } Node;
  *
  *  AvlTree map;
- *  Node n = {{NULL, NULL, 0}, "Hello, world!", 42};
+ *  Node n = {{0}, "Hello, world!", 42};
  *  Node *const previous = (Node*) AvlTree_insert(&map, &n.node);
  *  @endcode
  *
+ *  The {0} initializer zeroes every member of AvlNode, so it is valid
+ *  whether or not AVL_TAGGED_NODES is defined.
+ *
  *  In C, I recommend placing the AvlNode as the first member of your
  *  struct to ensure that casting between your own node types and
  *  AvlNode is valid. You can put the AvlNode member at a different
@@ -97,21 +143,259 @@ typedef struct AvlTree AvlTree;
  */
 typedef struct AvlNode AvlNode;
 
+/**
+ *  Intrusive AVL tree node that also records the size of its subtree.
+ *
+ *  Trees that track sizes with AvlTree_enable_sizes must be built out
+ *  of AvlSizedNodes instead of AvlNodes, which enables O(log n) rank
+ *  and select queries. The AvlNode member must be first so that
+ *  pointers to it can be converted to and from pointers to the
+ *  AvlSizedNode.
+ *
+ *  @code{.c}
+ *  typedef struct Node {
+ *      AvlSizedNode node;
+ *      const char *key;
+ *      int value;
+ *  } Node;
+ *  @endcode
+ */
+typedef struct AvlSizedNode AvlSizedNode;
+
+/**
+ *  Intrusive AVL tree node that also links to its parent.
+ *
+ *  Trees that track parents with AvlTree_enable_parents must be built
+ *  out of AvlParentNodes instead of AvlNodes. They support stepping
+ *  from a node to its neighbors with AvlTree_next and AvlTree_prev and
+ *  removing a node with AvlTree_remove_node, none of which compare
+ *  anything. The AvlNode member must be first so that pointers to it
+ *  can be converted to and from pointers to the AvlParentNode.
+ */
+typedef struct AvlParentNode AvlParentNode;
+
+/**
+ *  Bidirectional in-order cursor over an AvlTree.
+ *
+ *  AvlCursor keeps the path from the root to its current node in a
+ *  fixed-size buffer, so moving it never allocates. A cursor is either
+ *  positioned at a node or at the "end" of the tree, a position that
+ *  sits both after the last node and before the first one.
+ *
+ *  Cursors positioned at a node are invalidated by any operation that
+ *  modifies the tree they point into; a cursor at the end stays valid.
+ *
+ *  @code{.c}
+ *  AvlCursor cursor;
+ *  const AvlNode *node;
+ *
+ *  AvlCursor_new(&cursor, &map);
+ *
+ *  for (node = AvlCursor_first(&cursor); node; node = AvlCursor_next(&cursor)) {
+ *      printf("%s\n", ((const Node*) node)->key);
+ *  }
+ *  @endcode
+ */
+typedef struct AvlCursor AvlCursor;
+
+/**
+ *  Position in an AvlTree found by a single search for a key.
+ *
+ *  AvlEntry records the path walked by AvlTree_entry, so the node that
+ *  compared equal to the key can be modified, replaced or removed, or
+ *  a new node linked where the key belongs, without searching again.
+ *
+ *  An entry is invalidated by any operation that modifies its tree,
+ *  except replacing its node with AvlEntry_insert.
+ *
+ *  @code{.c}
+ *  AvlEntry entry;
+ *  Counter *counter = (Counter*) AvlTree_entry(&counts, key, compare, NULL, &entry);
+ *
+ *  if (!counter) {
+ *      AvlEntry_insert(&entry, &make_counter(key)->node);
+ *  } else if (--counter->count == 0) {
+ *      free(AvlEntry_remove(&entry));
+ *  }
+ *  @endcode
+ */
+typedef struct AvlEntry AvlEntry;
+
+/**
+ *  Pool of fixed-size nodes allocated from large chunks.
+ *
+ *  Nodes are handed out by bumping a pointer through the newest chunk
+ *  and are recycled through a free list, so consecutively allocated
+ *  nodes sit next to each other in memory. Trees whose deleter is
+ *  AvlNodePool_deleter and that own every node in their pool are
+ *  cleared in time proportional to the number of chunks rather than
+ *  the number of nodes.
+ *
+ *  @code{.c}
+ *  AvlNodePool pool;
+ *  AvlTree map;
+ *  Node *n;
+ *
+ *  AvlNodePool_new(&pool, sizeof(Node), 0);
+ *  AvlTree_new(&map, compare, NULL, AvlNodePool_deleter, &pool);
+ *
+ *  n = (Node*) AvlNodePool_alloc(&pool);
+ *  ...
+ *  AvlTree_drop(&map);
+ *  AvlNodePool_drop(&pool);
+ *  @endcode
+ */
+typedef struct AvlNodePool AvlNodePool;
+
+/**
+ *  Bump allocator for nodes that are all freed at once.
+ *
+ *  Unlike AvlNodePool, nodes may have different sizes and cannot be
+ *  freed individually. Trees created with AvlTree_new_in_arena never
+ *  visit their nodes when cleared or dropped, so a tree can be thrown
+ *  away in O(1) time and its memory reclaimed by resetting the arena.
+ *
+ *  @code{.c}
+ *  AvlArena arena;
+ *  AvlTree index;
+ *
+ *  AvlArena_new(&arena, 0);
+ *  AvlTree_new_in_arena(&index, compare, NULL, &arena);
+ *  ...
+ *  AvlTree_drop(&index);
+ *  AvlArena_reset(&arena);
+ *  @endcode
+ */
+typedef struct AvlArena AvlArena;
+
+/**
+ *  AVL tree over the elements of a caller-owned array, linked by
+ *  32-bit indices.
+ *
+ *  Each element has a corresponding AvlIndexNode in an array supplied
+ *  to AvlIndexTree_new; element i is linked through nodes[i]. The
+ *  balance factor is packed into the top bit of each link, so every
+ *  node costs 8 bytes instead of the 24 that an AvlNode takes on
+ *  LP64 platforms. Keys and values live wherever the caller keeps
+ *  them, and comparators receive indices instead of nodes.
+ *
+ *  @code{.c}
+ *  int keys[1000];
+ *  AvlIndexNode nodes[1000];
+ *  AvlIndexTree index;
+ *
+ *  AvlIndexTree_new(&index, nodes, compare_keys, keys);
+ *  AvlIndexTree_insert(&index, 0);
+ *  @endcode
+ */
+typedef struct AvlIndexTree AvlIndexTree;
+
+/**
+ *  Link storage for one element of an AvlIndexTree.
+ */
+typedef struct AvlIndexNode AvlIndexNode;
+
+/**
+ *  Read-only snapshot of the keys of an AvlTree, laid out for fast
+ *  searching.
+ *
+ *  AvlTree_freeze copies each node's key into one contiguous array in
+ *  Eytzinger order, the order of a breadth-first traversal of a
+ *  complete binary search tree. The first levels of every search share
+ *  a handful of cache lines, and the children of the element at index
+ *  i sit at 2i and 2i + 1, so they can be prefetched before they are
+ *  needed. Searches return the original nodes.
+ *
+ *  @code{.c}
+ *  AvlFrozenTree frozen;
+ *  const AvlNode *node;
+ *
+ *  AvlTree_freeze(&tree, &frozen, sizeof(int), extract_int, NULL);
+ *  node = AvlFrozenTree_get(&frozen, &key, compare_ints, NULL);
+ *  AvlFrozenTree_drop(&frozen);
+ *  @endcode
+ */
+typedef struct AvlFrozenTree AvlFrozenTree;
+
+/**
+ *  Read-only snapshot of an AvlTree keyed by integers, laid out as a
+ *  static B-tree of 16-key blocks.
+ *
+ *  Each block fills one 64-byte cache line, so a search touches about
+ *  a quarter as many lines as a binary search does. The keys of a
+ *  block are compared to the search key all at once with AVX2 or SSE2
+ *  where the processor supports them, which is checked at run time,
+ *  and one at a time otherwise.
+ *
+ *  @code{.c}
+ *  AvlFrozenIntTree frozen;
+ *  const AvlNode *node;
+ *
+ *  AvlTree_freeze_ints(&tree, &frozen, node_key, NULL);
+ *  node = AvlFrozenIntTree_get(&frozen, 42);
+ *  AvlFrozenIntTree_drop(&frozen);
+ *  @endcode
+ */
+typedef struct AvlFrozenIntTree AvlFrozenIntTree;
+
+/* signed integer type that holds at least 32 bits */
+#if INT_MAX >= 0x7fffffffL
+typedef int AvlIntKey;
+#define AVL_INT_KEY_MAX INT_MAX
+#else
+typedef long AvlIntKey;
+#define AVL_INT_KEY_MAX LONG_MAX
+#endif
+
+/* unsigned integer type that holds at least 32 bits */
+#if UINT_MAX >= 0xffffffffUL
+typedef unsigned int AvlIndex;
+#else
+typedef unsigned long AvlIndex;
+#endif
+
+/* the largest index an AvlIndexTree can hold */
+#define AVL_INDEX_MAX ((AvlIndex) 0x7ffffffeUL)
+
+/* returned by AvlIndexTree functions when there is no such element */
+#define AVL_INDEX_NIL ((AvlIndex) 0x7fffffffUL)
+
 /* int compare(const AvlNode *lhs, const AvlNode *rhs, void *arg); */
 typedef int (*AvlComparator)(const AvlNode*, const AvlNode*, void*);
 
 /* int compare(const void *lhs, const AvlNode *rhs, void *arg); */
 typedef int (*AvlHetComparator)(const void*, const AvlNode*, void*);
 
-/* void traverse(void *context, const AvlNode *node); */
-typedef void (*AvlTraverseCb)(void*, const AvlNode*);
+/* int traverse(void *context, const AvlNode *node); nonzero stops */
+typedef int (*AvlTraverseCb)(void*, const AvlNode*);
 
-/* void traverse_mut(void *context, AvlNode *node); */
-typedef void (*AvlTraverseMutCb)(void*, AvlNode*);
+/* int traverse_mut(void *context, AvlNode *node); nonzero stops */
+typedef int (*AvlTraverseMutCb)(void*, AvlNode*);
 
 /* void delete(AvlNode *node, void *arg); */
 typedef void (*AvlDeleter)(AvlNode*, void*);
 
+/* void augment(AvlNode *node, void *arg); recomputes node's aggregate */
+typedef void (*AvlAugmenter)(AvlNode*, void*);
+
+/* int compare(AvlIndex lhs, AvlIndex rhs, void *arg); */
+typedef int (*AvlIndexComparator)(AvlIndex, AvlIndex, void*);
+
+/* int compare(const void *lhs, AvlIndex rhs, void *arg); */
+typedef int (*AvlIndexHetComparator)(const void*, AvlIndex, void*);
+
+/* int traverse(void *context, AvlIndex index); nonzero stops */
+typedef int (*AvlIndexTraverseCb)(void*, AvlIndex);
+
+/* void extract(const AvlNode *node, void *key, void *arg); writes node's key to key */
+typedef void (*AvlKeyExtractor)(const AvlNode*, void*, void*);
+
+/* int compare(const void *lhs, const void *rhs, void *arg); compares a key to a frozen key */
+typedef int (*AvlKeyComparator)(const void*, const void*, void*);
+
+/* AvlIntKey extract(const AvlNode *node, void *arg); */
+typedef AvlIntKey (*AvlIntKeyExtractor)(const AvlNode*, void*);
+
 /**
  *  Initializes an empty AvlTree.
  *
@@ -127,6 +411,97 @@ typedef void (*AvlDeleter)(AvlNode*, void*);
 void AvlTree_new(AvlTree *self, AvlComparator compare, void *compare_arg,
                  AvlDeleter deleter, void *deleter_arg);
 
+/**
+ *  Initializes an empty AvlTree whose nodes all belong to an arena.
+ *
+ *  The tree never frees its nodes: removed and replaced nodes are left
+ *  to the arena, and clearing or dropping the tree runs in O(1) time.
+ *  Equivalent to AvlTree_new with AvlArena_deleter as the deleter.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param compare Must not be NULL. Will be invoked to compare nodes
+ *                 by compare(lhs, rhs, compare_arg).
+ *  @param arena The allocator that owns every node. Need not be an
+ *               AvlArena; it is only recorded as the deleter argument.
+ */
+void AvlTree_new_in_arena(AvlTree *self, AvlComparator compare, void *compare_arg,
+                          void *arena);
+
+/**
+ *  Makes an AvlTree keep track of the size of each subtree.
+ *
+ *  Trees that track sizes support AvlTree_select and AvlTree_rank.
+ *  Every node inserted into the tree must be the AvlNode member of an
+ *  AvlSizedNode.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *              Must not track parents.
+ */
+void AvlTree_enable_sizes(AvlTree *self);
+
+/**
+ *  Makes an AvlTree keep a link from each node to its parent.
+ *
+ *  Trees that track parents support AvlTree_next, AvlTree_prev and
+ *  AvlTree_remove_node. Every node inserted into the tree must be the
+ *  AvlNode member of an AvlParentNode. A tree cannot track both sizes
+ *  and parents.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *              Must not track sizes.
+ */
+void AvlTree_enable_parents(AvlTree *self);
+
+/**
+ *  Makes an AvlTree keep pointers to its first and last nodes.
+ *
+ *  AvlTree_first and AvlTree_last then run in O(1) time instead of
+ *  walking a spine of the tree. Keeping the pointers costs a pointer
+ *  comparison per insertion and a walk down one spine whenever the
+ *  first or last node is removed.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlTree_enable_extremes(AvlTree *self);
+
+/**
+ *  Makes an AvlTree maintain a user-defined aggregate on each node.
+ *
+ *  Whenever the children of a node change, the tree recomputes that
+ *  node's aggregate by calling augment(node, augment_arg). When augment
+ *  is called, the aggregates of node's children are up to date, so
+ *  augment can combine them with node's own value to summarize the
+ *  whole subtree: sums, minima and maxima, interval endpoints, and so
+ *  on. The aggregate is stored in the user's node type.
+ *
+ *  @code{.c}
+ *  typedef struct Node {
+ *      AvlNode node;
+ *      int key;
+ *      long value;
+ *      long sum;
+ *  } Node;
+ *
+ *  static void sum_values(AvlNode *node, void *arg) {
+ *      Node *const n = (Node*) node;
+ *
+ *      n->sum = n->value;
+ *
+ *      if (AVL_NODE_LEFT(node)) {
+ *          n->sum += ((Node*) AVL_NODE_LEFT(node))->sum;
+ *      }
+ *
+ *      if (AVL_NODE_RIGHT(node)) {
+ *          n->sum += ((Node*) AVL_NODE_RIGHT(node))->sum;
+ *      }
+ *  }
+ *  @endcode
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param augment If NULL, no aggregate is maintained.
+ */
+void AvlTree_set_augmenter(AvlTree *self, AvlAugmenter augment, void *augment_arg);
+
 /**
  *  Drops an AvlTree, removing all members.
  *
@@ -159,6 +534,30 @@ const AvlNode* AvlTree_get(const AvlTree *self, const void *key,
  */
 AvlNode* AvlTree_get_mut(AvlTree *self, const void *key, AvlHetComparator compare, void *arg);
 
+/**
+ *  Looks up many keys at once.
+ *
+ *  Up to 16 searches descend the tree together. Each time one of them
+ *  steps to a child, that child is prefetched and the other searches
+ *  take their next steps before it is compared, so the cache misses of
+ *  different searches overlap instead of happening one after another.
+ *  A finished search is replaced by the next key. This pays off for
+ *  trees too large for the cache; small trees are searched faster by
+ *  calling AvlTree_get in a loop.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param keys Must not be NULL unless n is 0. Must hold n keys.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(keys[i], node, arg).
+ *  @param found Must not be NULL unless n is 0. Must have room for n
+ *               elements. found[i] will be set to the node that
+ *               compares equal to keys[i], or NULL if there is none.
+ */
+void AvlTree_get_batch(const AvlTree *self, const void *const *keys, size_t n,
+                       AvlHetComparator compare, void *arg, const AvlNode **found);
+
 /**
  *  Inserts an element into an AvlTree.
  *
@@ -191,6 +590,72 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
                                void *compare_arg, AvlNode* (*insert)(const void*, void*),
                                void *insert_arg, int *inserted);
 
+/**
+ *  Links an array of nodes into a perfectly balanced tree.
+ *
+ *  Runs in O(n) time and touches each node exactly once, without
+ *  calling the comparator.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param nodes Must not be NULL if n > 0. Must be sorted in strictly
+ *               increasing order according to the tree's comparator.
+ */
+void AvlTree_build_sorted(AvlTree *self, AvlNode **nodes, size_t n);
+
+/**
+ *  Links a stream of nodes into a perfectly balanced tree.
+ *
+ *  Equivalent to AvlTree_build_sorted, but pulls nodes one at a time
+ *  so that they need not be collected into an array first.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param n The number of nodes in the stream.
+ *  @param next Must not be NULL. Will be invoked exactly n times by
+ *              next(next_arg) to obtain the nodes in strictly
+ *              increasing order according to the tree's comparator.
+ */
+void AvlTree_build_sorted_iter(AvlTree *self, size_t n, AvlNode* (*next)(void*),
+                               void *next_arg);
+
+/**
+ *  Inserts a sorted array of nodes into an AvlTree.
+ *
+ *  Each search resumes from the deepest node on the previous search
+ *  path whose subtree can still hold the next node, rather than from
+ *  the root, so a batch of n nodes makes about n log(len/n) comparator
+ *  calls instead of n log(len). A run of consecutive nodes that all
+ *  fall between the same two nodes of the tree is linked into a
+ *  balanced subtree and joined in, so the tree is rebalanced once per
+ *  run rather than once per node. A batch at least twice as large as
+ *  the tree is instead built into a tree of its own and merged in with
+ *  AvlTree_union.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              compares equal to one in nodes is replaced by it and
+ *              passed to the deleter.
+ *  @param nodes Must not be NULL if n > 0. Must be sorted in strictly
+ *               increasing order according to the tree's comparator.
+ *               None of them may be in the tree.
+ */
+void AvlTree_insert_sorted_batch(AvlTree *self, AvlNode **nodes, size_t n);
+
+/**
+ *  Recomputes the aggregates on the path to the node that compares
+ *  equal to a key.
+ *
+ *  Call this after modifying a node in a way that changes the
+ *  aggregate computed from it, such as changing its value through
+ *  AvlTree_get_mut.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The node that compares equal to key, if there is one.
+ */
+AvlNode* AvlTree_refresh(AvlTree *self, const void *key, AvlHetComparator compare, void *arg);
+
 /**
  *  Removes the node that compares equal to a key.
  *
@@ -204,79 +669,1247 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
 AvlNode* AvlTree_remove(AvlTree *self, const void *key, AvlHetComparator compare, void *arg);
 
 /**
- *  Clears the tree, removing all members.
+ *  Inserts a node at a position found by searching the tree yourself.
+ *
+ *  This is the comparison-free half of AvlTree_insert, for code that
+ *  descends the tree on its own, such as the functions generated by
+ *  AVL_DEFINE_TREE. Runs in O(log n) time and makes no comparator
+ *  calls.
  *
  *  @param self Must not be NULL. Must be initialized.
+ *  @param path Must not be NULL unless depth is 0. path[0] must be the
+ *              root and each following node a child of the one before
+ *              it. If ordering is nonzero, the child of
+ *              path[depth - 1] on the side given by ordering must be
+ *              NULL.
+ *  @param depth The number of nodes in path. Must be 0 if and only if
+ *               self is empty.
+ *  @param ordering The result of comparing node to path[depth - 1].
+ *                  If 0, node takes its place in the tree. Ignored if
+ *                  depth is 0.
+ *  @param node Must not be NULL. Must not be in the tree.
+ *  @returns The node that node replaced, if ordering was 0.
  */
-void AvlTree_clear(AvlTree *self);
+AvlNode* AvlTree_insert_at(AvlTree *self, AvlNode *const *path, size_t depth, int ordering,
+                           AvlNode *node);
 
 /**
- *  AVL self-balancing binary search tree.
+ *  Inserts an element into an AvlTree just before the position of a
+ *  cursor.
  *
- *  AVL trees maintain a strict "AVL condition": for each node,
- *  the heights of its subtrees never differ by more than one. This
- *  condition guarantees that the tree's height is upper-bounded by
- *  1.44 log2(n + 1.065) - 0.328, where n is the number of nodes in the
- *  tree. As such, insertion, removal, and searching are guaranteed to
- *  run in O(log n) worst case time.
+ *  If node belongs between the cursor's node and its predecessor, it
+ *  is linked there after at most two comparisons and the tree is
+ *  rebalanced along the path to it; otherwise this falls back to
+ *  AvlTree_insert. A cursor positioned at the end hints that node is
+ *  greater than every element, so appending increasing keys only
+ *  walks the right spine and compares against the last element. The
+ *  end position survives modifications, so one such cursor can be
+ *  reused for every append.
+ *
+ *  Runs in O(log n) time even when the hint is right. The cursor
+ *  saves comparisons, not pointer chasing. An end cursor holds no
+ *  path, so each append walks the right spine from the root and is
+ *  then rebalanced through AvlTree_insert_at. Appending increasing
+ *  keys one at a time is therefore about four times slower than
+ *  AvlTree_build_sorted. Prefer that, or
+ *  AvlTree_insert_sorted_batch, when the keys arrive together.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param hint Must not be NULL. Must be positioned in self.
+ *  @param node Must not be NULL.
+ *  @returns The previous element that compares equal to node, if there
+ *           was one.
  */
-struct AvlTree {
-    AvlNode *root;
-    size_t len;
-    AvlComparator compare;
-    void *compare_arg;
-    AvlDeleter deleter;
-    void *deleter_arg;
-};
+AvlNode* AvlTree_insert_hint(AvlTree *self, const AvlCursor *hint, AvlNode *node);
 
 /**
- *  Intrusive AVL tree node.
+ *  Removes a node at a position found by searching the tree yourself.
  *
- *  Users should create custom structs that have AvlNode as a member,
- *  such as by composition or inheritance (in C++). Although it may be
- *  tempting, users should not modify the contents of AvlNode in their
- *  own types. For example, the following is a node that holds a
- *  const char* key and an int value:
+ *  This is the comparison-free half of AvlTree_remove. Runs in
+ *  O(log n) time and makes no comparator calls.
  *
- *  @code{.c}
- *  typedef struct Node {
- *      AvlNode node;
- *      const char *key;
- *      int value;
- *  } Node;
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param path Must not be NULL. path[0] must be the root and each
+ *              following node a child of the one before it.
+ *  @param depth The number of nodes in path. Must be at least 1.
+ *  @returns path[depth - 1], which is no longer in the tree.
+ */
+AvlNode* AvlTree_remove_at(AvlTree *self, AvlNode *const *path, size_t depth);
+
+/**
+ *  Runs in O(1) time if the tree caches its extremes, otherwise in
+ *  O(log n) time. Makes no comparator calls.
  *
- *  AvlTree map;
- *  Node n = {{NULL, NULL, 0}, "Hello, world!", 42};
- *  Node *const previous = (Node*) AvlTree_insert(&map, &n.node);
- *  @endcode
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that compares less than every other node, if the
+ *           tree is not empty.
+ */
+const AvlNode* AvlTree_first(const AvlTree *self);
+
+/**
+ *  Runs in O(1) time if the tree caches its extremes, otherwise in
+ *  O(log n) time. Makes no comparator calls.
  *
- *  In C, I recommend placing the AvlNode as the first member of your
- *  struct to ensure that casting between your own node types and
- *  AvlNode is valid. You can put the AvlNode member at a different
- *  spot if you want to, but you'll have to use offsetof() to convert
- *  between pointer types.
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that compares greater than every other node, if
+ *           the tree is not empty.
+ */
+const AvlNode* AvlTree_last(const AvlTree *self);
+
+/**
+ *  Removes the first node of an AvlTree.
  *
- *  This is a similar example using inheritance in C++ to allow for
- *  easy use of static_cast:
+ *  Walks the left spine and rebalances along it, making no comparator
+ *  calls. The node is not passed to the deleter.
  *
- *  @code{.cpp}
- *  struct Node : AvlNode {
- *      Node(std::string k, int v) : key(std::move(k)), value(v) { }
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that was removed, or NULL if the tree was empty.
+ */
+AvlNode* AvlTree_pop_first(AvlTree *self);
+
+/**
+ *  Removes the last node of an AvlTree.
  *
- *      std::string key;
- *      int value;
- *  }
+ *  Walks the right spine and rebalances along it, making no comparator
+ *  calls. The node is not passed to the deleter.
  *
- *  AvlTree map;
- *  Node n("Hello, world!", 42);
- *  const auto previous = static_cast<Node*>(AvlTree_insert(&map, &n));
- *  @endcode
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that was removed, or NULL if the tree was empty.
  */
-struct AvlNode {
-    AvlNode *left;
-    AvlNode *right;
-    signed char balance_factor; /* one of {-2, -1, 0, 1, -2} */
-};
+AvlNode* AvlTree_pop_last(AvlTree *self);
+
+/**
+ *  Searches an AvlTree for a key, recording the path to where it
+ *  belongs.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param entry Must not be NULL. Will be initialized and positioned
+ *               at the returned node, or where key would be inserted
+ *               if NULL is returned.
+ *  @returns The node that compares equal to key, if there is one.
+ */
+AvlNode* AvlTree_entry(AvlTree *self, const void *key, AvlHetComparator compare, void *arg,
+                       AvlEntry *entry);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the entry is positioned at, or NULL if it is
+ *           positioned where a node is missing.
+ */
+const AvlNode* AvlEntry_get(const AvlEntry *self);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A mutable pointer to the node the entry is positioned at,
+ *           or NULL if it is positioned where a node is missing.
+ */
+AvlNode* AvlEntry_get_mut(AvlEntry *self);
+
+/**
+ *  Inserts a node at the position of an entry.
+ *
+ *  If the entry is positioned at a node, node takes its place and the
+ *  entry is moved to node. Otherwise node is linked where the entry
+ *  was positioned and the tree is rebalanced, invalidating the entry.
+ *  Makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param node Must not be NULL. Must not be in the tree. Must compare
+ *              equal to the key that was searched for.
+ *  @returns The node that node replaced, if there was one. It is not
+ *           passed to the deleter.
+ */
+AvlNode* AvlEntry_insert(AvlEntry *self, AvlNode *node);
+
+/**
+ *  Removes the node an entry is positioned at.
+ *
+ *  Rebalances the tree along the recorded path, making no comparator
+ *  calls. The entry is invalidated.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be
+ *              positioned at a node.
+ *  @returns The node that was removed. It is not passed to the
+ *           deleter.
+ */
+AvlNode* AvlEntry_remove(AvlEntry *self);
+
+/**
+ *  Clears the tree, removing all members.
+ *
+ *  Runs in O(1) time if the deleter is AvlArena_deleter. If the
+ *  deleter is AvlNodePool_deleter and every node in the pool belongs
+ *  to this tree, the pool is reset instead of visiting each node.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlTree_clear(AvlTree *self);
+
+/**
+ *  Initializes an AvlCursor positioned at the end of a tree.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param tree Must not be NULL. Must be initialized. Must outlive
+ *              self.
+ */
+void AvlCursor_new(AvlCursor *self, const AvlTree *tree);
+
+/**
+ *  Moves an AvlCursor to the first node of its tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The first node of the tree, if there is one. Otherwise the
+ *           cursor is positioned at the end and NULL is returned.
+ */
+const AvlNode* AvlCursor_first(AvlCursor *self);
+
+/**
+ *  Moves an AvlCursor to the last node of its tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The last node of the tree, if there is one. Otherwise the
+ *           cursor is positioned at the end and NULL is returned.
+ */
+const AvlNode* AvlCursor_last(AvlCursor *self);
+
+/**
+ *  Moves an AvlCursor to the in-order successor of its current node.
+ *
+ *  If the cursor is positioned at the end, it is moved to the first
+ *  node of the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor was moved to, or NULL if the cursor
+ *           was moved to the end.
+ */
+const AvlNode* AvlCursor_next(AvlCursor *self);
+
+/**
+ *  Moves an AvlCursor to the in-order predecessor of its current node.
+ *
+ *  If the cursor is positioned at the end, it is moved to the last
+ *  node of the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor was moved to, or NULL if the cursor
+ *           was moved to the end.
+ */
+const AvlNode* AvlCursor_prev(AvlCursor *self);
+
+/**
+ *  Moves an AvlCursor to the node that compares equal to a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The node that compares equal to key, if there is one.
+ *           Otherwise the cursor is positioned at the end and NULL is
+ *           returned.
+ */
+const AvlNode* AvlCursor_seek(AvlCursor *self, const void *key,
+                              AvlHetComparator compare, void *arg);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor is positioned at, or NULL if it is
+ *           positioned at the end.
+ */
+const AvlNode* AvlCursor_get(const AvlCursor *self);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A mutable pointer to the node the cursor is positioned at,
+ *           or NULL if it is positioned at the end.
+ */
+AvlNode* AvlCursor_get_mut(AvlCursor *self);
+
+/**
+ *  Finds the first node that does not compare less than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than or equal to
+ *           key, if there is one.
+ */
+const AvlNode* AvlTree_lower_bound(const AvlTree *self, const void *key,
+                                   AvlHetComparator compare, void *arg, AvlCursor *cursor);
+
+/**
+ *  Finds the first node that compares greater than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than key, if there
+ *           is one.
+ */
+const AvlNode* AvlTree_upper_bound(const AvlTree *self, const void *key,
+                                   AvlHetComparator compare, void *arg, AvlCursor *cursor);
+
+/**
+ *  Finds the last node that does not compare greater than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The last node that compares less than or equal to key, if
+ *           there is one.
+ */
+const AvlNode* AvlTree_floor(const AvlTree *self, const void *key,
+                             AvlHetComparator compare, void *arg, AvlCursor *cursor);
+
+/**
+ *  Finds the first node that does not compare less than a key.
+ *
+ *  Equivalent to AvlTree_lower_bound.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than or equal to
+ *           key, if there is one.
+ */
+const AvlNode* AvlTree_ceiling(const AvlTree *self, const void *key,
+                               AvlHetComparator compare, void *arg, AvlCursor *cursor);
+
+/**
+ *  Visits, in order, each node in the half-open range [lo, hi).
+ *
+ *  Only the nodes inside the range and the O(log n) nodes on the path
+ *  to the first of them are touched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @param traverse Must not be NULL. Will be invoked on each node in
+ *                  the range by traverse(context, node). If it returns
+ *                  nonzero, the scan stops.
+ *  @returns The nonzero value returned by traverse if it stopped the
+ *           scan, otherwise 0.
+ */
+int AvlTree_range(const AvlTree *self, const void *lo, const void *hi,
+                  AvlHetComparator compare, void *arg, AvlTraverseCb traverse, void *context);
+
+/**
+ *  Visits, in order, each node in the half-open range [lo, hi).
+ *
+ *  Only the nodes inside the range and the O(log n) nodes on the path
+ *  to the first of them are touched. traverse must not modify nodes
+ *  in a way that changes their ordering.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @param traverse Must not be NULL. Will be invoked on each node in
+ *                  the range by traverse(context, node). If it returns
+ *                  nonzero, the scan stops.
+ *  @returns The nonzero value returned by traverse if it stopped the
+ *           scan, otherwise 0.
+ */
+int AvlTree_range_mut(AvlTree *self, const void *lo, const void *hi,
+                      AvlHetComparator compare, void *arg, AvlTraverseMutCb traverse,
+                      void *context);
+
+/**
+ *  Finds the node at a given position in the in-order sequence.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track sizes.
+ *  @param index The zero-based position of the node to find.
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The node that has exactly index nodes before it, if
+ *           index < self->len.
+ */
+const AvlNode* AvlTree_select(const AvlTree *self, size_t index, AvlCursor *cursor);
+
+/**
+ *  Counts the nodes that compare less than a key.
+ *
+ *  If a node compares equal to key, this is its zero-based position
+ *  in the in-order sequence.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track sizes.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The number of nodes that compare less than key.
+ */
+size_t AvlTree_rank(const AvlTree *self, const void *key, AvlHetComparator compare,
+                    void *arg);
+
+/**
+ *  Finds the in-order successor of a node.
+ *
+ *  Runs in O(1) amortized time and makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ *  @returns The first node that compares greater than node, if there
+ *           is one.
+ */
+const AvlNode* AvlTree_next(const AvlTree *self, const AvlNode *node);
+
+/**
+ *  Finds the in-order predecessor of a node.
+ *
+ *  Runs in O(1) amortized time and makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ *  @returns The last node that compares less than node, if there is
+ *           one.
+ */
+const AvlNode* AvlTree_prev(const AvlTree *self, const AvlNode *node);
+
+/**
+ *  Removes a node from an AvlTree without searching for it.
+ *
+ *  The path to node is found by following parent links, so this runs
+ *  in O(log n) time and makes no comparator calls. The node is not
+ *  passed to the deleter.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ */
+void AvlTree_remove_node(AvlTree *self, AvlNode *node);
+
+/**
+ *  Splits an AvlTree into the nodes that compare less than a key and
+ *  the nodes that do not.
+ *
+ *  Runs in O(log n) time if the tree tracks sizes. Otherwise, the
+ *  nodes of the smaller half are counted to find the length of each
+ *  half, which takes O(log n + min(|left|, |right|)) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Will be left
+ *              empty unless it is also left or right.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param left Must not be NULL. Will be initialized with the same
+ *              configuration as self and hold every node that compares
+ *              less than key. May be self.
+ *  @param right Must not be NULL. Will be initialized with the same
+ *               configuration as self and hold every node that
+ *               compares greater than or equal to key. May be self if
+ *               left is not.
+ */
+void AvlTree_split(AvlTree *self, const void *key, AvlHetComparator compare, void *arg,
+                   AvlTree *left, AvlTree *right);
+
+/**
+ *  Joins two AvlTrees and a pivot node into one AvlTree.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param left Must not be NULL. Must be initialized. Every node in
+ *              left must compare less than pivot. Will hold every node
+ *              from left and right, as well as pivot.
+ *  @param pivot Must not be NULL. Must not be in left or right.
+ *  @param right Must not be NULL. Must be initialized with the same
+ *               configuration as left. Every node in right must compare
+ *               greater than pivot. Will be left empty.
+ */
+void AvlTree_join(AvlTree *left, AvlNode *pivot, AvlTree *right);
+
+/**
+ *  Concatenates two AvlTrees.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param left Must not be NULL. Must be initialized. Every node in
+ *              left must compare less than every node in right. Will
+ *              hold every node from left and right.
+ *  @param right Must not be NULL. Must be initialized with the same
+ *               configuration as left. Will be left empty.
+ */
+void AvlTree_concat(AvlTree *left, AvlTree *right);
+
+/**
+ *  Removes every node in the half-open range [lo, hi).
+ *
+ *  The range is cut out with two splits and one join, and its nodes
+ *  are then passed to the deleter in a single sweep that neither
+ *  rebalances nor allocates. Runs in O(log n + k) time, where k is the
+ *  number of nodes removed, and makes O(log n) comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @returns The number of nodes that were removed.
+ */
+size_t AvlTree_remove_range(AvlTree *self, const void *lo, const void *hi,
+                            AvlHetComparator compare, void *arg);
+
+/**
+ *  Moves every node from other into self.
+ *
+ *  Runs in O(m log(n/m + 1)) time, where m is the length of the
+ *  smaller tree and n the length of the larger tree.
+ *
+ *  @param self Must not be NULL. Must be initialized. Will hold every
+ *              node from self and every node from other that does not
+ *              compare equal to a node in self.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               that compares equal to a node in self will be passed
+ *               to other's deleter. Will be left empty.
+ */
+void AvlTree_union(AvlTree *self, AvlTree *other);
+
+/**
+ *  Removes every node from self that does not compare equal to a node
+ *  in other.
+ *
+ *  Makes O(m log(n/m + 1)) comparisons, where m is the length of the
+ *  smaller tree and n the length of the larger tree. Every node of
+ *  other and every unmatched node of self is passed to a deleter, so
+ *  it runs in O(m + n) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              does not compare equal to a node in other will be
+ *              passed to self's deleter.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               will be passed to other's deleter. Will be left empty.
+ */
+void AvlTree_intersection(AvlTree *self, AvlTree *other);
+
+/**
+ *  Removes every node from self that compares equal to a node in
+ *  other.
+ *
+ *  Makes O(m log(n/m + 1)) comparisons, where m is the length of the
+ *  smaller tree and n the length of the larger tree. Every node of
+ *  other is passed to its deleter, so it runs in
+ *  O(m log(n/m + 1) + |other|) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              compares equal to a node in other will be passed to
+ *              self's deleter.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               will be passed to other's deleter. Will be left empty.
+ */
+void AvlTree_difference(AvlTree *self, AvlTree *other);
+
+/**
+ *  Equivalent to AvlTree_union, but merges independent subtrees on up
+ *  to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_union.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_union_parallel(AvlTree *self, AvlTree *other, size_t num_threads);
+
+/**
+ *  Equivalent to AvlTree_intersection, but merges independent
+ *  subtrees on up to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_intersection.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_intersection_parallel(AvlTree *self, AvlTree *other, size_t num_threads);
+
+/**
+ *  Equivalent to AvlTree_difference, but merges independent subtrees
+ *  on up to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_difference.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_difference_parallel(AvlTree *self, AvlTree *other, size_t num_threads);
+
+/**
+ *  Initializes an empty AvlNodePool.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param node_size Must be nonzero. The size of each node in bytes.
+ *  @param nodes_per_chunk The number of nodes to allocate at once. If
+ *                         0, chunks will be about 64 KiB.
+ */
+void AvlNodePool_new(AvlNodePool *self, size_t node_size, size_t nodes_per_chunk);
+
+/**
+ *  Drops an AvlNodePool, freeing every chunk.
+ *
+ *  Every node allocated from the pool becomes invalid.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlNodePool_drop(AvlNodePool *self);
+
+/**
+ *  Allocates a node from an AvlNodePool.
+ *
+ *  Runs in O(1) time. If a new chunk is needed and malloc() returns
+ *  NULL, a message is printed to stderr and abort() is called.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A pointer to uninitialized memory of at least the pool's
+ *           node size, aligned for any object type.
+ */
+void* AvlNodePool_alloc(AvlNodePool *self);
+
+/**
+ *  Returns a node to an AvlNodePool for reuse.
+ *
+ *  Runs in O(1) time.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param node Must not be NULL. Must have been returned by
+ *              AvlNodePool_alloc(self) and not freed since.
+ */
+void AvlNodePool_free(AvlNodePool *self, void *node);
+
+/**
+ *  Frees every node in an AvlNodePool at once.
+ *
+ *  Runs in O(c) time, where c is the number of chunks. The newest
+ *  chunk is kept for reuse.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlNodePool_reset(AvlNodePool *self);
+
+/**
+ *  AvlDeleter that returns nodes to the AvlNodePool passed as arg.
+ *
+ *  Nodes are not finalized in any other way. If they own resources,
+ *  use a deleter that releases them before calling AvlNodePool_free;
+ *  AvlTree_clear only skips its traversal for this exact deleter.
+ *
+ *  Like AvlNodePool_free, this is not thread-safe. The *_parallel set
+ *  operations merge on the calling thread only when they see this
+ *  deleter; a wrapper around it must not be passed to them.
+ *
+ *  @param node Must not be NULL. Must have been allocated from arg.
+ *  @param pool Must not be NULL. Must be an initialized AvlNodePool.
+ */
+void AvlNodePool_deleter(AvlNode *node, void *pool);
+
+/**
+ *  Initializes an empty AvlArena.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param chunk_size The number of bytes to allocate at once. If 0,
+ *                    chunks will be 64 KiB.
+ */
+void AvlArena_new(AvlArena *self, size_t chunk_size);
+
+/**
+ *  Drops an AvlArena, freeing every chunk.
+ *
+ *  Every node allocated from the arena becomes invalid.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlArena_drop(AvlArena *self);
+
+/**
+ *  Allocates memory from an AvlArena.
+ *
+ *  Runs in O(1) time. Allocations larger than a chunk get a chunk of
+ *  their own. If malloc() returns NULL, a message is printed to stderr
+ *  and abort() is called.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A pointer to uninitialized memory at least size bytes
+ *           long, aligned for any object type.
+ */
+void* AvlArena_alloc(AvlArena *self, size_t size);
+
+/**
+ *  Frees every allocation from an AvlArena at once.
+ *
+ *  Runs in O(c) time, where c is the number of chunks. The newest
+ *  chunk is kept for reuse.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlArena_reset(AvlArena *self);
+
+/**
+ *  AvlDeleter that does nothing, leaving nodes to be reclaimed with
+ *  the arena they were allocated from.
+ *
+ *  AvlTree_clear skips its traversal entirely for trees that use it.
+ */
+void AvlArena_deleter(AvlNode *node, void *arena);
+
+/**
+ *  Initializes an empty AvlIndexTree.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param nodes Must not be NULL. Must have an element for every index
+ *               that will be inserted. Must outlive self.
+ *  @param compare Must not be NULL. Will be invoked to compare
+ *                 elements by compare(lhs, rhs, compare_arg). Must
+ *                 form a total ordering over the inserted indices.
+ */
+void AvlIndexTree_new(AvlIndexTree *self, AvlIndexNode *nodes, AvlIndexComparator compare,
+                      void *compare_arg);
+
+/**
+ *  Removes every element from an AvlIndexTree in O(1) time.
+ *
+ *  The node array is owned by the caller, so nothing is freed.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlIndexTree_clear(AvlIndexTree *self);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one passed to
+ *                 AvlIndexTree_new. Will be invoked by
+ *                 compare(key, index, arg).
+ *  @returns The index of the element that compares equal to key, or
+ *           AVL_INDEX_NIL if there is none.
+ */
+AvlIndex AvlIndexTree_get(const AvlIndexTree *self, const void *key,
+                          AvlIndexHetComparator compare, void *arg);
+
+/**
+ *  Inserts an element into an AvlIndexTree.
+ *
+ *  If an element compares equal to index, index takes its place and
+ *  it is unlinked from the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param index Must not be greater than AVL_INDEX_MAX. Must not be
+ *               in the tree.
+ *  @returns The index of the element that compared equal to index, or
+ *           AVL_INDEX_NIL if there was none.
+ */
+AvlIndex AvlIndexTree_insert(AvlIndexTree *self, AvlIndex index);
+
+/**
+ *  Removes the element that compares equal to a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one passed to
+ *                 AvlIndexTree_new. Will be invoked by
+ *                 compare(key, index, arg).
+ *  @returns The index of the removed element, or AVL_INDEX_NIL if no
+ *           element compared equal to key.
+ */
+AvlIndex AvlIndexTree_remove(AvlIndexTree *self, const void *key,
+                             AvlIndexHetComparator compare, void *arg);
+
+/**
+ *  Visits every element of an AvlIndexTree in order.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param traverse Must not be NULL. Will be invoked by
+ *                  traverse(context, index) for each element, in order,
+ *                  until it returns nonzero.
+ *  @returns The nonzero value returned by traverse, or 0 if every
+ *           element was visited.
+ */
+int AvlIndexTree_traverse(const AvlIndexTree *self, AvlIndexTraverseCb traverse,
+                          void *context);
+
+/**
+ *  Copies the keys of an AvlTree into an AvlFrozenTree.
+ *
+ *  Runs in O(n) time. The snapshot refers to the nodes of self, so it
+ *  must be dropped or rebuilt before any of them are removed or freed.
+ *  It does not see later changes to self.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param frozen Must not be NULL. Must not be initialized.
+ *  @param key_size The size of each key in bytes. Must not be 0.
+ *  @param extract Must not be NULL. Will be invoked by
+ *                 extract(node, key, arg) for each node in self, in
+ *                 order, and must write key_size bytes to key. key is
+ *                 aligned for any type whose size divides key_size.
+ */
+void AvlTree_freeze(const AvlTree *self, AvlFrozenTree *frozen, size_t key_size,
+                    AvlKeyExtractor extract, void *arg);
+
+/**
+ *  Frees the keys held by an AvlFrozenTree. The nodes are untouched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlFrozenTree_drop(AvlFrozenTree *self);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must order the frozen keys the
+ *                 same way the AvlTree they were copied from orders
+ *                 their nodes. Will be invoked by
+ *                 compare(key, frozen_key, arg).
+ *  @returns The node whose key compares equal to key, if there is one.
+ */
+const AvlNode* AvlFrozenTree_get(const AvlFrozenTree *self, const void *key,
+                                 AvlKeyComparator compare, void *arg);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must order the frozen keys the
+ *                 same way the AvlTree they were copied from orders
+ *                 their nodes. Will be invoked by
+ *                 compare(key, frozen_key, arg).
+ *  @returns The first node whose key does not compare less than key,
+ *           if there is one.
+ */
+const AvlNode* AvlFrozenTree_lower_bound(const AvlFrozenTree *self, const void *key,
+                                         AvlKeyComparator compare, void *arg);
+
+/**
+ *  Copies the integer keys of an AvlTree into an AvlFrozenIntTree.
+ *
+ *  Runs in O(n) time. The snapshot refers to the nodes of self, so it
+ *  must be dropped or rebuilt before any of them are removed or freed.
+ *  It does not see later changes to self.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be ordered
+ *              by the keys that extract returns, smallest first.
+ *  @param frozen Must not be NULL. Must not be initialized.
+ *  @param extract Must not be NULL. Will be invoked by
+ *                 extract(node, arg) for each node in self, in order.
+ */
+void AvlTree_freeze_ints(const AvlTree *self, AvlFrozenIntTree *frozen,
+                         AvlIntKeyExtractor extract, void *arg);
+
+/**
+ *  Frees the keys held by an AvlFrozenIntTree. The nodes are untouched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlFrozenIntTree_drop(AvlFrozenIntTree *self);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node whose key is equal to key, if there is one.
+ */
+const AvlNode* AvlFrozenIntTree_get(const AvlFrozenIntTree *self, AvlIntKey key);
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The first node whose key is not less than key, if there is
+ *           one.
+ */
+const AvlNode* AvlFrozenIntTree_lower_bound(const AvlFrozenIntTree *self, AvlIntKey key);
+
+/**
+ *  AVL self-balancing binary search tree.
+ *
+ *  AVL trees maintain a strict "AVL condition": for each node,
+ *  the heights of its subtrees never differ by more than one. This
+ *  condition guarantees that the tree's height is upper-bounded by
+ *  1.44 log2(n + 1.065) - 0.328, where n is the number of nodes in the
+ *  tree. As such, insertion, removal, and searching are guaranteed to
+ *  run in O(log n) worst case time.
+ */
+struct AvlTree {
+    AvlNode *root;
+    size_t len;
+    AvlComparator compare;
+    void *compare_arg;
+    AvlDeleter deleter;
+    void *deleter_arg;
+    int tracks_sizes;
+    int tracks_parents;
+    AvlAugmenter augment;
+    void *augment_arg;
+    int caches_extremes;
+    AvlNode *first; /* only kept up to date if caches_extremes */
+    AvlNode *last; /* only kept up to date if caches_extremes */
+};
+
+/**
+ *  Intrusive AVL tree node.
+ *
+ *  Users should create custom structs that have AvlNode as a member,
+ *  such as by composition or inheritance (in C++). Although it may be
+ *  tempting, users should not modify the contents of AvlNode in their
+ *  own types. For example, the following is a node that holds a
+ *  const char* key and an int value:
+ *
+ *  @code{.c}
+ *  typedef struct Node {
+ *      AvlNode node;
+ *      const char *key;
+ *      int value;
+ *  } Node;
+ *
+ *  AvlTree map;
+ *  Node n = {{0}, "Hello, world!", 42};
+ *  Node *const previous = (Node*) AvlTree_insert(&map, &n.node);
+ *  @endcode
+ *
+ *  The {0} initializer zeroes every member of AvlNode, so it is valid
+ *  whether or not AVL_TAGGED_NODES is defined.
+ *
+ *  In C, I recommend placing the AvlNode as the first member of your
+ *  struct to ensure that casting between your own node types and
+ *  AvlNode is valid. You can put the AvlNode member at a different
+ *  spot if you want to, but you'll have to use offsetof() to convert
+ *  between pointer types.
+ *
+ *  This is a similar example using inheritance in C++ to allow for
+ *  easy use of static_cast:
+ *
+ *  @code{.cpp}
+ *  struct Node : AvlNode {
+ *      Node(std::string k, int v) : key(std::move(k)), value(v) { }
+ *
+ *      std::string key;
+ *      int value;
+ *  }
+ *
+ *  AvlTree map;
+ *  Node n("Hello, world!", 42);
+ *  const auto previous = static_cast<Node*>(AvlTree_insert(&map, &n));
+ *  @endcode
+ */
+struct AvlNode {
+#ifdef AVL_TAGGED_NODES
+    AvlNode *left; /* low two bits hold the low bits of the balance factor */
+    AvlNode *right; /* low bit holds the sign bit of the balance factor */
+#else
+    AvlNode *left;
+    AvlNode *right;
+    signed char balance_factor; /* one of {-2, -1, 0, 1, -2} */
+#endif
+};
+
+/**
+ *  Intrusive AVL tree node that also records the size of its subtree.
+ *
+ *  Trees that track sizes with AvlTree_enable_sizes must be built out
+ *  of AvlSizedNodes instead of AvlNodes, which enables O(log n) rank
+ *  and select queries. The AvlNode member must be first so that
+ *  pointers to it can be converted to and from pointers to the
+ *  AvlSizedNode.
+ */
+struct AvlSizedNode {
+    AvlNode node;
+    size_t size; /* number of nodes in this subtree, including this one */
+};
+
+/**
+ *  Intrusive AVL tree node that also links to its parent.
+ *
+ *  Trees that track parents with AvlTree_enable_parents must be built
+ *  out of AvlParentNodes instead of AvlNodes. The AvlNode member must
+ *  be first so that pointers to it can be converted to and from
+ *  pointers to the AvlParentNode.
+ */
+struct AvlParentNode {
+    AvlNode node;
+    AvlNode *parent; /* unspecified for the root */
+};
+
+/**
+ *  Bidirectional in-order cursor over an AvlTree.
+ *
+ *  AvlCursor keeps the path from the root to its current node in a
+ *  fixed-size buffer, so moving it never allocates. A cursor is either
+ *  positioned at a node or at the "end" of the tree, a position that
+ *  sits both after the last node and before the first one.
+ *
+ *  Cursors positioned at a node are invalidated by any operation that
+ *  modifies the tree they point into; a cursor at the end stays valid.
+ */
+struct AvlCursor {
+    const AvlTree *tree;
+    AvlNode *path[AVL_MAX_HEIGHT]; /* path[0] is the root */
+    size_t depth; /* 0 if positioned at the end */
+};
+
+/**
+ *  Position in an AvlTree found by a single search for a key.
+ *
+ *  If ordering is 0 and depth is nonzero, the entry is positioned at
+ *  path[depth - 1]. Otherwise the key belongs on the side of
+ *  path[depth - 1] given by ordering, or at the root if depth is 0.
+ */
+struct AvlEntry {
+    AvlTree *tree;
+    AvlNode *path[AVL_MAX_HEIGHT]; /* path[0] is the root */
+    size_t depth;
+    int ordering; /* the result of comparing the key to path[depth - 1] */
+};
+
+/**
+ *  Pool of fixed-size nodes allocated from large chunks.
+ *
+ *  Nodes are handed out by bumping a pointer through the newest chunk
+ *  and are recycled through a free list, so consecutively allocated
+ *  nodes sit next to each other in memory.
+ */
+struct AvlNodePool {
+    size_t slot_size; /* node size rounded up to keep every slot aligned */
+    size_t slots_per_chunk;
+    void *chunks; /* newest chunk, which starts with a pointer to the next newest */
+    unsigned char *next_slot; /* first never-allocated slot in the newest chunk */
+    size_t num_untouched; /* never-allocated slots left in the newest chunk */
+    void *free_list;
+    size_t len; /* number of allocated nodes */
+};
+
+/**
+ *  Bump allocator for nodes that are all freed at once.
+ *
+ *  Unlike AvlNodePool, nodes may have different sizes and cannot be
+ *  freed individually.
+ */
+struct AvlArena {
+    size_t chunk_size; /* usable bytes in each regular chunk */
+    void *chunks; /* newest chunk, which starts with a pointer to the next newest */
+    unsigned char *next_byte; /* first unallocated byte in the newest chunk */
+    size_t num_free_bytes; /* unallocated bytes left in the newest chunk */
+};
+
+/**
+ *  AVL tree over the elements of a caller-owned array, linked by
+ *  32-bit indices.
+ */
+struct AvlIndexTree {
+    AvlIndexNode *nodes;
+    AvlIndex root; /* AVL_INDEX_NIL if empty */
+    size_t len;
+    AvlIndexComparator compare;
+    void *compare_arg;
+};
+
+/**
+ *  Link storage for one element of an AvlIndexTree.
+ *
+ *  The low 31 bits of each member hold the index of a child, or
+ *  AVL_INDEX_NIL. The top bit of left is set if the left subtree is
+ *  taller, and the top bit of right is set if the right subtree is.
+ */
+struct AvlIndexNode {
+    AvlIndex left;
+    AvlIndex right;
+};
+
+/**
+ *  Read-only snapshot of the keys of an AvlTree, laid out for fast
+ *  searching.
+ *
+ *  Index 0 of both arrays is unused, so the element at index i has
+ *  children at 2i and 2i + 1 for every i from 1 to len.
+ */
+struct AvlFrozenTree {
+    unsigned char *keys; /* the key at index i starts at keys + i * key_size */
+    const AvlNode **nodes; /* nodes[0] is NULL */
+    size_t key_size;
+    size_t len;
+};
+
+/**
+ *  Read-only snapshot of an AvlTree keyed by integers, laid out as a
+ *  static B-tree of 16-key blocks.
+ *
+ *  Block b has children b * 17 + 1 through b * 17 + 17. The last block
+ *  is padded with AVL_INT_KEY_MAX, and one more slot follows it, so
+ *  keys and nodes both have num_blocks * 16 + 1 elements. Padding
+ *  slots map to NULL.
+ */
+struct AvlFrozenIntTree {
+    AvlIntKey *keys; /* aligned to 64 bytes */
+    const AvlNode **nodes; /* nodes[i] has keys[i] */
+    size_t num_blocks;
+    size_t len;
+    void *allocation; /* holds keys */
+    /* returns the index of the first key not less than key; chosen at run time */
+    size_t (*lower_bound_index)(const AvlFrozenIntTree*, AvlIntKey);
+};
+
+/**
+ *  Defines functions that search an AvlTree with a comparison that is
+ *  compiled in instead of called through a function pointer.
+ *
+ *  AvlTree_get and friends call the comparator through a pointer at
+ *  every step, which the compiler cannot inline. The functions defined
+ *  by AVL_DEFINE_TREE evaluate CMP_EXPR directly and call
+ *  AvlTree_insert_at and AvlTree_remove_at for the rebalancing, so
+ *  they work on any AvlTree whose nodes they order the same way.
+ *  Expand it once at file scope in each source file that needs it; all
+ *  of the functions are static.
+ *
+ *  NODE_TYPE must have an AvlNode as its first member. CMP_EXPR is an
+ *  int expression of lhs and rhs, both const NODE_TYPE*, with the
+ *  same meaning as the return value of an AvlComparator. Keys are
+ *  looked up by passing a NODE_TYPE whose key fields are set. The
+ *  following functions are defined:
+ *
+ *  @code{.c}
+ *  void NAME_new(AvlTree *self, AvlDeleter deleter, void *deleter_arg);
+ *  const NODE_TYPE* NAME_get(const AvlTree *self, const NODE_TYPE *key);
+ *  const NODE_TYPE* NAME_lower_bound(const AvlTree *self, const NODE_TYPE *key);
+ *  NODE_TYPE* NAME_insert(AvlTree *self, NODE_TYPE *node);
+ *  NODE_TYPE* NAME_remove(AvlTree *self, const NODE_TYPE *key);
+ *  @endcode
+ *
+ *  which behave like AvlTree_new, AvlTree_get, AvlTree_lower_bound,
+ *  AvlTree_insert and AvlTree_remove.
+ *
+ *  @code{.c}
+ *  typedef struct IntNode {
+ *      AvlNode node;
+ *      int key;
+ *  } IntNode;
+ *
+ *  AVL_DEFINE_TREE(int_tree, IntNode, (lhs->key > rhs->key) - (lhs->key < rhs->key))
+ *
+ *  IntNode probe;
+ *  probe.key = 42;
+ *  found = int_tree_get(&tree, &probe);
+ *  @endcode
+ */
+#define AVL_DEFINE_TREE(NAME, NODE_TYPE, CMP_EXPR) \
+    static AVL_UNUSED int NAME##_compare(const NODE_TYPE *lhs, const NODE_TYPE *rhs) { \
+        return (CMP_EXPR); \
+    } \
+    \
+    static AVL_UNUSED int NAME##_compare_nodes(const AvlNode *lhs, const AvlNode *rhs, \
+                                               void *arg) { \
+        (void) arg; \
+        \
+        return NAME##_compare((const NODE_TYPE*) (const void*) lhs, \
+                              (const NODE_TYPE*) (const void*) rhs); \
+    } \
+    \
+    static AVL_UNUSED void NAME##_new(AvlTree *self, AvlDeleter deleter, void *deleter_arg) { \
+        AvlTree_new(self, NAME##_compare_nodes, NULL, deleter, deleter_arg); \
+    } \
+    \
+    static AVL_UNUSED const NODE_TYPE* NAME##_get(const AvlTree *self, const NODE_TYPE *key) { \
+        const AvlNode *current = self->root; \
+        \
+        while (current) { \
+            const int ordering = NAME##_compare(key, (const NODE_TYPE*) (const void*) current); \
+            \
+            if (ordering == 0) { \
+                return (const NODE_TYPE*) (const void*) current; \
+            } \
+            \
+            current = (ordering < 0) ? AVL_NODE_LEFT(current) : AVL_NODE_RIGHT(current); \
+        } \
+        \
+        return NULL; \
+    } \
+    \
+    static AVL_UNUSED const NODE_TYPE* NAME##_lower_bound(const AvlTree *self, \
+                                                         const NODE_TYPE *key) { \
+        const AvlNode *current = self->root; \
+        const AvlNode *found = NULL; \
+        \
+        while (current) { \
+            if (NAME##_compare(key, (const NODE_TYPE*) (const void*) current) <= 0) { \
+                found = current; \
+                current = AVL_NODE_LEFT(current); \
+            } else { \
+                current = AVL_NODE_RIGHT(current); \
+            } \
+        } \
+        \
+        return (const NODE_TYPE*) (const void*) found; \
+    } \
+    \
+    static AVL_UNUSED NODE_TYPE* NAME##_insert(AvlTree *self, NODE_TYPE *node) { \
+        AvlNode *path[AVL_MAX_HEIGHT]; \
+        AvlNode *current = self->root; \
+        size_t depth = 0; \
+        int ordering = 0; \
+        \
+        while (current) { \
+            path[depth] = current; \
+            ++depth; \
+            ordering = NAME##_compare(node, (const NODE_TYPE*) (const void*) current); \
+            \
+            if (ordering == 0) { \
+                break; \
+            } \
+            \
+            current = (ordering < 0) ? AVL_NODE_LEFT(current) : AVL_NODE_RIGHT(current); \
+        } \
+        \
+        return (NODE_TYPE*) (void*) AvlTree_insert_at(self, path, depth, ordering, \
+                                                      (AvlNode*) (void*) node); \
+    } \
+    \
+    static AVL_UNUSED NODE_TYPE* NAME##_remove(AvlTree *self, const NODE_TYPE *key) { \
+        AvlNode *path[AVL_MAX_HEIGHT]; \
+        AvlNode *current = self->root; \
+        size_t depth = 0; \
+        \
+        while (current) { \
+            const int ordering = NAME##_compare(key, (const NODE_TYPE*) (const void*) current); \
+            \
+            path[depth] = current; \
+            ++depth; \
+            \
+            if (ordering == 0) { \
+                return (NODE_TYPE*) (void*) AvlTree_remove_at(self, path, depth); \
+            } \
+            \
+            current = (ordering < 0) ? AVL_NODE_LEFT(current) : AVL_NODE_RIGHT(current); \
+        } \
+        \
+        return NULL; \
+    }
 
 #ifdef __cplusplus
 } // extern "C"
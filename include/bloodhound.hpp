@@ -0,0 +1,968 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef BLOODHOUND_HPP
+#define BLOODHOUND_HPP
+
+#include "bloodhound.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace avl {
+
+/**
+ *  An ordered associative container with the interface of std::map.
+ *
+ *  Lookups descend the tree in templated code, so Compare is inlined
+ *  instead of being called through a function pointer. Insertions and
+ *  removals record the search path and hand it to AvlTree_insert_at or
+ *  AvlTree_remove_at, which rebalance without comparing anything.
+ *  Nodes are allocated through Allocator rebound to the node type, so
+ *  std::pmr::polymorphic_allocator and other stateful allocators work;
+ *  elements are constructed with allocator_traits::construct, which
+ *  gives polymorphic_allocator its uses-allocator construction.
+ *
+ *  The tree tracks parents, so iterators are node pointers that stay
+ *  valid until their element is erased. Stepping an iterator, erase(pos)
+ *  and extract(pos) follow parent links and never call Compare.
+ */
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class map {
+    struct node;
+    struct search_ret;
+
+    using node_allocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template <bool IsConst>
+    class basic_iterator;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    class node_type;
+    struct insert_return_type;
+
+    map() : map(Compare()) { }
+
+    explicit map(const Compare &compare, const Allocator &alloc = Allocator())
+    : compare_(compare), alloc_(alloc) {
+        AvlTree_new(&tree_, map::compare_nodes, this, map::delete_node, this);
+        AvlTree_enable_parents(&tree_);
+    }
+
+    explicit map(const Allocator &alloc) : map(Compare(), alloc) { }
+
+    template <typename InputIt>
+    map(InputIt first, InputIt last, const Compare &compare = Compare(),
+        const Allocator &alloc = Allocator())
+    : map(compare, alloc) {
+        insert(first, last);
+    }
+
+    map(std::initializer_list<value_type> values, const Compare &compare = Compare(),
+        const Allocator &alloc = Allocator())
+    : map(values.begin(), values.end(), compare, alloc) { }
+
+    map(const map &other)
+    : map(other.compare_,
+          node_traits::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+
+    map(map &&other) noexcept
+    : compare_(std::move(other.compare_)), alloc_(std::move(other.alloc_)) {
+        AvlTree_new(&tree_, map::compare_nodes, this, map::delete_node, this);
+        AvlTree_enable_parents(&tree_);
+        steal(other);
+    }
+
+    ~map() {
+        clear();
+    }
+
+    map& operator=(const map &other) {
+        if (this != &other) {
+            clear();
+            compare_ = other.compare_;
+
+            if (node_traits::propagate_on_container_copy_assignment::value) {
+                alloc_ = other.alloc_;
+            }
+
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    map& operator=(map &&other) noexcept(
+        node_traits::propagate_on_container_move_assignment::value
+    ) {
+        if (this != &other) {
+            clear();
+            compare_ = std::move(other.compare_);
+
+            if (node_traits::propagate_on_container_move_assignment::value) {
+                alloc_ = std::move(other.alloc_);
+                steal(other);
+            } else if (alloc_ == other.alloc_) {
+                steal(other);
+            } else {
+                for (value_type &value : other) {
+                    emplace(value.first, std::move(value.second));
+                }
+
+                other.clear();
+            }
+        }
+
+        return *this;
+    }
+
+    map& operator=(std::initializer_list<value_type> values) {
+        clear();
+        insert(values);
+
+        return *this;
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_type(alloc_);
+    }
+
+    key_compare key_comp() const {
+        return compare_;
+    }
+
+    V& at(const K &key) {
+        node *const found = find_node(key);
+
+        if (!found) {
+            throw std::out_of_range("avl::map::at");
+        }
+
+        return found->value().second;
+    }
+
+    const V& at(const K &key) const {
+        const node *const found = find_node(key);
+
+        if (!found) {
+            throw std::out_of_range("avl::map::at");
+        }
+
+        return found->value().second;
+    }
+
+    V& operator[](const K &key) {
+        return try_emplace(key).first->second;
+    }
+
+    V& operator[](K &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, first_node());
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, first_node());
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(this, nullptr);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, nullptr);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept {
+        return tree_.len == 0;
+    }
+
+    size_type size() const noexcept {
+        return tree_.len;
+    }
+
+    size_type max_size() const noexcept {
+        return std::min<size_type>(node_traits::max_size(alloc_),
+                                   std::numeric_limits<difference_type>::max());
+    }
+
+    void clear() noexcept {
+        AvlTree_clear(&tree_);
+    }
+
+    std::pair<iterator, bool> insert(const value_type &value) {
+        return emplace(value);
+    }
+
+    std::pair<iterator, bool> insert(value_type &&value) {
+        return emplace(std::move(value));
+    }
+
+    template <typename P, typename = typename std::enable_if<
+        std::is_constructible<value_type, P&&>::value
+    >::type>
+    std::pair<iterator, bool> insert(P &&value) {
+        return emplace(std::forward<P>(value));
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> values) {
+        insert(values.begin(), values.end());
+    }
+
+    /** @param handle Must be empty or have an allocator equal to ours. */
+    insert_return_type insert(node_type &&handle) {
+        if (!handle.node_) {
+            return insert_return_type{end(), false, node_type()};
+        }
+
+        assert(handle.get_allocator() == get_allocator());
+
+        search_ret search;
+        search_path(handle.key(), search);
+
+        if (search.found_depth != 0) {
+            return insert_return_type{iterator(this, search.found()), false, std::move(handle)};
+        }
+
+        node *const inserted = handle.release();
+        link(search, inserted);
+
+        return insert_return_type{iterator(this, inserted), true, node_type()};
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K &key, M &&mapped) {
+        return do_insert_or_assign(key, std::forward<M>(mapped));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(K &&key, M &&mapped) {
+        return do_insert_or_assign(std::move(key), std::forward<M>(mapped));
+    }
+
+    template <typename ...Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        node *const created = make_node(std::forward<Args>(args)...);
+        search_ret search;
+
+        search_path(created->value().first, search);
+
+        if (search.found_depth != 0) {
+            destroy_node(created);
+
+            return {iterator(this, search.found()), false};
+        }
+
+        link(search, created);
+
+        return {iterator(this, created), true};
+    }
+
+    template <typename ...Args>
+    std::pair<iterator, bool> try_emplace(const K &key, Args &&...args) {
+        return do_try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    template <typename ...Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+        return do_try_emplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    iterator erase(const_iterator pos) {
+        assert(pos.node_);
+
+        const iterator next(this, successor(pos.node_));
+        destroy_node(unlink(pos.node_));
+
+        return next;
+    }
+
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last) {
+            first = erase(first);
+        }
+
+        return iterator(this, last.node_);
+    }
+
+    size_type erase(const K &key) {
+        search_ret search;
+        search_path(key, search);
+
+        if (search.found_depth == 0) {
+            return 0;
+        }
+
+        destroy_node(to_node(AvlTree_remove_at(&tree_, search.path, search.found_depth)));
+
+        return 1;
+    }
+
+    void swap(map &other) noexcept {
+        using std::swap;
+
+        assert(node_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
+
+        if (node_traits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        }
+
+        swap(compare_, other.compare_);
+        swap(tree_.root, other.tree_.root);
+        swap(tree_.len, other.tree_.len);
+    }
+
+    node_type extract(const_iterator pos) {
+        assert(pos.node_);
+
+        return node_type(alloc_, unlink(pos.node_));
+    }
+
+    node_type extract(const K &key) {
+        search_ret search;
+        search_path(key, search);
+
+        if (search.found_depth == 0) {
+            return node_type();
+        }
+
+        return node_type(alloc_, to_node(AvlTree_remove_at(&tree_, search.path,
+                                                           search.found_depth)));
+    }
+
+    size_type count(const K &key) const {
+        return find_node(key) ? 1 : 0;
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    size_type count(const L &key) const {
+        return find_node(key) ? 1 : 0;
+    }
+
+    iterator find(const K &key) {
+        return iterator(this, find_node(key));
+    }
+
+    const_iterator find(const K &key) const {
+        return const_iterator(this, find_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const L &key) {
+        return iterator(this, find_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator find(const L &key) const {
+        return const_iterator(this, find_node(key));
+    }
+
+    std::pair<iterator, iterator> equal_range(const K &key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<iterator, iterator> equal_range(const L &key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<const_iterator, const_iterator> equal_range(const L &key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    iterator lower_bound(const K &key) {
+        return iterator(this, lower_bound_node(key));
+    }
+
+    const_iterator lower_bound(const K &key) const {
+        return const_iterator(this, lower_bound_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const L &key) {
+        return iterator(this, lower_bound_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator lower_bound(const L &key) const {
+        return const_iterator(this, lower_bound_node(key));
+    }
+
+    iterator upper_bound(const K &key) {
+        return iterator(this, upper_bound_node(key));
+    }
+
+    const_iterator upper_bound(const K &key) const {
+        return const_iterator(this, upper_bound_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const L &key) {
+        return iterator(this, upper_bound_node(key));
+    }
+
+    template <typename L, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator upper_bound(const L &key) const {
+        return const_iterator(this, upper_bound_node(key));
+    }
+
+private:
+    struct node {
+        AvlParentNode link;
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+
+        value_type& value() noexcept {
+            return *reinterpret_cast<value_type*>(&storage);
+        }
+
+        const value_type& value() const noexcept {
+            return *reinterpret_cast<const value_type*>(&storage);
+        }
+    };
+
+    // a root-to-leaf search path; path[found_depth - 1] has the key if found_depth is nonzero
+    struct search_ret {
+        AvlNode *path[AVL_MAX_HEIGHT];
+        std::size_t depth;
+        std::size_t found_depth;
+        int ordering;
+
+        node* found() const noexcept {
+            return map::to_node(path[found_depth - 1]);
+        }
+    };
+
+    static node* to_node(AvlNode *link) noexcept {
+        return reinterpret_cast<node*>(link);
+    }
+
+    static const K& key_of(const AvlNode *link) noexcept {
+        return reinterpret_cast<const node*>(link)->value().first;
+    }
+
+    static int compare_nodes(const AvlNode *lhs, const AvlNode *rhs, void *self_v) {
+        const map &self = *static_cast<const map*>(self_v);
+
+        if (self.compare_(key_of(lhs), key_of(rhs))) {
+            return -1;
+        } else if (self.compare_(key_of(rhs), key_of(lhs))) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }
+
+    static void delete_node(AvlNode *link, void *self_v) {
+        static_cast<map*>(self_v)->destroy_node(to_node(link));
+    }
+
+    template <typename ...Args>
+    node* make_node(Args &&...args) {
+        node *const created = std::addressof(*node_traits::allocate(alloc_, 1));
+
+        ::new (static_cast<void*>(&created->link)) AvlParentNode();
+
+        try {
+            node_traits::construct(alloc_, std::addressof(created->value()),
+                                   std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate_node(alloc_, created);
+
+            throw;
+        }
+
+        return created;
+    }
+
+    void destroy_node(node *destroyed) noexcept {
+        map::destroy_node(alloc_, destroyed);
+    }
+
+    static void destroy_node(node_allocator &alloc, node *destroyed) noexcept {
+        node_traits::destroy(alloc, std::addressof(destroyed->value()));
+        deallocate_node(alloc, destroyed);
+    }
+
+    static void deallocate_node(node_allocator &alloc, node *deallocated) noexcept {
+        node_traits::deallocate(
+            alloc, std::pointer_traits<typename node_traits::pointer>::pointer_to(*deallocated), 1
+        );
+    }
+
+    // moves other's nodes into this map; our allocator must be able to free them
+    void steal(map &other) noexcept {
+        tree_.root = other.tree_.root;
+        tree_.len = other.tree_.len;
+        other.tree_.root = nullptr;
+        other.tree_.len = 0;
+    }
+
+    void copy_from(const map &other) {
+        std::vector<AvlNode*> nodes;
+        nodes.reserve(other.size());
+
+        try {
+            for (const value_type &value : other) {
+                nodes.push_back(&make_node(value)->link.node);
+            }
+        } catch (...) {
+            for (AvlNode *link : nodes) {
+                destroy_node(to_node(link));
+            }
+
+            throw;
+        }
+
+        AvlTree_build_sorted(&tree_, nodes.data(), nodes.size());
+    }
+
+    // one comparison per level: descends towards the lower bound of key, then checks for equality
+    template <typename L>
+    void search_path(const L &key, search_ret &ret) const {
+        AvlNode *current = tree_.root;
+
+        ret.depth = 0;
+        ret.found_depth = 0;
+        ret.ordering = 0;
+
+        while (current) {
+            ret.path[ret.depth++] = current;
+
+            if (compare_(key_of(current), key)) {
+                ret.ordering = 1;
+                current = AVL_NODE_RIGHT(current);
+            } else {
+                ret.found_depth = ret.depth;
+                ret.ordering = -1;
+                current = AVL_NODE_LEFT(current);
+            }
+        }
+
+        if (ret.found_depth != 0 && compare_(key, key_of(ret.path[ret.found_depth - 1]))) {
+            ret.found_depth = 0;
+        }
+    }
+
+    void link(const search_ret &search, node *linked) noexcept {
+        AvlTree_insert_at(&tree_, search.path, search.depth, search.ordering, &linked->link.node);
+    }
+
+    // removes target, which must be in the tree, without destroying it
+    node* unlink(node *target) noexcept {
+        AvlTree_remove_node(&tree_, &target->link.node);
+
+        return target;
+    }
+
+    template <typename L, typename M>
+    std::pair<iterator, bool> do_insert_or_assign(L &&key, M &&mapped) {
+        search_ret search;
+        search_path(key, search);
+
+        if (search.found_depth != 0) {
+            node *const found = search.found();
+            found->value().second = std::forward<M>(mapped);
+
+            return {iterator(this, found), false};
+        }
+
+        node *const created = make_node(std::forward<L>(key), std::forward<M>(mapped));
+        link(search, created);
+
+        return {iterator(this, created), true};
+    }
+
+    template <typename L, typename ...Args>
+    std::pair<iterator, bool> do_try_emplace(L &&key, Args &&...args) {
+        search_ret search;
+        search_path(key, search);
+
+        if (search.found_depth != 0) {
+            return {iterator(this, search.found()), false};
+        }
+
+        node *const created = make_node(std::piecewise_construct,
+                                         std::forward_as_tuple(std::forward<L>(key)),
+                                         std::forward_as_tuple(std::forward<Args>(args)...));
+        link(search, created);
+
+        return {iterator(this, created), true};
+    }
+
+    template <typename L>
+    node* find_node(const L &key) const {
+        node *const found = lower_bound_node(key);
+
+        if (!found || compare_(key, found->value().first)) {
+            return nullptr;
+        }
+
+        return found;
+    }
+
+    template <typename L>
+    node* lower_bound_node(const L &key) const {
+        AvlNode *current = tree_.root;
+        AvlNode *bound = nullptr;
+
+        while (current) {
+            if (compare_(key_of(current), key)) {
+                current = AVL_NODE_RIGHT(current);
+            } else {
+                bound = current;
+                current = AVL_NODE_LEFT(current);
+            }
+        }
+
+        return to_node(bound);
+    }
+
+    template <typename L>
+    node* upper_bound_node(const L &key) const {
+        AvlNode *current = tree_.root;
+        AvlNode *bound = nullptr;
+
+        while (current) {
+            if (compare_(key, key_of(current))) {
+                bound = current;
+                current = AVL_NODE_LEFT(current);
+            } else {
+                current = AVL_NODE_RIGHT(current);
+            }
+        }
+
+        return to_node(bound);
+    }
+
+    node* first_node() const noexcept {
+        AvlNode *current = tree_.root;
+
+        if (!current) {
+            return nullptr;
+        }
+
+        while (AVL_NODE_LEFT(current)) {
+            current = AVL_NODE_LEFT(current);
+        }
+
+        return to_node(current);
+    }
+
+    node* last_node() const noexcept {
+        AvlNode *current = tree_.root;
+
+        if (!current) {
+            return nullptr;
+        }
+
+        while (AVL_NODE_RIGHT(current)) {
+            current = AVL_NODE_RIGHT(current);
+        }
+
+        return to_node(current);
+    }
+
+    node* successor(node *from) const noexcept {
+        return to_node(const_cast<AvlNode*>(AvlTree_next(&tree_, &from->link.node)));
+    }
+
+    // from may be null, in which case the last node is returned
+    node* predecessor(node *from) const noexcept {
+        if (!from) {
+            return last_node();
+        }
+
+        return to_node(const_cast<AvlNode*>(AvlTree_prev(&tree_, &from->link.node)));
+    }
+
+    AvlTree tree_;
+    Compare compare_;
+    node_allocator alloc_;
+};
+
+template <typename K, typename V, typename Compare, typename Allocator>
+template <bool IsConst>
+class map<K, V, Compare, Allocator>::basic_iterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+    using pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+
+    basic_iterator() noexcept : owner_(nullptr), node_(nullptr) { }
+
+    template <bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+    basic_iterator(const basic_iterator<OtherConst> &other) noexcept
+    : owner_(other.owner_), node_(other.node_) { }
+
+    reference operator*() const noexcept {
+        return node_->value();
+    }
+
+    pointer operator->() const noexcept {
+        return std::addressof(node_->value());
+    }
+
+    basic_iterator& operator++() noexcept {
+        node_ = owner_->successor(node_);
+
+        return *this;
+    }
+
+    basic_iterator operator++(int) noexcept {
+        const basic_iterator previous = *this;
+        ++*this;
+
+        return previous;
+    }
+
+    basic_iterator& operator--() noexcept {
+        node_ = owner_->predecessor(node_);
+
+        return *this;
+    }
+
+    basic_iterator operator--(int) noexcept {
+        const basic_iterator previous = *this;
+        --*this;
+
+        return previous;
+    }
+
+    friend bool operator==(const basic_iterator &lhs, const basic_iterator &rhs) noexcept {
+        return lhs.node_ == rhs.node_;
+    }
+
+    friend bool operator!=(const basic_iterator &lhs, const basic_iterator &rhs) noexcept {
+        return lhs.node_ != rhs.node_;
+    }
+
+private:
+    friend class map;
+    friend class basic_iterator<!IsConst>;
+
+    basic_iterator(const map *owner, node *current) noexcept : owner_(owner), node_(current) { }
+
+    const map *owner_;
+    node *node_;
+};
+
+/**
+ *  Owns a node extracted from an avl::map, like std::map::node_type.
+ *
+ *  The node can be inserted into any map whose allocator compares
+ *  equal to the one it was allocated with; if it never is, it is
+ *  destroyed with that allocator.
+ */
+template <typename K, typename V, typename Compare, typename Allocator>
+class map<K, V, Compare, Allocator>::node_type {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using allocator_type = Allocator;
+
+    node_type() noexcept : node_(nullptr) { }
+
+    node_type(node_type &&other) noexcept : node_(nullptr) {
+        *this = std::move(other);
+    }
+
+    ~node_type() {
+        reset();
+    }
+
+    node_type& operator=(node_type &&other) noexcept {
+        if (this != &other) {
+            reset();
+
+            if (other.node_) {
+                ::new (static_cast<void*>(&alloc_)) node_allocator(std::move(other.allocator()));
+                node_ = other.release();
+            }
+        }
+
+        return *this;
+    }
+
+    bool empty() const noexcept {
+        return !node_;
+    }
+
+    explicit operator bool() const noexcept {
+        return node_ != nullptr;
+    }
+
+    /** @pre Must not be empty. */
+    allocator_type get_allocator() const {
+        assert(node_);
+
+        return allocator_type(allocator());
+    }
+
+    /**
+     *  The key may be modified while the handle owns the node, e.g. to
+     *  reinsert it under another key.
+     *
+     *  @pre Must not be empty.
+     */
+    K& key() const noexcept {
+        assert(node_);
+
+        return const_cast<K&>(node_->value().first);
+    }
+
+    /** @pre Must not be empty. */
+    V& mapped() const noexcept {
+        assert(node_);
+
+        return node_->value().second;
+    }
+
+private:
+    friend class map;
+
+    node_type(const node_allocator &alloc, node *owned) : node_(owned) {
+        ::new (static_cast<void*>(&alloc_)) node_allocator(alloc);
+    }
+
+    node_allocator& allocator() const noexcept {
+        return *reinterpret_cast<node_allocator*>(&alloc_);
+    }
+
+    // gives up ownership of the node, leaving this handle empty
+    node* release() noexcept {
+        node *const released = node_;
+
+        allocator().~node_allocator();
+        node_ = nullptr;
+
+        return released;
+    }
+
+    void reset() noexcept {
+        if (node_) {
+            map::destroy_node(allocator(), node_);
+            allocator().~node_allocator();
+            node_ = nullptr;
+        }
+    }
+
+    // only holds an allocator while node_ is not null
+    mutable typename std::aligned_storage<sizeof(node_allocator),
+                                          alignof(node_allocator)>::type alloc_;
+    node *node_;
+};
+
+template <typename K, typename V, typename Compare, typename Allocator>
+struct map<K, V, Compare, Allocator>::insert_return_type {
+    iterator position;
+    bool inserted;
+    node_type node;
+};
+
+template <typename K, typename V, typename Compare, typename Allocator>
+void swap(map<K, V, Compare, Allocator> &lhs, map<K, V, Compare, Allocator> &rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace avl
+
+#endif
@@ -0,0 +1,201 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/* chunks start with a header that points to the previous chunk */
+typedef union ChunkHeader {
+    struct {
+        void *previous;
+        size_t size; /* usable bytes after the header */
+    } info;
+    MaxAlign align;
+} ChunkHeader;
+
+#define DEFAULT_CHUNK_SIZE ((size_t) 65536)
+
+static size_t round_up(size_t size);
+
+static void* new_chunk(size_t size, void *previous);
+
+/**
+ *  Initializes an empty AvlArena.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param chunk_size The number of bytes to allocate at once. If 0,
+ *                    chunks will be 64 KiB.
+ */
+void AvlArena_new(AvlArena *self, size_t chunk_size) {
+    assert(self);
+
+    if (chunk_size == 0) {
+        chunk_size = DEFAULT_CHUNK_SIZE - sizeof(ChunkHeader);
+    }
+
+    self->chunk_size = round_up(chunk_size);
+    self->chunks = NULL;
+    self->next_byte = NULL;
+    self->num_free_bytes = 0;
+}
+
+/**
+ *  Drops an AvlArena, freeing every chunk.
+ *
+ *  Every node allocated from the arena becomes invalid.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlArena_drop(AvlArena *self) {
+    void *chunk;
+
+    assert(self);
+
+    chunk = self->chunks;
+
+    while (chunk) {
+        void *const previous = ((ChunkHeader*) chunk)->info.previous;
+
+        free(chunk);
+        chunk = previous;
+    }
+
+    self->chunks = NULL;
+    self->next_byte = NULL;
+    self->num_free_bytes = 0;
+}
+
+/**
+ *  Allocates memory from an AvlArena.
+ *
+ *  Runs in O(1) time. Allocations larger than a chunk get a chunk of
+ *  their own. If malloc() returns NULL, a message is printed to stderr
+ *  and abort() is called.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A pointer to uninitialized memory at least size bytes
+ *           long, aligned for any object type.
+ */
+void* AvlArena_alloc(AvlArena *self, size_t size) {
+    void *allocated;
+
+    assert(self);
+
+    size = round_up(size);
+
+    if (size > self->num_free_bytes) {
+        if (size > self->chunk_size) {
+            /* keep bumping through the newest regular chunk afterwards */
+            void *chunk;
+
+            if (!self->chunks) {
+                chunk = new_chunk(size, NULL);
+                self->chunks = chunk;
+            } else {
+                ChunkHeader *const newest = (ChunkHeader*) self->chunks;
+
+                chunk = new_chunk(size, newest->info.previous);
+                newest->info.previous = chunk;
+            }
+
+            return (unsigned char*) chunk + sizeof(ChunkHeader);
+        }
+
+        self->chunks = new_chunk(self->chunk_size, self->chunks);
+        self->next_byte = (unsigned char*) self->chunks + sizeof(ChunkHeader);
+        self->num_free_bytes = self->chunk_size;
+    }
+
+    allocated = self->next_byte;
+    self->next_byte += size;
+    self->num_free_bytes -= size;
+
+    return allocated;
+}
+
+/**
+ *  Frees every allocation from an AvlArena at once.
+ *
+ *  Runs in O(c) time, where c is the number of chunks. The newest
+ *  chunk is kept for reuse.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlArena_reset(AvlArena *self) {
+    ChunkHeader *newest;
+
+    assert(self);
+
+    newest = (ChunkHeader*) self->chunks;
+
+    if (!newest || newest->info.size != self->chunk_size) {
+        AvlArena_drop(self);
+
+        return;
+    }
+
+    self->chunks = newest->info.previous;
+    AvlArena_drop(self);
+
+    newest->info.previous = NULL;
+    self->chunks = newest;
+    self->next_byte = (unsigned char*) newest + sizeof(ChunkHeader);
+    self->num_free_bytes = self->chunk_size;
+}
+
+/**
+ *  AvlDeleter that does nothing, leaving nodes to be reclaimed with
+ *  the arena they were allocated from.
+ *
+ *  AvlTree_clear skips its traversal entirely for trees that use it.
+ */
+void AvlArena_deleter(AvlNode *node, void *arena) {
+    assert(node);
+
+    (void) node;
+    (void) arena;
+}
+
+static size_t round_up(size_t size) {
+    if (size == 0) {
+        return sizeof(MaxAlign);
+    }
+
+    return (size + sizeof(MaxAlign) - 1) / sizeof(MaxAlign) * sizeof(MaxAlign);
+}
+
+static void* new_chunk(size_t size, void *previous) {
+    ChunkHeader *const chunk = (ChunkHeader*) checked_malloc(sizeof(ChunkHeader) + size);
+
+    chunk->info.previous = previous;
+    chunk->info.size = size;
+
+    return chunk;
+}
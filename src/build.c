@@ -0,0 +1,456 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "join.h"
+#include "node.h"
+
+#include <assert.h>
+
+/* batches with at least MERGE_RATIO times as many nodes as the tree are merged in instead */
+#define MERGE_RATIO 2
+
+/* at least RUN_MIN consecutive nodes that fall between the same two tree nodes are joined in */
+#define RUN_MIN 8
+
+typedef struct Source {
+    AvlNode **nodes;
+    AvlNode* (*next)(void*);
+    void *next_arg;
+#ifndef NDEBUG
+    const AvlTree *tree;
+    const AvlNode *previous;
+#endif
+} Source;
+
+static AvlNode* build(const AvlTree *self, Source *source, size_t n);
+
+static size_t find_from(const AvlTree *self, AvlNode **path, size_t depth, const AvlNode *node,
+                        int *ordering);
+
+static size_t find_anchor(AvlNode *const *path, size_t depth);
+
+static size_t run_length(const AvlTree *self, AvlNode *const *path, size_t depth, int ordering,
+                         AvlNode **nodes, size_t n, const AvlNode *previous);
+
+static void link_run(AvlTree *self, AvlNode **nodes, size_t n);
+
+/**
+ *  Links an array of nodes into a perfectly balanced tree.
+ *
+ *  Runs in O(n) time and touches each node exactly once, without
+ *  calling the comparator.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param nodes Must not be NULL if n > 0. Must be sorted in strictly
+ *               increasing order according to the tree's comparator.
+ */
+void AvlTree_build_sorted(AvlTree *self, AvlNode **nodes, size_t n) {
+    Source source;
+
+    assert(self);
+    assert(!self->root);
+    assert(nodes || n == 0);
+
+    source.nodes = nodes;
+    source.next = NULL;
+    source.next_arg = NULL;
+#ifndef NDEBUG
+    source.tree = self;
+    source.previous = NULL;
+#endif
+
+    self->root = build(self, &source, n);
+    self->len = n;
+    refresh_extremes(self);
+}
+
+/**
+ *  Links a stream of nodes into a perfectly balanced tree.
+ *
+ *  Equivalent to AvlTree_build_sorted, but pulls nodes one at a time
+ *  so that they need not be collected into an array first.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param n The number of nodes in the stream.
+ *  @param next Must not be NULL. Will be invoked exactly n times by
+ *              next(next_arg) to obtain the nodes in strictly
+ *              increasing order according to the tree's comparator.
+ */
+void AvlTree_build_sorted_iter(AvlTree *self, size_t n, AvlNode* (*next)(void*),
+                               void *next_arg) {
+    Source source;
+
+    assert(self);
+    assert(!self->root);
+    assert(next);
+
+    source.nodes = NULL;
+    source.next = next;
+    source.next_arg = next_arg;
+#ifndef NDEBUG
+    source.tree = self;
+    source.previous = NULL;
+#endif
+
+    self->root = build(self, &source, n);
+    self->len = n;
+    refresh_extremes(self);
+}
+
+/**
+ *  Inserts a sorted array of nodes into an AvlTree.
+ *
+ *  Each search resumes from the deepest node on the previous search
+ *  path whose subtree can still hold the next node, rather than from
+ *  the root, so a batch of n nodes makes about n log(len/n) comparator
+ *  calls instead of n log(len). A run of consecutive nodes that all
+ *  fall between the same two nodes of the tree is linked into a
+ *  balanced subtree and joined in, so the tree is rebalanced once per
+ *  run rather than once per node. A batch at least twice as large as
+ *  the tree is instead built into a tree of its own and merged in with
+ *  AvlTree_union.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              compares equal to one in nodes is replaced by it and
+ *              passed to the deleter.
+ *  @param nodes Must not be NULL if n > 0. Must be sorted in strictly
+ *               increasing order according to the tree's comparator.
+ *               None of them may be in the tree.
+ */
+void AvlTree_insert_sorted_batch(AvlTree *self, AvlNode **nodes, size_t n) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    size_t i;
+
+    assert(self);
+    assert(nodes || n == 0);
+
+    if (n == 0) {
+        return;
+    } else if (n / MERGE_RATIO >= self->len) {
+        AvlTree batch;
+
+        batch = *self;
+        batch.root = NULL;
+        batch.len = 0;
+        AvlTree_build_sorted(&batch, nodes, n);
+
+        /* batch keeps its own nodes, so they replace the ones in self */
+        AvlTree_union(&batch, self);
+        *self = batch;
+
+        return;
+    }
+
+    for (i = 0; i < n; ++i) {
+        AvlNode *previous;
+        size_t run;
+        int ordering;
+
+        assert(nodes[i]);
+        assert(i == 0 || self->compare(nodes[i - 1], nodes[i], self->compare_arg) < 0);
+
+        depth = find_from(self, path, depth, nodes[i], &ordering);
+
+        if (depth > 0 && ordering == 0) {
+            previous = AvlTree_insert_at(self, path, depth, 0, nodes[i]);
+            path[depth - 1] = nodes[i];
+            self->deleter(previous, self->deleter_arg);
+        } else if ((run = run_length(self, path, depth, ordering, nodes + i, n - i,
+                                       (i > 0) ? nodes[i - 1] : NULL)) >= RUN_MIN) {
+            link_run(self, nodes + i, run);
+            i += run - 1;
+            depth = 0;
+        } else {
+            /* only a rotation at the anchor can relink the nodes on the path */
+            const size_t anchor = find_anchor(path, depth);
+
+            AvlTree_insert_at(self, path, depth, ordering, nodes[i]);
+            assert(depth < AVL_MAX_HEIGHT);
+            path[depth] = nodes[i];
+
+            if (anchor == 0) {
+                depth = (path[0] == self->root) ? depth + 1 : 0;
+            } else if (path[anchor] == left_of(path[anchor - 1])
+                       || path[anchor] == right_of(path[anchor - 1])) {
+                ++depth;
+            } else {
+                depth = anchor;
+            }
+        }
+    }
+}
+
+static AvlNode* take(Source *source);
+
+static signed char height(size_t n);
+
+/* builds a subtree out of the next n nodes, in order */
+static AvlNode* build(const AvlTree *self, Source *source, size_t n) {
+    size_t num_left;
+    size_t num_right;
+    AvlNode *left;
+    AvlNode *root;
+
+    assert(self);
+    assert(source);
+
+    if (n == 0) {
+        return NULL;
+    }
+
+    num_left = (n - 1) / 2;
+    num_right = n - 1 - num_left;
+
+    left = build(self, source, num_left);
+    root = take(source);
+    set_left(root, left);
+    set_right(root, build(self, source, num_right));
+
+    /* num_right is num_left or num_left + 1, so this is 0 or 1 */
+    set_balance_factor(root, (signed char) (height(num_right) - height(num_left)));
+    update_node(self, root);
+
+    return root;
+}
+
+static AvlNode* take(Source *source) {
+    AvlNode *node;
+
+    assert(source);
+
+    if (source->nodes) {
+        node = *source->nodes;
+        ++source->nodes;
+    } else {
+        node = source->next(source->next_arg);
+    }
+
+    assert(node);
+    assert(is_tag_aligned(node));
+    assert(!source->previous
+           || source->tree->compare(source->previous, node, source->tree->compare_arg) < 0);
+
+#ifndef NDEBUG
+    source->previous = node;
+#endif
+
+    return node;
+}
+
+/* height of a perfectly balanced tree with n nodes */
+static signed char height(size_t n) {
+    signed char h = 0;
+
+    while (n > 0) {
+        n /= 2;
+        ++h;
+    }
+
+    return h;
+}
+
+/**
+ *  Searches for the position of a node, reusing the part of a previous
+ *  search path whose subtrees can still hold it.
+ *
+ *  @param path Must hold the first depth nodes on the path from the
+ *              root to a node that compares less than node. Will hold
+ *              the path to the node that compares equal to node, or to
+ *              the parent node would be linked under.
+ *  @param ordering Will be set to the result of comparing node to the
+ *                  last node on the returned path.
+ *  @returns The number of nodes on the new path.
+ */
+static size_t find_from(const AvlTree *self, AvlNode **path, size_t depth, const AvlNode *node,
+                        int *ordering) {
+    AvlNode *current;
+    size_t resume = depth;
+    size_t i;
+
+    assert(self);
+    assert(path);
+    assert(node);
+    assert(ordering);
+
+    /* a subtree is bounded above by the nearest ancestor it hangs to the left of */
+    for (i = depth; i > 1; --i) {
+        if (path[i - 1] == left_of(path[i - 2])) {
+            *ordering = self->compare(node, path[i - 2], self->compare_arg);
+
+            if (*ordering < 0) {
+                break;
+            } else if (*ordering == 0) {
+                return i - 1;
+            }
+
+            resume = i - 1;
+        }
+    }
+
+    if (resume == 0) {
+        current = self->root;
+    } else {
+        current = path[resume - 1];
+        --resume;
+    }
+
+    *ordering = 0;
+
+    for (depth = resume; current; ) {
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth++] = current;
+        *ordering = self->compare(node, current, self->compare_arg);
+
+        if (*ordering == 0) {
+            break;
+        } else if (*ordering < 0) {
+            current = left_of(current);
+        } else { /* *ordering > 0 */
+            current = right_of(current);
+        }
+    }
+
+    return depth;
+}
+
+/* the deepest node on path that rebalancing after an insertion below it might rotate */
+static size_t find_anchor(AvlNode *const *path, size_t depth) {
+    size_t anchor;
+
+    assert(path || depth == 0);
+
+    if (depth == 0) {
+        return 0;
+    }
+
+    for (anchor = depth - 1; anchor > 0 && balance_factor_of(path[anchor]) == 0; --anchor) { }
+
+    return anchor;
+}
+
+/* the nearest node on path that is less than (side < 0) or greater than (side > 0) the gap */
+static const AvlNode* gap_bound(AvlNode *const *path, size_t depth, int ordering, int side) {
+    size_t i;
+
+    if (depth == 0) {
+        return NULL;
+    } else if ((ordering < 0) == (side > 0)) {
+        return path[depth - 1];
+    }
+
+    for (i = depth - 1; i > 0; --i) {
+        if (path[i] == ((side > 0) ? left_of(path[i - 1]) : right_of(path[i - 1]))) {
+            return path[i - 1];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  Counts the nodes at the start of nodes that fall into the gap that
+ *  the search path ends at.
+ *
+ *  @param previous The node inserted just before nodes[0], if any.
+ *  @returns The length of the run if it is at least RUN_MIN, or 1.
+ */
+static size_t run_length(const AvlTree *self, AvlNode *const *path, size_t depth, int ordering,
+                         AvlNode **nodes, size_t n, const AvlNode *previous) {
+    const AvlNode *bound;
+    size_t lo;
+    size_t hi;
+
+    /* only look for a run once two nodes in a row have landed in the same gap */
+    if (n < RUN_MIN || (previous && gap_bound(path, depth, ordering, -1) != previous)) {
+        return 1;
+    }
+
+    bound = gap_bound(path, depth, ordering, 1);
+
+    if (!bound) {
+        return n;
+    } else if (self->compare(nodes[RUN_MIN - 1], bound, self->compare_arg) >= 0) {
+        return 1;
+    }
+
+    /* nodes[lo - 1] is in the gap; gallop, then bisect for the first one that is not */
+    lo = RUN_MIN;
+    hi = RUN_MIN;
+
+    while (hi < n && self->compare(nodes[hi], bound, self->compare_arg) < 0) {
+        lo = hi + 1;
+        hi = (hi * 2 < n) ? hi * 2 : n;
+    }
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (self->compare(nodes[mid], bound, self->compare_arg) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* adapts the tree's comparator for split_subtree, with a node as the key */
+static int compare_key(const void *lhs, const AvlNode *rhs, void *self_v) {
+    const AvlTree *const self = (const AvlTree*) self_v;
+
+    return self->compare((const AvlNode*) lhs, rhs, self->compare_arg);
+}
+
+/* splits the tree at the run's gap and joins the run back in as a balanced subtree */
+static void link_run(AvlTree *self, AvlNode **nodes, size_t n) {
+    Source source;
+    SplitRet split;
+    AvlNode *middle;
+    size_t joined_height;
+
+    assert(n >= 2);
+
+    split_subtree(self, self->root, subtree_height(self->root), nodes[0], compare_key, self, &split);
+    assert(!split.equal);
+
+    source.nodes = nodes + 1;
+#ifndef NDEBUG
+    source.tree = self;
+    source.previous = nodes[0];
+#endif
+    middle = build(self, &source, n - 2);
+
+    self->root = join_subtrees(self, split.left, split.left_height, nodes[0], middle,
+                               (size_t) height(n - 2), &joined_height);
+    self->root = join_subtrees(self, self->root, joined_height, nodes[n - 1], split.right,
+                               split.right_height, &joined_height);
+    self->len += n;
+    refresh_extremes(self);
+}
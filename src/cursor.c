@@ -0,0 +1,500 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "node.h"
+
+#include <assert.h>
+
+/**
+ *  Initializes an AvlCursor positioned at the end of a tree.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param tree Must not be NULL. Must be initialized. Must outlive
+ *              self.
+ */
+void AvlCursor_new(AvlCursor *self, const AvlTree *tree) {
+    assert(self);
+    assert(tree);
+
+    self->tree = tree;
+    self->depth = 0;
+}
+
+static const AvlNode* descend_left(AvlCursor *self, AvlNode *node);
+
+static const AvlNode* descend_right(AvlCursor *self, AvlNode *node);
+
+typedef enum Bound {
+    BOUND_GREATER_OR_EQUAL,
+    BOUND_GREATER,
+    BOUND_LESS_OR_EQUAL
+} Bound;
+
+static const AvlNode* bound(const AvlTree *self, const void *key, AvlHetComparator compare,
+                            void *arg, AvlCursor *cursor, Bound which);
+
+/**
+ *  Moves an AvlCursor to the first node of its tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The first node of the tree, if there is one. Otherwise the
+ *           cursor is positioned at the end and NULL is returned.
+ */
+const AvlNode* AvlCursor_first(AvlCursor *self) {
+    assert(self);
+
+    self->depth = 0;
+
+    return descend_left(self, self->tree->root);
+}
+
+/**
+ *  Moves an AvlCursor to the last node of its tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The last node of the tree, if there is one. Otherwise the
+ *           cursor is positioned at the end and NULL is returned.
+ */
+const AvlNode* AvlCursor_last(AvlCursor *self) {
+    assert(self);
+
+    self->depth = 0;
+
+    return descend_right(self, self->tree->root);
+}
+
+/**
+ *  Moves an AvlCursor to the in-order successor of its current node.
+ *
+ *  If the cursor is positioned at the end, it is moved to the first
+ *  node of the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor was moved to, or NULL if the cursor
+ *           was moved to the end.
+ */
+const AvlNode* AvlCursor_next(AvlCursor *self) {
+    AvlNode *current;
+
+    assert(self);
+
+    if (self->depth == 0) {
+        return AvlCursor_first(self);
+    }
+
+    current = self->path[self->depth - 1];
+
+    if (right_of(current)) {
+        return descend_left(self, right_of(current));
+    }
+
+    /* climb until we leave a left subtree */
+    while (--self->depth > 0) {
+        AvlNode *const parent = self->path[self->depth - 1];
+
+        if (left_of(parent) == current) {
+            return parent;
+        }
+
+        current = parent;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Moves an AvlCursor to the in-order predecessor of its current node.
+ *
+ *  If the cursor is positioned at the end, it is moved to the last
+ *  node of the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor was moved to, or NULL if the cursor
+ *           was moved to the end.
+ */
+const AvlNode* AvlCursor_prev(AvlCursor *self) {
+    AvlNode *current;
+
+    assert(self);
+
+    if (self->depth == 0) {
+        return AvlCursor_last(self);
+    }
+
+    current = self->path[self->depth - 1];
+
+    if (left_of(current)) {
+        return descend_right(self, left_of(current));
+    }
+
+    /* climb until we leave a right subtree */
+    while (--self->depth > 0) {
+        AvlNode *const parent = self->path[self->depth - 1];
+
+        if (right_of(parent) == current) {
+            return parent;
+        }
+
+        current = parent;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Moves an AvlCursor to the node that compares equal to a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The node that compares equal to key, if there is one.
+ *           Otherwise the cursor is positioned at the end and NULL is
+ *           returned.
+ */
+const AvlNode* AvlCursor_seek(AvlCursor *self, const void *key,
+                              AvlHetComparator compare, void *arg) {
+    AvlNode *current;
+
+    assert(self);
+    assert(compare);
+
+    self->depth = 0;
+
+    for (current = self->tree->root; current; ++self->depth) {
+        const int ordering = compare(key, current, arg);
+
+        assert(self->depth < AVL_MAX_HEIGHT);
+        self->path[self->depth] = current;
+
+        if (ordering == 0) {
+            ++self->depth;
+
+            return current;
+        } else if (ordering < 0) {
+            current = left_of(current);
+        } else { /* ordering > 0 */
+            current = right_of(current);
+        }
+    }
+
+    self->depth = 0;
+
+    return NULL;
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the cursor is positioned at, or NULL if it is
+ *           positioned at the end.
+ */
+const AvlNode* AvlCursor_get(const AvlCursor *self) {
+    assert(self);
+
+    if (self->depth == 0) {
+        return NULL;
+    }
+
+    return self->path[self->depth - 1];
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A mutable pointer to the node the cursor is positioned at,
+ *           or NULL if it is positioned at the end.
+ */
+AvlNode* AvlCursor_get_mut(AvlCursor *self) {
+    assert(self);
+
+    if (self->depth == 0) {
+        return NULL;
+    }
+
+    return self->path[self->depth - 1];
+}
+
+/**
+ *  Finds the first node that does not compare less than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than or equal to
+ *           key, if there is one.
+ */
+const AvlNode* AvlTree_lower_bound(const AvlTree *self, const void *key,
+                                   AvlHetComparator compare, void *arg, AvlCursor *cursor) {
+    assert(self);
+    assert(compare);
+
+    return bound(self, key, compare, arg, cursor, BOUND_GREATER_OR_EQUAL);
+}
+
+/**
+ *  Finds the first node that compares greater than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than key, if there
+ *           is one.
+ */
+const AvlNode* AvlTree_upper_bound(const AvlTree *self, const void *key,
+                                   AvlHetComparator compare, void *arg, AvlCursor *cursor) {
+    assert(self);
+    assert(compare);
+
+    return bound(self, key, compare, arg, cursor, BOUND_GREATER);
+}
+
+/**
+ *  Finds the last node that does not compare greater than a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The last node that compares less than or equal to key, if
+ *           there is one.
+ */
+const AvlNode* AvlTree_floor(const AvlTree *self, const void *key,
+                             AvlHetComparator compare, void *arg, AvlCursor *cursor) {
+    assert(self);
+    assert(compare);
+
+    return bound(self, key, compare, arg, cursor, BOUND_LESS_OR_EQUAL);
+}
+
+/**
+ *  Finds the first node that does not compare less than a key.
+ *
+ *  Equivalent to AvlTree_lower_bound.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The first node that compares greater than or equal to
+ *           key, if there is one.
+ */
+const AvlNode* AvlTree_ceiling(const AvlTree *self, const void *key,
+                               AvlHetComparator compare, void *arg, AvlCursor *cursor) {
+    assert(self);
+    assert(compare);
+
+    return bound(self, key, compare, arg, cursor, BOUND_GREATER_OR_EQUAL);
+}
+
+/**
+ *  Visits, in order, each node in the half-open range [lo, hi).
+ *
+ *  Only the nodes inside the range and the O(log n) nodes on the path
+ *  to the first of them are touched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @param traverse Must not be NULL. Will be invoked on each node in
+ *                  the range by traverse(context, node). If it returns
+ *                  nonzero, the scan stops.
+ *  @returns The nonzero value returned by traverse if it stopped the
+ *           scan, otherwise 0.
+ */
+int AvlTree_range(const AvlTree *self, const void *lo, const void *hi,
+                  AvlHetComparator compare, void *arg, AvlTraverseCb traverse, void *context) {
+    AvlCursor cursor;
+    const AvlNode *node;
+
+    assert(self);
+    assert(compare);
+    assert(traverse);
+
+    for (node = AvlTree_lower_bound(self, lo, compare, arg, &cursor);
+         node && compare(hi, node, arg) > 0; node = AvlCursor_next(&cursor)) {
+        const int stop = traverse(context, node);
+
+        if (stop) {
+            return stop;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  Visits, in order, each node in the half-open range [lo, hi).
+ *
+ *  Only the nodes inside the range and the O(log n) nodes on the path
+ *  to the first of them are touched. traverse must not modify nodes
+ *  in a way that changes their ordering.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @param traverse Must not be NULL. Will be invoked on each node in
+ *                  the range by traverse(context, node). If it returns
+ *                  nonzero, the scan stops.
+ *  @returns The nonzero value returned by traverse if it stopped the
+ *           scan, otherwise 0.
+ */
+int AvlTree_range_mut(AvlTree *self, const void *lo, const void *hi,
+                      AvlHetComparator compare, void *arg, AvlTraverseMutCb traverse,
+                      void *context) {
+    AvlCursor cursor;
+    AvlNode *node;
+
+    assert(self);
+    assert(compare);
+    assert(traverse);
+
+    AvlTree_lower_bound(self, lo, compare, arg, &cursor);
+
+    for (node = AvlCursor_get_mut(&cursor); node && compare(hi, node, arg) > 0;
+         AvlCursor_next(&cursor), node = AvlCursor_get_mut(&cursor)) {
+        const int stop = traverse(context, node);
+
+        if (stop) {
+            return stop;
+        }
+    }
+
+    return 0;
+}
+
+static const AvlNode* bound(const AvlTree *self, const void *key, AvlHetComparator compare,
+                            void *arg, AvlCursor *cursor, Bound which) {
+    AvlNode *current;
+    AvlNode *candidate = NULL;
+    size_t depth = 0;
+    size_t candidate_depth = 0;
+
+    assert(self);
+    assert(compare);
+
+    for (current = self->root; current; ++depth) {
+        const int ordering = compare(key, current, arg);
+
+        if (cursor) {
+            assert(depth < AVL_MAX_HEIGHT);
+            cursor->path[depth] = current;
+        }
+
+        if (ordering == 0 && which != BOUND_GREATER) {
+            candidate = current;
+            candidate_depth = depth;
+
+            break;
+        }
+
+        if (which == BOUND_LESS_OR_EQUAL) {
+            if (ordering > 0) { /* current < key */
+                candidate = current;
+                candidate_depth = depth;
+                current = right_of(current);
+            } else {
+                current = left_of(current);
+            }
+        } else {
+            if (ordering < 0) { /* key < current */
+                candidate = current;
+                candidate_depth = depth;
+                current = left_of(current);
+            } else {
+                current = right_of(current);
+            }
+        }
+    }
+
+    if (cursor) {
+        cursor->tree = self;
+        cursor->depth = candidate ? candidate_depth + 1 : 0;
+    }
+
+    return candidate;
+}
+
+/* pushes node and its chain of left children onto the path */
+static const AvlNode* descend_left(AvlCursor *self, AvlNode *node) {
+    assert(self);
+
+    if (!node) {
+        return NULL;
+    }
+
+    while (1) {
+        assert(self->depth < AVL_MAX_HEIGHT);
+        self->path[self->depth] = node;
+        ++self->depth;
+
+        if (!left_of(node)) {
+            return node;
+        }
+
+        node = left_of(node);
+    }
+}
+
+/* pushes node and its chain of right children onto the path */
+static const AvlNode* descend_right(AvlCursor *self, AvlNode *node) {
+    assert(self);
+
+    if (!node) {
+        return NULL;
+    }
+
+    while (1) {
+        assert(self->depth < AVL_MAX_HEIGHT);
+        self->path[self->depth] = node;
+        ++self->depth;
+
+        if (!right_of(node)) {
+            return node;
+        }
+
+        node = right_of(node);
+    }
+}
@@ -0,0 +1,154 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "node.h"
+
+#include <assert.h>
+
+/**
+ *  Searches an AvlTree for a key, recording the path to where it
+ *  belongs.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param entry Must not be NULL. Will be initialized and positioned
+ *               at the returned node, or where key would be inserted
+ *               if NULL is returned.
+ *  @returns The node that compares equal to key, if there is one.
+ */
+AvlNode* AvlTree_entry(AvlTree *self, const void *key, AvlHetComparator compare, void *arg,
+                       AvlEntry *entry) {
+    AvlNode *current;
+
+    assert(self);
+    assert(compare);
+    assert(entry);
+
+    entry->tree = self;
+    entry->depth = 0;
+    entry->ordering = 0;
+
+    for (current = self->root; current; ++entry->depth) {
+        assert(entry->depth < AVL_MAX_HEIGHT);
+        entry->path[entry->depth] = current;
+        entry->ordering = compare(key, current, arg);
+
+        if (entry->ordering == 0) {
+            ++entry->depth;
+
+            return current;
+        } else if (entry->ordering < 0) {
+            current = left_of(current);
+        } else { /* entry->ordering > 0 */
+            current = right_of(current);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node the entry is positioned at, or NULL if it is
+ *           positioned where a node is missing.
+ */
+const AvlNode* AvlEntry_get(const AvlEntry *self) {
+    assert(self);
+
+    if (self->depth == 0 || self->ordering != 0) {
+        return NULL;
+    }
+
+    return self->path[self->depth - 1];
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A mutable pointer to the node the entry is positioned at,
+ *           or NULL if it is positioned where a node is missing.
+ */
+AvlNode* AvlEntry_get_mut(AvlEntry *self) {
+    assert(self);
+
+    if (self->depth == 0 || self->ordering != 0) {
+        return NULL;
+    }
+
+    return self->path[self->depth - 1];
+}
+
+/**
+ *  Inserts a node at the position of an entry.
+ *
+ *  If the entry is positioned at a node, node takes its place and the
+ *  entry is moved to node. Otherwise node is linked where the entry
+ *  was positioned and the tree is rebalanced, invalidating the entry.
+ *  Makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param node Must not be NULL. Must not be in the tree. Must compare
+ *              equal to the key that was searched for.
+ *  @returns The node that node replaced, if there was one. It is not
+ *           passed to the deleter.
+ */
+AvlNode* AvlEntry_insert(AvlEntry *self, AvlNode *node) {
+    AvlNode *previous;
+
+    assert(self);
+    assert(node);
+
+    previous = AvlTree_insert_at(self->tree, self->path, self->depth, self->ordering, node);
+
+    if (previous) {
+        self->path[self->depth - 1] = node;
+    }
+
+    return previous;
+}
+
+/**
+ *  Removes the node an entry is positioned at.
+ *
+ *  Rebalances the tree along the recorded path, making no comparator
+ *  calls. The entry is invalidated.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be
+ *              positioned at a node.
+ *  @returns The node that was removed. It is not passed to the
+ *           deleter.
+ */
+AvlNode* AvlEntry_remove(AvlEntry *self) {
+    assert(self);
+    assert(self->depth > 0);
+    assert(self->ordering == 0);
+
+    return AvlTree_remove_at(self->tree, self->path, self->depth);
+}
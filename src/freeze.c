@@ -0,0 +1,182 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ *  Keys this many Eytzinger indices ahead of the current one are four
+ *  levels further down; for small keys the whole level fits in a line.
+ */
+#define PREFETCH_DISTANCE 16
+
+static void fill(AvlFrozenTree *self, size_t index, AvlCursor *cursor,
+                 AvlKeyExtractor extract, void *arg);
+
+static size_t lower_bound_index(const AvlFrozenTree *self, const void *key,
+                                AvlKeyComparator compare, void *arg);
+
+/**
+ *  Copies the keys of an AvlTree into an AvlFrozenTree.
+ *
+ *  Runs in O(n) time. The snapshot refers to the nodes of self, so it
+ *  must be dropped or rebuilt before any of them are removed or freed.
+ *  It does not see later changes to self.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param frozen Must not be NULL. Must not be initialized.
+ *  @param key_size The size of each key in bytes. Must not be 0.
+ *  @param extract Must not be NULL. Will be invoked by
+ *                 extract(node, key, arg) for each node in self, in
+ *                 order, and must write key_size bytes to key. key is
+ *                 aligned for any type whose size divides key_size.
+ */
+void AvlTree_freeze(const AvlTree *self, AvlFrozenTree *frozen, size_t key_size,
+                    AvlKeyExtractor extract, void *arg) {
+    AvlCursor cursor;
+
+    assert(self);
+    assert(frozen);
+    assert(key_size > 0);
+    assert(extract);
+
+    frozen->keys = (unsigned char*) checked_malloc((self->len + 1) * key_size);
+    frozen->nodes = (const AvlNode**) checked_malloc((self->len + 1) * sizeof(AvlNode*));
+    frozen->key_size = key_size;
+    frozen->len = self->len;
+
+    frozen->nodes[0] = NULL;
+
+    AvlCursor_new(&cursor, self);
+    AvlCursor_first(&cursor);
+    fill(frozen, 1, &cursor, extract, arg);
+    assert(!AvlCursor_get(&cursor));
+}
+
+/**
+ *  Frees the keys held by an AvlFrozenTree. The nodes are untouched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlFrozenTree_drop(AvlFrozenTree *self) {
+    assert(self);
+
+    free(self->keys);
+    free((void*) self->nodes);
+    self->keys = NULL;
+    self->nodes = NULL;
+    self->len = 0;
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must order the frozen keys the
+ *                 same way the AvlTree they were copied from orders
+ *                 their nodes. Will be invoked by
+ *                 compare(key, frozen_key, arg).
+ *  @returns The node whose key compares equal to key, if there is one.
+ */
+const AvlNode* AvlFrozenTree_get(const AvlFrozenTree *self, const void *key,
+                                 AvlKeyComparator compare, void *arg) {
+    size_t index;
+
+    assert(self);
+    assert(compare);
+
+    index = lower_bound_index(self, key, compare, arg);
+
+    if (index == 0 || compare(key, self->keys + index * self->key_size, arg) != 0) {
+        return NULL;
+    }
+
+    return self->nodes[index];
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must order the frozen keys the
+ *                 same way the AvlTree they were copied from orders
+ *                 their nodes. Will be invoked by
+ *                 compare(key, frozen_key, arg).
+ *  @returns The first node whose key does not compare less than key,
+ *           if there is one.
+ */
+const AvlNode* AvlFrozenTree_lower_bound(const AvlFrozenTree *self, const void *key,
+                                         AvlKeyComparator compare, void *arg) {
+    assert(self);
+    assert(compare);
+
+    return self->nodes[lower_bound_index(self, key, compare, arg)];
+}
+
+/* writes the nodes from cursor onwards to the subtree rooted at index, in order */
+static void fill(AvlFrozenTree *self, size_t index, AvlCursor *cursor,
+                 AvlKeyExtractor extract, void *arg) {
+    const AvlNode *node;
+
+    if (index > self->len) {
+        return;
+    }
+
+    fill(self, 2 * index, cursor, extract, arg);
+
+    node = AvlCursor_get(cursor);
+    assert(node);
+    extract(node, self->keys + index * self->key_size, arg);
+    self->nodes[index] = node;
+    AvlCursor_next(cursor);
+
+    fill(self, 2 * index + 1, cursor, extract, arg);
+}
+
+/*
+ *  Descends without branching on the comparison: each step appends a
+ *  bit to index, 1 for a right turn. The lower bound is the last node
+ *  at which the search turned left, so the trailing right turns and
+ *  that left turn are shifted back off. Returns 0 if there is none.
+ */
+static size_t lower_bound_index(const AvlFrozenTree *self, const void *key,
+                                AvlKeyComparator compare, void *arg) {
+    const unsigned char *const keys = self->keys;
+    const size_t key_size = self->key_size;
+    const size_t len = self->len;
+    size_t index = 1;
+
+    while (index <= len) {
+        prefetch(keys + index * PREFETCH_DISTANCE * key_size);
+        index = 2 * index + (size_t) (compare(key, keys + index * key_size, arg) > 0);
+    }
+
+    while (index & 1) {
+        index >>= 1;
+    }
+
+    return index >> 1;
+}
@@ -0,0 +1,298 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "freeze_int.h"
+#include "mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef BLOODHOUND_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+/* the index of the i-th child of block, for i from 0 to INT_BLOCK_LEN */
+#define CHILD_OF(BLOCK, I) ((BLOCK) * (INT_BLOCK_LEN + 1) + (I) + 1)
+
+typedef struct Source {
+    AvlCursor cursor;
+    AvlIntKeyExtractor extract;
+    void *arg;
+} Source;
+
+static void fill(AvlFrozenIntTree *self, size_t block, Source *source);
+
+static size_t (*select_lower_bound_index(void))(const AvlFrozenIntTree*, AvlIntKey);
+
+/**
+ *  Copies the integer keys of an AvlTree into an AvlFrozenIntTree.
+ *
+ *  Runs in O(n) time. The snapshot refers to the nodes of self, so it
+ *  must be dropped or rebuilt before any of them are removed or freed.
+ *  It does not see later changes to self.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be ordered
+ *              by the keys that extract returns, smallest first.
+ *  @param frozen Must not be NULL. Must not be initialized.
+ *  @param extract Must not be NULL. Will be invoked by
+ *                 extract(node, arg) for each node in self, in order.
+ */
+void AvlTree_freeze_ints(const AvlTree *self, AvlFrozenIntTree *frozen,
+                         AvlIntKeyExtractor extract, void *arg) {
+    Source source;
+    size_t num_slots;
+    size_t misalignment;
+
+    assert(self);
+    assert(frozen);
+    assert(extract);
+
+    frozen->num_blocks = (self->len + INT_BLOCK_LEN - 1) / INT_BLOCK_LEN;
+    frozen->len = self->len;
+    num_slots = frozen->num_blocks * INT_BLOCK_LEN + 1;
+
+    frozen->allocation = checked_malloc(num_slots * sizeof(AvlIntKey) + CACHE_LINE_SIZE);
+    misalignment = (size_t) frozen->allocation % CACHE_LINE_SIZE;
+    frozen->keys = (AvlIntKey*) ((unsigned char*) frozen->allocation
+                                 + (CACHE_LINE_SIZE - misalignment) % CACHE_LINE_SIZE);
+    frozen->nodes = (const AvlNode**) checked_malloc(num_slots * sizeof(AvlNode*));
+
+    source.extract = extract;
+    source.arg = arg;
+    AvlCursor_new(&source.cursor, self);
+    AvlCursor_first(&source.cursor);
+    fill(frozen, 0, &source);
+    assert(!AvlCursor_get(&source.cursor));
+
+    frozen->keys[num_slots - 1] = AVL_INT_KEY_MAX;
+    frozen->nodes[num_slots - 1] = NULL;
+
+    frozen->lower_bound_index = select_lower_bound_index();
+}
+
+/**
+ *  Frees the keys held by an AvlFrozenIntTree. The nodes are untouched.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlFrozenIntTree_drop(AvlFrozenIntTree *self) {
+    assert(self);
+
+    free(self->allocation);
+    free((void*) self->nodes);
+    self->allocation = NULL;
+    self->keys = NULL;
+    self->nodes = NULL;
+    self->num_blocks = 0;
+    self->len = 0;
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node whose key is equal to key, if there is one.
+ */
+const AvlNode* AvlFrozenIntTree_get(const AvlFrozenIntTree *self, AvlIntKey key) {
+    size_t index;
+
+    assert(self);
+
+    index = self->lower_bound_index(self, key);
+
+    if (self->keys[index] != key) {
+        return NULL;
+    }
+
+    return self->nodes[index];
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The first node whose key is not less than key, if there is
+ *           one.
+ */
+const AvlNode* AvlFrozenIntTree_lower_bound(const AvlFrozenIntTree *self, AvlIntKey key) {
+    assert(self);
+
+    return self->nodes[self->lower_bound_index(self, key)];
+}
+
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing one key at a time.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+size_t int_lower_bound_index_scalar(const AvlFrozenIntTree *frozen, AvlIntKey key) {
+    size_t found = frozen->num_blocks * INT_BLOCK_LEN;
+    size_t block = 0;
+
+    while (block < frozen->num_blocks) {
+        const AvlIntKey *const keys = frozen->keys + block * INT_BLOCK_LEN;
+        size_t num_less = 0;
+        size_t i;
+
+        for (i = 0; i < INT_BLOCK_LEN; ++i) {
+            num_less += (size_t) (keys[i] < key);
+        }
+
+        if (num_less < INT_BLOCK_LEN) {
+            found = block * INT_BLOCK_LEN + num_less;
+        }
+
+        block = CHILD_OF(block, num_less);
+    }
+
+    return found;
+}
+
+#ifdef BLOODHOUND_X86_SIMD
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing four keys at a time. The processor must support SSE2.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+__attribute__((target("sse2")))
+size_t int_lower_bound_index_sse2(const AvlFrozenIntTree *frozen, AvlIntKey key) {
+    const __m128i needle = _mm_set1_epi32(key);
+    size_t found = frozen->num_blocks * INT_BLOCK_LEN;
+    size_t block = 0;
+
+    while (block < frozen->num_blocks) {
+        const __m128i *const keys = (const __m128i*) (frozen->keys + block * INT_BLOCK_LEN);
+        unsigned mask = 0;
+        size_t num_less;
+        int i;
+
+        /* bit j of mask is set if key j is less than needle */
+        for (i = 0; i < INT_BLOCK_LEN / 4; ++i) {
+            const __m128i is_less = _mm_cmpgt_epi32(needle, _mm_load_si128(keys + i));
+
+            mask |= (unsigned) _mm_movemask_ps(_mm_castsi128_ps(is_less)) << (4 * i);
+        }
+
+        num_less = (size_t) __builtin_popcount(mask);
+
+        if (num_less < INT_BLOCK_LEN) {
+            found = block * INT_BLOCK_LEN + num_less;
+        }
+
+        block = CHILD_OF(block, num_less);
+    }
+
+    return found;
+}
+
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing eight keys at a time. The processor must support AVX2.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+__attribute__((target("avx2")))
+size_t int_lower_bound_index_avx2(const AvlFrozenIntTree *frozen, AvlIntKey key) {
+    const __m256i needle = _mm256_set1_epi32(key);
+    size_t found = frozen->num_blocks * INT_BLOCK_LEN;
+    size_t block = 0;
+
+    while (block < frozen->num_blocks) {
+        const __m256i *const keys = (const __m256i*) (frozen->keys + block * INT_BLOCK_LEN);
+        const __m256i low_is_less = _mm256_cmpgt_epi32(needle, _mm256_load_si256(keys));
+        const __m256i high_is_less = _mm256_cmpgt_epi32(needle, _mm256_load_si256(keys + 1));
+        size_t num_less;
+
+        num_less = (size_t) __builtin_popcount(
+            (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(low_is_less))
+            | (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(high_is_less)) << 8
+        );
+
+        if (num_less < INT_BLOCK_LEN) {
+            found = block * INT_BLOCK_LEN + num_less;
+        }
+
+        block = CHILD_OF(block, num_less);
+    }
+
+    return found;
+}
+#endif
+
+/*
+ *  Fills the subtree rooted at block from source, in order. Blocks
+ *  past the last node are padded with AVL_INT_KEY_MAX.
+ */
+static void fill(AvlFrozenIntTree *self, size_t block, Source *source) {
+    size_t i;
+
+    if (block >= self->num_blocks) {
+        return;
+    }
+
+    for (i = 0; i < INT_BLOCK_LEN; ++i) {
+        const size_t index = block * INT_BLOCK_LEN + i;
+        const AvlNode *node;
+
+        fill(self, CHILD_OF(block, i), source);
+
+        node = AvlCursor_get(&source->cursor);
+
+        if (node) {
+            self->keys[index] = source->extract(node, source->arg);
+            self->nodes[index] = node;
+            AvlCursor_next(&source->cursor);
+        } else {
+            self->keys[index] = AVL_INT_KEY_MAX;
+            self->nodes[index] = NULL;
+        }
+    }
+
+    fill(self, CHILD_OF(block, INT_BLOCK_LEN), source);
+}
+
+/* picks the widest search that this processor supports */
+static size_t (*select_lower_bound_index(void))(const AvlFrozenIntTree*, AvlIntKey) {
+#ifdef BLOODHOUND_X86_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return int_lower_bound_index_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return int_lower_bound_index_sse2;
+    }
+#endif
+
+    return int_lower_bound_index_scalar;
+}
@@ -0,0 +1,82 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef BLOODHOUND_IMPL_FREEZE_INT_H
+#define BLOODHOUND_IMPL_FREEZE_INT_H
+
+#include <bloodhound.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the number of keys in each block of an AvlFrozenIntTree */
+#define INT_BLOCK_LEN 16
+
+/* defined if the SSE2 and AVX2 searches are compiled in */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && INT_MAX == 0x7fffffffL
+#define BLOODHOUND_X86_SIMD
+#endif
+
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing one key at a time.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+size_t int_lower_bound_index_scalar(const AvlFrozenIntTree *frozen, AvlIntKey key);
+
+#ifdef BLOODHOUND_X86_SIMD
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing four keys at a time. The processor must support SSE2.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+size_t int_lower_bound_index_sse2(const AvlFrozenIntTree *frozen, AvlIntKey key);
+
+/**
+ *  Finds the first key in a frozen tree that is not less than a key,
+ *  comparing eight keys at a time. The processor must support AVX2.
+ *
+ *  @param frozen Must not be NULL. Must be initialized.
+ *  @returns The index of the first key not less than key, or
+ *           frozen->num_blocks * INT_BLOCK_LEN if every key is less.
+ */
+size_t int_lower_bound_index_avx2(const AvlFrozenIntTree *frozen, AvlIntKey key);
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,473 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include <assert.h>
+
+#define BALANCE_BIT ((AvlIndex) 0x80000000UL)
+#define INDEX_BITS ((AvlIndex) 0x7fffffffUL)
+
+/* the path from the root to a position in the tree */
+typedef struct IndexPath {
+    AvlIndex nodes[AVL_MAX_HEIGHT];
+    unsigned char is_left[AVL_MAX_HEIGHT];
+    size_t depth;
+} IndexPath;
+
+static AvlIndex left_of(const AvlIndexNode *node);
+
+static AvlIndex right_of(const AvlIndexNode *node);
+
+static int balance_factor_of(const AvlIndexNode *node);
+
+static void set_left(AvlIndexNode *node, AvlIndex child);
+
+static void set_right(AvlIndexNode *node, AvlIndex child);
+
+static void set_balance_factor(AvlIndexNode *node, int balance_factor);
+
+static void link_at(AvlIndexTree *self, const IndexPath *path, size_t depth, AvlIndex child);
+
+static AvlIndex rotate(AvlIndexNode *nodes, AvlIndex top, int balance_factor, int *is_shorter);
+
+/**
+ *  Initializes an empty AvlIndexTree.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param nodes Must not be NULL. Must have an element for every index
+ *               that will be inserted. Must outlive self.
+ *  @param compare Must not be NULL. Will be invoked to compare
+ *                 elements by compare(lhs, rhs, compare_arg). Must
+ *                 form a total ordering over the inserted indices.
+ */
+void AvlIndexTree_new(AvlIndexTree *self, AvlIndexNode *nodes, AvlIndexComparator compare,
+                      void *compare_arg) {
+    assert(self);
+    assert(nodes);
+    assert(compare);
+
+    self->nodes = nodes;
+    self->root = AVL_INDEX_NIL;
+    self->len = 0;
+    self->compare = compare;
+    self->compare_arg = compare_arg;
+}
+
+/**
+ *  Removes every element from an AvlIndexTree in O(1) time.
+ *
+ *  The node array is owned by the caller, so nothing is freed.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlIndexTree_clear(AvlIndexTree *self) {
+    assert(self);
+
+    self->root = AVL_INDEX_NIL;
+    self->len = 0;
+}
+
+/**
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one passed to
+ *                 AvlIndexTree_new. Will be invoked by
+ *                 compare(key, index, arg).
+ *  @returns The index of the element that compares equal to key, or
+ *           AVL_INDEX_NIL if there is none.
+ */
+AvlIndex AvlIndexTree_get(const AvlIndexTree *self, const void *key,
+                          AvlIndexHetComparator compare, void *arg) {
+    AvlIndex current;
+
+    assert(self);
+    assert(compare);
+
+    current = self->root;
+
+    while (current != AVL_INDEX_NIL) {
+        const int ordering = compare(key, current, arg);
+
+        if (ordering == 0) {
+            return current;
+        } else if (ordering < 0) {
+            current = left_of(&self->nodes[current]);
+        } else { /* ordering > 0 */
+            current = right_of(&self->nodes[current]);
+        }
+    }
+
+    return AVL_INDEX_NIL;
+}
+
+/**
+ *  Inserts an element into an AvlIndexTree.
+ *
+ *  If an element compares equal to index, index takes its place and
+ *  it is unlinked from the tree.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param index Must not be greater than AVL_INDEX_MAX. Must not be
+ *               in the tree.
+ *  @returns The index of the element that compared equal to index, or
+ *           AVL_INDEX_NIL if there was none.
+ */
+AvlIndex AvlIndexTree_insert(AvlIndexTree *self, AvlIndex index) {
+    AvlIndexNode *nodes;
+    IndexPath path;
+    AvlIndex current;
+
+    assert(self);
+    assert(index <= AVL_INDEX_MAX);
+
+    nodes = self->nodes;
+    path.depth = 0;
+
+    for (current = self->root; current != AVL_INDEX_NIL;) {
+        const int ordering = self->compare(index, current, self->compare_arg);
+
+        if (ordering == 0) {
+            /* copies the links along with the balance bits */
+            nodes[index] = nodes[current];
+            link_at(self, &path, path.depth, index);
+
+            nodes[current].left = AVL_INDEX_NIL;
+            nodes[current].right = AVL_INDEX_NIL;
+
+            return current;
+        }
+
+        assert(path.depth < AVL_MAX_HEIGHT);
+        path.nodes[path.depth] = current;
+        path.is_left[path.depth] = (unsigned char) (ordering < 0);
+        ++path.depth;
+
+        if (ordering < 0) {
+            current = left_of(&nodes[current]);
+        } else {
+            current = right_of(&nodes[current]);
+        }
+    }
+
+    nodes[index].left = AVL_INDEX_NIL;
+    nodes[index].right = AVL_INDEX_NIL;
+    link_at(self, &path, path.depth, index);
+    ++self->len;
+
+    /* walk back up until a subtree stops growing */
+    while (path.depth > 0) {
+        const size_t depth = --path.depth;
+        const AvlIndex node = path.nodes[depth];
+        const int balance_factor =
+            balance_factor_of(&nodes[node]) + (path.is_left[depth] ? -1 : 1);
+
+        if (balance_factor == 0) {
+            set_balance_factor(&nodes[node], 0);
+
+            break;
+        } else if (balance_factor == 1 || balance_factor == -1) {
+            set_balance_factor(&nodes[node], balance_factor);
+        } else {
+            int is_shorter;
+
+            link_at(self, &path, depth, rotate(nodes, node, balance_factor, &is_shorter));
+
+            break;
+        }
+    }
+
+    return AVL_INDEX_NIL;
+}
+
+/**
+ *  Removes the element that compares equal to a key.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one passed to
+ *                 AvlIndexTree_new. Will be invoked by
+ *                 compare(key, index, arg).
+ *  @returns The index of the removed element, or AVL_INDEX_NIL if no
+ *           element compared equal to key.
+ */
+AvlIndex AvlIndexTree_remove(AvlIndexTree *self, const void *key,
+                             AvlIndexHetComparator compare, void *arg) {
+    AvlIndexNode *nodes;
+    IndexPath path;
+    AvlIndex target;
+
+    assert(self);
+    assert(compare);
+
+    nodes = self->nodes;
+    path.depth = 0;
+
+    for (target = self->root; target != AVL_INDEX_NIL;) {
+        const int ordering = compare(key, target, arg);
+
+        if (ordering == 0) {
+            break;
+        }
+
+        assert(path.depth < AVL_MAX_HEIGHT);
+        path.nodes[path.depth] = target;
+        path.is_left[path.depth] = (unsigned char) (ordering < 0);
+        ++path.depth;
+
+        if (ordering < 0) {
+            target = left_of(&nodes[target]);
+        } else {
+            target = right_of(&nodes[target]);
+        }
+    }
+
+    if (target == AVL_INDEX_NIL) {
+        return AVL_INDEX_NIL;
+    }
+
+    if (left_of(&nodes[target]) != AVL_INDEX_NIL && right_of(&nodes[target]) != AVL_INDEX_NIL) {
+        /* unlink the in-order successor, then put it where target was */
+        const size_t target_depth = path.depth;
+        AvlIndex successor;
+
+        path.nodes[path.depth] = target;
+        path.is_left[path.depth] = 0;
+        ++path.depth;
+
+        for (successor = right_of(&nodes[target]); left_of(&nodes[successor]) != AVL_INDEX_NIL;
+             successor = left_of(&nodes[successor])) {
+            assert(path.depth < AVL_MAX_HEIGHT);
+            path.nodes[path.depth] = successor;
+            path.is_left[path.depth] = 1;
+            ++path.depth;
+        }
+
+        link_at(self, &path, path.depth, right_of(&nodes[successor]));
+
+        nodes[successor] = nodes[target];
+        link_at(self, &path, target_depth, successor);
+        path.nodes[target_depth] = successor;
+    } else if (left_of(&nodes[target]) != AVL_INDEX_NIL) {
+        link_at(self, &path, path.depth, left_of(&nodes[target]));
+    } else {
+        link_at(self, &path, path.depth, right_of(&nodes[target]));
+    }
+
+    nodes[target].left = AVL_INDEX_NIL;
+    nodes[target].right = AVL_INDEX_NIL;
+    --self->len;
+
+    /* walk back up until a subtree stops shrinking */
+    while (path.depth > 0) {
+        const size_t depth = --path.depth;
+        const AvlIndex node = path.nodes[depth];
+        const int balance_factor =
+            balance_factor_of(&nodes[node]) + (path.is_left[depth] ? 1 : -1);
+
+        if (balance_factor == 1 || balance_factor == -1) {
+            set_balance_factor(&nodes[node], balance_factor);
+
+            break;
+        } else if (balance_factor == 0) {
+            set_balance_factor(&nodes[node], 0);
+        } else {
+            int is_shorter;
+
+            link_at(self, &path, depth, rotate(nodes, node, balance_factor, &is_shorter));
+
+            if (!is_shorter) {
+                break;
+            }
+        }
+    }
+
+    return target;
+}
+
+/**
+ *  Visits every element of an AvlIndexTree in order.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param traverse Must not be NULL. Will be invoked by
+ *                  traverse(context, index) for each element, in order,
+ *                  until it returns nonzero.
+ *  @returns The nonzero value returned by traverse, or 0 if every
+ *           element was visited.
+ */
+int AvlIndexTree_traverse(const AvlIndexTree *self, AvlIndexTraverseCb traverse,
+                          void *context) {
+    AvlIndex stack[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    AvlIndex current;
+
+    assert(self);
+    assert(traverse);
+
+    current = self->root;
+
+    while (current != AVL_INDEX_NIL || depth > 0) {
+        int result;
+
+        for (; current != AVL_INDEX_NIL; current = left_of(&self->nodes[current])) {
+            assert(depth < AVL_MAX_HEIGHT);
+            stack[depth++] = current;
+        }
+
+        current = stack[--depth];
+        result = traverse(context, current);
+
+        if (result != 0) {
+            return result;
+        }
+
+        current = right_of(&self->nodes[current]);
+    }
+
+    return 0;
+}
+
+static AvlIndex left_of(const AvlIndexNode *node) {
+    return node->left & INDEX_BITS;
+}
+
+static AvlIndex right_of(const AvlIndexNode *node) {
+    return node->right & INDEX_BITS;
+}
+
+static int balance_factor_of(const AvlIndexNode *node) {
+    return ((node->right & BALANCE_BIT) ? 1 : 0) - ((node->left & BALANCE_BIT) ? 1 : 0);
+}
+
+static void set_left(AvlIndexNode *node, AvlIndex child) {
+    node->left = (node->left & BALANCE_BIT) | child;
+}
+
+static void set_right(AvlIndexNode *node, AvlIndex child) {
+    node->right = (node->right & BALANCE_BIT) | child;
+}
+
+static void set_balance_factor(AvlIndexNode *node, int balance_factor) {
+    assert(balance_factor >= -1 && balance_factor <= 1);
+
+    node->left = (node->left & INDEX_BITS) | ((balance_factor < 0) ? BALANCE_BIT : 0);
+    node->right = (node->right & INDEX_BITS) | ((balance_factor > 0) ? BALANCE_BIT : 0);
+}
+
+/* makes child the root, or the child of path->nodes[depth - 1] in the recorded direction */
+static void link_at(AvlIndexTree *self, const IndexPath *path, size_t depth, AvlIndex child) {
+    if (depth == 0) {
+        self->root = child;
+    } else if (path->is_left[depth - 1]) {
+        set_left(&self->nodes[path->nodes[depth - 1]], child);
+    } else {
+        set_right(&self->nodes[path->nodes[depth - 1]], child);
+    }
+}
+
+/**
+ *  Restores the AVL condition at a node whose balance factor would be
+ *  2 or -2, which cannot be stored in its links.
+ *
+ *  The balance factors after each rotation are the same as those set
+ *  by rotate_left, rotate_rightleft and their mirrors in node.c, with
+ *  the cases for a balanced child taken from removal.
+ *
+ *  @param is_shorter Will be set to whether the rebalanced subtree is
+ *                    shorter than it was with balance_factor at top.
+ *  @returns The new root of the subtree.
+ */
+static AvlIndex rotate(AvlIndexNode *nodes, AvlIndex top, int balance_factor, int *is_shorter) {
+    assert(nodes);
+    assert(balance_factor == 2 || balance_factor == -2);
+    assert(is_shorter);
+
+    if (balance_factor == 2) {
+        const AvlIndex middle_or_bottom = right_of(&nodes[top]);
+        const int child_balance_factor = balance_factor_of(&nodes[middle_or_bottom]);
+
+        if (child_balance_factor >= 0) {
+            const AvlIndex bottom = middle_or_bottom;
+
+            set_right(&nodes[top], left_of(&nodes[bottom]));
+            set_left(&nodes[bottom], top);
+
+            set_balance_factor(&nodes[top], (child_balance_factor == 0) ? 1 : 0);
+            set_balance_factor(&nodes[bottom], (child_balance_factor == 0) ? -1 : 0);
+            *is_shorter = child_balance_factor != 0;
+
+            return bottom;
+        } else {
+            const AvlIndex middle = middle_or_bottom;
+            const AvlIndex bottom = left_of(&nodes[middle]);
+            const int bottom_balance_factor = balance_factor_of(&nodes[bottom]);
+
+            set_right(&nodes[top], left_of(&nodes[bottom]));
+            set_left(&nodes[middle], right_of(&nodes[bottom]));
+            set_left(&nodes[bottom], top);
+            set_right(&nodes[bottom], middle);
+
+            set_balance_factor(&nodes[top], (bottom_balance_factor == 1) ? -1 : 0);
+            set_balance_factor(&nodes[middle], (bottom_balance_factor == -1) ? 1 : 0);
+            set_balance_factor(&nodes[bottom], 0);
+            *is_shorter = 1;
+
+            return bottom;
+        }
+    } else {
+        const AvlIndex middle_or_bottom = left_of(&nodes[top]);
+        const int child_balance_factor = balance_factor_of(&nodes[middle_or_bottom]);
+
+        if (child_balance_factor <= 0) {
+            const AvlIndex bottom = middle_or_bottom;
+
+            set_left(&nodes[top], right_of(&nodes[bottom]));
+            set_right(&nodes[bottom], top);
+
+            set_balance_factor(&nodes[top], (child_balance_factor == 0) ? -1 : 0);
+            set_balance_factor(&nodes[bottom], (child_balance_factor == 0) ? 1 : 0);
+            *is_shorter = child_balance_factor != 0;
+
+            return bottom;
+        } else {
+            const AvlIndex middle = middle_or_bottom;
+            const AvlIndex bottom = right_of(&nodes[middle]);
+            const int bottom_balance_factor = balance_factor_of(&nodes[bottom]);
+
+            set_left(&nodes[top], right_of(&nodes[bottom]));
+            set_right(&nodes[middle], left_of(&nodes[bottom]));
+            set_right(&nodes[bottom], top);
+            set_left(&nodes[bottom], middle);
+
+            set_balance_factor(&nodes[top], (bottom_balance_factor == -1) ? 1 : 0);
+            set_balance_factor(&nodes[middle], (bottom_balance_factor == 1) ? -1 : 0);
+            set_balance_factor(&nodes[bottom], 0);
+            *is_shorter = 1;
+
+            return bottom;
+        }
+    }
+}
@@ -0,0 +1,571 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "join.h"
+#include "node.h"
+
+#include <assert.h>
+
+static void init_empty(AvlTree *self, const AvlTree *config);
+
+static size_t count_left(const AvlTree *left, const AvlTree *right, size_t len);
+
+/**
+ *  Splits an AvlTree into the nodes that compare less than a key and
+ *  the nodes that do not.
+ *
+ *  Runs in O(log n) time if the tree tracks sizes. Otherwise, the
+ *  nodes of the smaller half are counted to find the length of each
+ *  half, which takes O(log n + min(|left|, |right|)) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Will be left
+ *              empty unless it is also left or right.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param left Must not be NULL. Will be initialized with the same
+ *              configuration as self and hold every node that compares
+ *              less than key. May be self.
+ *  @param right Must not be NULL. Will be initialized with the same
+ *               configuration as self and hold every node that
+ *               compares greater than or equal to key. May be self if
+ *               left is not.
+ */
+void AvlTree_split(AvlTree *self, const void *key, AvlHetComparator compare, void *arg,
+                   AvlTree *left, AvlTree *right) {
+    AvlTree config;
+    SplitRet split;
+
+    assert(self);
+    assert(compare);
+    assert(left);
+    assert(right);
+    assert(left != right);
+
+    config = *self;
+    init_empty(self, &config);
+    init_empty(left, &config);
+    init_empty(right, &config);
+
+    split_subtree(&config, config.root, subtree_height(config.root), key, compare, arg, &split);
+
+    left->root = split.left;
+
+    if (split.equal) {
+        size_t height;
+
+        right->root = join_subtrees(&config, NULL, 0, split.equal, split.right,
+                                    split.right_height, &height);
+    } else {
+        right->root = split.right;
+    }
+
+    if (config.tracks_sizes) {
+        left->len = subtree_size(left->root);
+    } else {
+        left->len = count_left(left, right, config.len);
+    }
+
+    right->len = config.len - left->len;
+
+    refresh_extremes(left);
+    refresh_extremes(right);
+}
+
+/**
+ *  Joins two AvlTrees and a pivot node into one AvlTree.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param left Must not be NULL. Must be initialized. Every node in
+ *              left must compare less than pivot. Will hold every node
+ *              from left and right, as well as pivot.
+ *  @param pivot Must not be NULL. Must not be in left or right.
+ *  @param right Must not be NULL. Must be initialized with the same
+ *               configuration as left. Every node in right must compare
+ *               greater than pivot. Will be left empty.
+ */
+void AvlTree_join(AvlTree *left, AvlNode *pivot, AvlTree *right) {
+    size_t height;
+
+    assert(left);
+    assert(pivot);
+    assert(is_tag_aligned(pivot));
+    assert(right);
+    assert(left != right);
+    assert(left->compare == right->compare);
+    assert(left->tracks_sizes == right->tracks_sizes);
+    assert(left->tracks_parents == right->tracks_parents);
+    assert(left->augment == right->augment);
+    assert(left->caches_extremes == right->caches_extremes);
+
+    left->root = join_subtrees(left, left->root, subtree_height(left->root), pivot,
+                               right->root, subtree_height(right->root), &height);
+    left->len += right->len + 1;
+
+    right->root = NULL;
+    right->len = 0;
+
+    refresh_extremes(left);
+    refresh_extremes(right);
+}
+
+/**
+ *  Concatenates two AvlTrees.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param left Must not be NULL. Must be initialized. Every node in
+ *              left must compare less than every node in right. Will
+ *              hold every node from left and right.
+ *  @param right Must not be NULL. Must be initialized with the same
+ *               configuration as left. Will be left empty.
+ */
+void AvlTree_concat(AvlTree *left, AvlTree *right) {
+    size_t height;
+
+    assert(left);
+    assert(right);
+    assert(left != right);
+    assert(left->compare == right->compare);
+    assert(left->tracks_sizes == right->tracks_sizes);
+    assert(left->tracks_parents == right->tracks_parents);
+    assert(left->augment == right->augment);
+    assert(left->caches_extremes == right->caches_extremes);
+
+    left->root = concat_subtrees(left, left->root, subtree_height(left->root),
+                                 right->root, subtree_height(right->root), &height);
+    left->len += right->len;
+
+    right->root = NULL;
+    right->len = 0;
+
+    refresh_extremes(left);
+    refresh_extremes(right);
+}
+
+/**
+ *  Removes every node in the half-open range [lo, hi).
+ *
+ *  The range is cut out with two splits and one join, and its nodes
+ *  are then passed to the deleter in a single sweep that neither
+ *  rebalances nor allocates. Runs in O(log n + k) time, where k is the
+ *  number of nodes removed, and makes O(log n) comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(lo, node, arg) and compare(hi, node, arg).
+ *  @returns The number of nodes that were removed.
+ */
+size_t AvlTree_remove_range(AvlTree *self, const void *lo, const void *hi,
+                            AvlHetComparator compare, void *arg) {
+    SplitRet below; /* split around lo */
+    SplitRet above; /* split of below.right around hi */
+    AvlNode *pivot;
+    size_t num_removed = 0;
+    size_t height;
+
+    assert(self);
+    assert(compare);
+
+    if (!self->root) {
+        return 0;
+    }
+
+    split_subtree(self, self->root, subtree_height(self->root), lo, compare, arg, &below);
+    split_subtree(self, below.right, below.right_height, hi, compare, arg, &above);
+    pivot = above.equal;
+
+    if (below.equal) {
+        if (compare(hi, below.equal, arg) > 0) {
+            self->deleter(below.equal, self->deleter_arg);
+            ++num_removed;
+        } else { /* hi <= lo, so the range is empty and above.equal is NULL */
+            assert(!pivot);
+            pivot = below.equal;
+        }
+    }
+
+    if (pivot) {
+        self->root = join_subtrees(self, below.left, below.left_height, pivot, above.right,
+                                   above.right_height, &height);
+    } else {
+        self->root = concat_subtrees(self, below.left, below.left_height, above.right,
+                                     above.right_height, &height);
+    }
+
+    num_removed += drop_subtree(self, above.left);
+    self->len -= num_removed;
+    refresh_extremes(self);
+
+    return num_removed;
+}
+
+static AvlNode* join_right(const AvlTree *tree, AvlNode *left, size_t left_height,
+                           AvlNode *pivot, AvlNode *right, size_t right_height,
+                           size_t *height);
+
+static AvlNode* join_left(const AvlTree *tree, AvlNode *left, size_t left_height,
+                          AvlNode *pivot, AvlNode *right, size_t right_height,
+                          size_t *height);
+
+/**
+ *  Joins two subtrees and a pivot into one subtree.
+ *
+ *  Runs in O(|left_height - right_height| + 1) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param left Every node in left must compare less than pivot.
+ *  @param left_height Must be the height of left.
+ *  @param pivot Must not be NULL. Must not be in left or right.
+ *  @param right Every node in right must compare greater than pivot.
+ *  @param right_height Must be the height of right.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                joined subtree.
+ *  @returns The root of the joined subtree.
+ */
+AvlNode* join_subtrees(const AvlTree *tree, AvlNode *left, size_t left_height, AvlNode *pivot,
+                       AvlNode *right, size_t right_height, size_t *height) {
+    assert(pivot);
+    assert(height);
+
+    if (left_height > right_height + 1) {
+        return join_right(tree, left, left_height, pivot, right, right_height, height);
+    } else if (right_height > left_height + 1) {
+        return join_left(tree, left, left_height, pivot, right, right_height, height);
+    }
+
+    set_left(pivot, left);
+    set_right(pivot, right);
+
+    return rebalance_subtree(tree, pivot, left_height, right_height, height);
+}
+
+static AvlNode* split_first(const AvlTree *tree, AvlNode *root, size_t height,
+                            AvlNode **first, size_t *rest_height);
+
+/**
+ *  Joins two subtrees into one subtree.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param left Every node in left must compare less than every node
+ *              in right.
+ *  @param left_height Must be the height of left.
+ *  @param right_height Must be the height of right.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                joined subtree.
+ *  @returns The root of the joined subtree.
+ */
+AvlNode* concat_subtrees(const AvlTree *tree, AvlNode *left, size_t left_height,
+                         AvlNode *right, size_t right_height, size_t *height) {
+    AvlNode *first;
+    AvlNode *rest;
+    size_t rest_height;
+
+    assert(height);
+
+    if (!left) {
+        *height = right_height;
+
+        return right;
+    } else if (!right) {
+        *height = left_height;
+
+        return left;
+    }
+
+    rest = split_first(tree, right, right_height, &first, &rest_height);
+
+    return join_subtrees(tree, left, left_height, first, rest, rest_height, height);
+}
+
+/**
+ *  Splits a subtree into the nodes that compare less than a key, the
+ *  nodes that compare greater than it, and the node equal to it.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param height Must be the height of root.
+ *  @param compare Must not be NULL. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param ret Must not be NULL. Will hold the split subtrees.
+ */
+void split_subtree(const AvlTree *tree, AvlNode *root, size_t height, const void *key,
+                   AvlHetComparator compare, void *arg, SplitRet *ret) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    size_t heights[AVL_MAX_HEIGHT];
+    unsigned char is_left[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    AvlNode *current = root;
+
+    assert(compare);
+    assert(ret);
+
+    ret->left = NULL;
+    ret->left_height = 0;
+    ret->right = NULL;
+    ret->right_height = 0;
+    ret->equal = NULL;
+
+    while (current) {
+        const int ordering = compare(key, current, arg);
+
+        if (ordering == 0) {
+            ret->left = left_of(current);
+            ret->left_height = left_child_height(current, height);
+            ret->right = right_of(current);
+            ret->right_height = right_child_height(current, height);
+
+            reset_node(current);
+            update_node(tree, current);
+            ret->equal = current;
+
+            break;
+        }
+
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth] = current;
+        heights[depth] = height;
+        is_left[depth] = (unsigned char) (ordering < 0);
+        ++depth;
+
+        if (ordering < 0) {
+            height = left_child_height(current, height);
+            current = left_of(current);
+        } else {
+            height = right_child_height(current, height);
+            current = right_of(current);
+        }
+    }
+
+    while (depth > 0) {
+        AvlNode *node;
+
+        --depth;
+        node = path[depth];
+
+        if (is_left[depth]) {
+            /* node and its right subtree compare greater than key */
+            ret->right = join_subtrees(tree, ret->right, ret->right_height, node, right_of(node),
+                                       right_child_height(node, heights[depth]),
+                                       &ret->right_height);
+        } else {
+            /* node and its left subtree compare less than key */
+            ret->left = join_subtrees(tree, left_of(node), left_child_height(node, heights[depth]),
+                                      node, ret->left, ret->left_height, &ret->left_height);
+        }
+    }
+}
+
+static void init_empty(AvlTree *self, const AvlTree *config) {
+    assert(self);
+    assert(config);
+
+    *self = *config;
+    self->root = NULL;
+    self->len = 0;
+}
+
+/**
+ *  Steps through both trees in lockstep until one of them runs out, so
+ *  that only the smaller tree is traversed in full.
+ *
+ *  @param len Must be the total number of nodes in left and right.
+ *  @returns The number of nodes in left.
+ */
+static size_t count_left(const AvlTree *left, const AvlTree *right, size_t len) {
+    AvlCursor left_cursor;
+    AvlCursor right_cursor;
+    const AvlNode *left_node;
+    const AvlNode *right_node;
+    size_t count = 0;
+
+    assert(left);
+    assert(right);
+
+    AvlCursor_new(&left_cursor, left);
+    AvlCursor_new(&right_cursor, right);
+    left_node = AvlCursor_first(&left_cursor);
+    right_node = AvlCursor_first(&right_cursor);
+
+    while (left_node && right_node) {
+        ++count;
+        left_node = AvlCursor_next(&left_cursor);
+        right_node = AvlCursor_next(&right_cursor);
+    }
+
+    if (!left_node) {
+        return count;
+    }
+
+    return len - count;
+}
+
+/**
+ *  Descends the right spine of left until it reaches a subtree no more
+ *  than one taller than right, links it with pivot and right, then
+ *  rebalances each node on the way back up.
+ */
+static AvlNode* join_right(const AvlTree *tree, AvlNode *left, size_t left_height,
+                           AvlNode *pivot, AvlNode *right, size_t right_height,
+                           size_t *height) {
+    AvlNode *spine[AVL_MAX_HEIGHT];
+    size_t spine_left_heights[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    AvlNode *joined;
+    size_t joined_height;
+
+    assert(left);
+    assert(pivot);
+    assert(height);
+
+    while (left_height > right_height + 1) {
+        assert(depth < AVL_MAX_HEIGHT);
+        spine[depth] = left;
+        spine_left_heights[depth] = left_child_height(left, left_height);
+        ++depth;
+
+        left_height = right_child_height(left, left_height);
+        left = right_of(left);
+    }
+
+    set_left(pivot, left);
+    set_right(pivot, right);
+    joined = rebalance_subtree(tree, pivot, left_height, right_height, &joined_height);
+
+    while (depth > 0) {
+        AvlNode *const parent = spine[--depth];
+
+        set_right(parent, joined);
+        joined = rebalance_subtree(tree, parent, spine_left_heights[depth], joined_height,
+                                   &joined_height);
+    }
+
+    *height = joined_height;
+
+    return joined;
+}
+
+/**
+ *  Descends the left spine of right until it reaches a subtree no more
+ *  than one taller than left, links it with pivot and left, then
+ *  rebalances each node on the way back up.
+ */
+static AvlNode* join_left(const AvlTree *tree, AvlNode *left, size_t left_height,
+                          AvlNode *pivot, AvlNode *right, size_t right_height,
+                          size_t *height) {
+    AvlNode *spine[AVL_MAX_HEIGHT];
+    size_t spine_right_heights[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    AvlNode *joined;
+    size_t joined_height;
+
+    assert(pivot);
+    assert(right);
+    assert(height);
+
+    while (right_height > left_height + 1) {
+        assert(depth < AVL_MAX_HEIGHT);
+        spine[depth] = right;
+        spine_right_heights[depth] = right_child_height(right, right_height);
+        ++depth;
+
+        right_height = left_child_height(right, right_height);
+        right = left_of(right);
+    }
+
+    set_left(pivot, left);
+    set_right(pivot, right);
+    joined = rebalance_subtree(tree, pivot, left_height, right_height, &joined_height);
+
+    while (depth > 0) {
+        AvlNode *const parent = spine[--depth];
+
+        set_left(parent, joined);
+        joined = rebalance_subtree(tree, parent, joined_height, spine_right_heights[depth],
+                                   &joined_height);
+    }
+
+    *height = joined_height;
+
+    return joined;
+}
+
+/**
+ *  Removes the first node of a nonempty subtree by splitting off the
+ *  left spine and joining it back together without its last node.
+ *
+ *  @returns The root of the remaining subtree.
+ */
+static AvlNode* split_first(const AvlTree *tree, AvlNode *root, size_t height,
+                            AvlNode **first, size_t *rest_height) {
+    AvlNode *spine[AVL_MAX_HEIGHT];
+    size_t heights[AVL_MAX_HEIGHT];
+    size_t depth = 0;
+    AvlNode *rest;
+
+    assert(root);
+    assert(first);
+    assert(rest_height);
+
+    while (left_of(root)) {
+        assert(depth < AVL_MAX_HEIGHT);
+        spine[depth] = root;
+        heights[depth] = height;
+        ++depth;
+
+        height = left_child_height(root, height);
+        root = left_of(root);
+    }
+
+    *first = root;
+    rest = right_of(root);
+    *rest_height = right_child_height(root, height);
+
+    set_right(root, NULL);
+    set_balance_factor(root, 0);
+    update_node(tree, root);
+
+    while (depth > 0) {
+        AvlNode *const node = spine[--depth];
+
+        rest = join_subtrees(tree, rest, *rest_height, node, right_of(node),
+                             right_child_height(node, heights[depth]), rest_height);
+    }
+
+    return rest;
+}
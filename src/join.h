@@ -0,0 +1,102 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef BLOODHOUND_IMPL_JOIN_H
+#define BLOODHOUND_IMPL_JOIN_H
+
+#include <bloodhound.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Result of splitting a subtree around a key. */
+typedef struct SplitRet {
+    AvlNode *left; /* every node that compares less than the key */
+    size_t left_height;
+    AvlNode *right; /* every node that compares greater than the key */
+    size_t right_height;
+    AvlNode *equal; /* the node that compares equal to the key, if any */
+} SplitRet;
+
+/**
+ *  Joins two subtrees and a pivot into one subtree.
+ *
+ *  Runs in O(|left_height - right_height| + 1) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param left Every node in left must compare less than pivot.
+ *  @param left_height Must be the height of left.
+ *  @param pivot Must not be NULL. Must not be in left or right.
+ *  @param right Every node in right must compare greater than pivot.
+ *  @param right_height Must be the height of right.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                joined subtree.
+ *  @returns The root of the joined subtree.
+ */
+AvlNode* join_subtrees(const AvlTree *tree, AvlNode *left, size_t left_height, AvlNode *pivot,
+                       AvlNode *right, size_t right_height, size_t *height);
+
+/**
+ *  Joins two subtrees into one subtree.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param left Every node in left must compare less than every node
+ *              in right.
+ *  @param left_height Must be the height of left.
+ *  @param right_height Must be the height of right.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                joined subtree.
+ *  @returns The root of the joined subtree.
+ */
+AvlNode* concat_subtrees(const AvlTree *tree, AvlNode *left, size_t left_height,
+                         AvlNode *right, size_t right_height, size_t *height);
+
+/**
+ *  Splits a subtree into the nodes that compare less than a key, the
+ *  nodes that compare greater than it, and the node equal to it.
+ *
+ *  Runs in O(log n) time.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param height Must be the height of root.
+ *  @param compare Must not be NULL. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @param ret Must not be NULL. Will hold the split subtrees.
+ */
+void split_subtree(const AvlTree *tree, AvlNode *root, size_t height, const void *key,
+                   AvlHetComparator compare, void *arg, SplitRet *ret);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -33,7 +33,6 @@
 
 #include <assert.h>
 #include <limits.h>
-#include <math.h>
 #include <stdlib.h>
 
 #define MAX(X, Y) (((X) < (Y)) ? (Y) : (X))
@@ -62,6 +61,105 @@ void AvlTree_new(AvlTree *self, AvlComparator compare, void *compare_arg,
     self->compare_arg = compare_arg;
     self->deleter = deleter;
     self->deleter_arg = deleter_arg;
+    self->tracks_sizes = 0;
+    self->tracks_parents = 0;
+    self->augment = NULL;
+    self->augment_arg = NULL;
+    self->caches_extremes = 0;
+    self->first = NULL;
+    self->last = NULL;
+}
+
+/**
+ *  Initializes an empty AvlTree whose nodes all belong to an arena.
+ *
+ *  The tree never frees its nodes: removed and replaced nodes are left
+ *  to the arena, and clearing or dropping the tree runs in O(1) time.
+ *  Equivalent to AvlTree_new with AvlArena_deleter as the deleter.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param compare Must not be NULL. Will be invoked to compare nodes
+ *                 by compare(lhs, rhs, compare_arg).
+ *  @param arena The allocator that owns every node. Need not be an
+ *               AvlArena; it is only recorded as the deleter argument.
+ */
+void AvlTree_new_in_arena(AvlTree *self, AvlComparator compare, void *compare_arg,
+                          void *arena) {
+    AvlTree_new(self, compare, compare_arg, AvlArena_deleter, arena);
+}
+
+/**
+ *  Makes an AvlTree keep track of the size of each subtree.
+ *
+ *  Trees that track sizes support AvlTree_select and AvlTree_rank.
+ *  Every node inserted into the tree must be the AvlNode member of an
+ *  AvlSizedNode.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *              Must not track parents.
+ */
+void AvlTree_enable_sizes(AvlTree *self) {
+    assert(self);
+    assert(!self->root);
+    assert(!self->tracks_parents);
+
+    self->tracks_sizes = 1;
+}
+
+/**
+ *  Makes an AvlTree keep a link from each node to its parent.
+ *
+ *  Trees that track parents support AvlTree_next, AvlTree_prev and
+ *  AvlTree_remove_node. Every node inserted into the tree must be the
+ *  AvlNode member of an AvlParentNode. A tree cannot track both sizes
+ *  and parents.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *              Must not track sizes.
+ */
+void AvlTree_enable_parents(AvlTree *self) {
+    assert(self);
+    assert(!self->root);
+    assert(!self->tracks_sizes);
+
+    self->tracks_parents = 1;
+}
+
+/**
+ *  Makes an AvlTree keep pointers to its first and last nodes.
+ *
+ *  AvlTree_first and AvlTree_last then run in O(1) time instead of
+ *  walking a spine of the tree. Keeping the pointers costs a pointer
+ *  comparison per insertion and a walk down one spine whenever the
+ *  first or last node is removed.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlTree_enable_extremes(AvlTree *self) {
+    assert(self);
+
+    self->caches_extremes = 1;
+    refresh_extremes(self);
+}
+
+/**
+ *  Makes an AvlTree maintain a user-defined aggregate on each node.
+ *
+ *  Whenever the children of a node change, the tree recomputes that
+ *  node's aggregate by calling augment(node, augment_arg). When augment
+ *  is called, the aggregates of node's children are up to date, so
+ *  augment can combine them with node's own value to summarize the
+ *  whole subtree.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must be empty.
+ *  @param augment If NULL, no aggregate is maintained.
+ */
+void AvlTree_set_augmenter(AvlTree *self, AvlAugmenter augment, void *augment_arg) {
+    assert(self);
+    assert(!self->root);
+
+    self->augment = augment;
+    self->augment_arg = augment_arg;
 }
 
 /**
@@ -77,6 +175,15 @@ void AvlTree_drop(AvlTree *self) {
     AvlTree_clear(self);
 }
 
+/* the number of searches that AvlTree_get_batch runs together */
+#define BATCH_WIDTH 16
+
+/* one of the searches run by AvlTree_get_batch */
+typedef struct BatchSearch {
+    size_t index; /* of the key being searched for */
+    const AvlNode *current;
+} BatchSearch;
+
 static AvlNode* find(AvlNode *root, const void *key, AvlHetComparator comparator, void *arg);
 
 /**
@@ -112,6 +219,88 @@ AvlNode* AvlTree_get_mut(AvlTree *self, const void *key, AvlHetComparator compar
     return find(self->root, key, compare, arg);
 }
 
+/**
+ *  Looks up many keys at once.
+ *
+ *  Up to 16 searches descend the tree together. Each time one of them
+ *  steps to a child, that child is prefetched and the other searches
+ *  take their next steps before it is compared, so the cache misses of
+ *  different searches overlap instead of happening one after another.
+ *  A finished search is replaced by the next key. This pays off for
+ *  trees too large for the cache; small trees are searched faster by
+ *  calling AvlTree_get in a loop.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param keys Must not be NULL unless n is 0. Must hold n keys.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(keys[i], node, arg).
+ *  @param found Must not be NULL unless n is 0. Must have room for n
+ *               elements. found[i] will be set to the node that
+ *               compares equal to keys[i], or NULL if there is none.
+ */
+void AvlTree_get_batch(const AvlTree *self, const void *const *keys, size_t n,
+                       AvlHetComparator compare, void *arg, const AvlNode **found) {
+    BatchSearch searches[BATCH_WIDTH];
+    size_t num_searches = 0;
+    size_t num_started = 0;
+
+    assert(self);
+    assert(keys || n == 0);
+    assert(compare);
+    assert(found || n == 0);
+
+    if (!self->root) {
+        for (; num_started < n; ++num_started) {
+            found[num_started] = NULL;
+        }
+
+        return;
+    }
+
+    for (; num_searches < BATCH_WIDTH && num_started < n; ++num_searches, ++num_started) {
+        searches[num_searches].index = num_started;
+        searches[num_searches].current = self->root;
+    }
+
+    while (num_searches > 0) {
+        size_t i = 0;
+
+        while (i < num_searches) {
+            BatchSearch *const search = &searches[i];
+            const int ordering = compare(keys[search->index], search->current, arg);
+            const AvlNode *next = NULL;
+
+            if (ordering < 0) {
+                next = left_of(search->current);
+            } else if (ordering > 0) {
+                next = right_of(search->current);
+            }
+
+            if (next) {
+                prefetch(next);
+                search->current = next;
+                ++i;
+
+                continue;
+            }
+
+            found[search->index] = (ordering == 0) ? search->current : NULL;
+
+            /* the root is compared by every search, so it is already cached */
+            if (num_started < n) {
+                search->index = num_started;
+                search->current = self->root;
+                ++num_started;
+                ++i;
+            } else {
+                *search = searches[--num_searches];
+            }
+        }
+    }
+}
+
 static AvlNode* find(AvlNode *root, const void *key, AvlHetComparator comparator, void *arg) {
     assert(comparator);
 
@@ -125,16 +314,19 @@ static AvlNode* find(AvlNode *root, const void *key, AvlHetComparator comparator
         if (ordering == 0) {
             return root;
         } else if (ordering < 0) {
-            root = root->left;
+            root = left_of(root);
         } else { /* ordering > 0 */
-            root = root->right;
+            root = right_of(root);
         }
     }
 
     return NULL;
 }
 
-static void rebalance(const BitStack *is_left_flags, AvlNode **root_ptr, AvlNode *inserted);
+static void rebalance(const AvlTree *self, const BitStack *is_left_flags, AvlNode **root_ptr,
+                      AvlNode *inserted);
+
+static void update_path(const AvlTree *self, const NodeStack *path);
 
 typedef struct NodeOrParentRet {
     AvlNode **node_or_parent;
@@ -144,13 +336,17 @@ typedef struct NodeOrParentRet {
 
 static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
                                            AvlHetComparator compare, void *arg,
-                                           BitStack *is_left_flags);
+                                           BitStack *is_left_flags, NodeStack *path);
 
 #ifdef NDEBUG
 #define assert_correct_balance_factors(N) ((void) 0)
+#define assert_correct_sizes(T) ((void) 0)
 #else
 #define assert_correct_balance_factors(N) do_assert_balance_factors((N))
+#define assert_correct_sizes(T) \
+    ((T)->tracks_sizes ? (void) do_assert_sizes((T)->root) : (void) 0)
 static int do_assert_balance_factors(const AvlNode *node);
+static size_t do_assert_sizes(const AvlNode *node);
 #endif
 
 /* at least 96 bits - enough to traverse a tree with 2^63 - 1 nodes */
@@ -167,42 +363,52 @@ static int do_assert_balance_factors(const AvlNode *node);
 AvlNode* AvlTree_insert(AvlTree *self, AvlNode *node) {
     unsigned long is_left_flags_buf[IS_LEFT_FLAGS_BUF_SZ];
     BitStack is_left_flags;
+    AvlNode *path_buf[AVL_MAX_HEIGHT];
+    NodeStack path;
     NodeOrParentRet ret;
     AvlNode *previous;
 
     assert(self);
     assert(node);
+    assert(is_tag_aligned(node));
 
     BitStack_from_adopted_slice(&is_left_flags, is_left_flags_buf, IS_LEFT_FLAGS_BUF_SZ);
+    NodeStack_from_adopted_slice(&path, path_buf, AVL_MAX_HEIGHT);
     ret = find_node_or_parent(&self->root, node, (AvlHetComparator) self->compare,
-                                         self->compare_arg, &is_left_flags);
+                              self->compare_arg, &is_left_flags,
+                              has_metadata(self) ? &path : NULL);
 
     if (ret.is_node) {
-        previous = *ret.node_or_parent;
-        *ret.node_or_parent = node;
+        previous = link_get(ret.node_or_parent);
+        link_set(ret.node_or_parent, node);
 
-        node->left = previous->left;
-        node->right = previous->right;
-        node->balance_factor = previous->balance_factor;
+        set_left(node, left_of(previous));
+        set_right(node, right_of(previous));
+        set_balance_factor(node, balance_factor_of(previous));
+        update_node(self, node);
+        update_path(self, &path);
+        note_replaced(self, previous, node);
 
-        previous->left = NULL;
-        previous->right = NULL;
-        previous->balance_factor = 0;
+        reset_node(previous);
     } else {
         ++self->len;
 
-        *ret.node_or_parent = node;
+        link_set(ret.node_or_parent, node);
+        note_linked(self, ret.node_or_parent, node);
         previous = NULL;
-        node->left = NULL;
-        node->right = NULL;
-        node->balance_factor = 0;
+        reset_node(node);
+        update_node(self, node);
+        update_path(self, &path);
 
         if (ret.last_with_nonzero_balance_factor) {
-            rebalance(&is_left_flags, ret.last_with_nonzero_balance_factor, node);
+            rebalance(self, &is_left_flags, ret.last_with_nonzero_balance_factor, node);
             assert_correct_balance_factors(self->root);
         }
+
+        assert_correct_sizes(self);
     }
 
+    NodeStack_drop(&path);
     BitStack_drop(&is_left_flags);
 
     return previous;
@@ -231,6 +437,8 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
                                void *insert_arg, int *inserted) {
     unsigned long is_left_flags_buf[IS_LEFT_FLAGS_BUF_SZ];
     BitStack is_left_flags;
+    AvlNode *path_buf[AVL_MAX_HEIGHT];
+    NodeStack path;
     NodeOrParentRet ret;
     AvlNode *equal_or_inserted;
 
@@ -239,10 +447,12 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
     assert(insert);
 
     BitStack_from_adopted_slice(&is_left_flags, is_left_flags_buf, IS_LEFT_FLAGS_BUF_SZ);
-    ret = find_node_or_parent(&self->root, key, compare, compare_arg, &is_left_flags);
+    NodeStack_from_adopted_slice(&path, path_buf, AVL_MAX_HEIGHT);
+    ret = find_node_or_parent(&self->root, key, compare, compare_arg, &is_left_flags,
+                              has_metadata(self) ? &path : NULL);
 
     if (ret.is_node) {
-        equal_or_inserted = *ret.node_or_parent;
+        equal_or_inserted = link_get(ret.node_or_parent);
 
         if (inserted) {
             *inserted = 0;
@@ -251,23 +461,29 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
         ++self->len;
         equal_or_inserted = insert(key, insert_arg);
         assert(equal_or_inserted);
+        assert(is_tag_aligned(equal_or_inserted));
 
-        equal_or_inserted->left = NULL;
-        equal_or_inserted->right = NULL;
-        equal_or_inserted->balance_factor = 0;
+        reset_node(equal_or_inserted);
+        update_node(self, equal_or_inserted);
 
-        *ret.node_or_parent = equal_or_inserted;
+        link_set(ret.node_or_parent, equal_or_inserted);
+        note_linked(self, ret.node_or_parent, equal_or_inserted);
+        update_path(self, &path);
 
         if (inserted) {
             *inserted = 1;
         }
 
         if (ret.last_with_nonzero_balance_factor) {
-            rebalance(&is_left_flags, ret.last_with_nonzero_balance_factor, equal_or_inserted);
+            rebalance(self, &is_left_flags, ret.last_with_nonzero_balance_factor,
+                      equal_or_inserted);
             assert_correct_balance_factors(self->root);
         }
+
+        assert_correct_sizes(self);
     }
 
+    NodeStack_drop(&path);
     BitStack_drop(&is_left_flags);
 
     return equal_or_inserted;
@@ -275,7 +491,7 @@ AvlNode* AvlTree_get_or_insert(AvlTree *self, const void *key, AvlHetComparator
 
 static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
                                            AvlHetComparator compare, void *arg,
-                                           BitStack *is_left_flags) {
+                                           BitStack *is_left_flags, NodeStack *path) {
     NodeOrParentRet to_return;
 
     assert(root_ptr);
@@ -284,7 +500,7 @@ static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
 
     to_return.last_with_nonzero_balance_factor = NULL;
 
-    if (!*root_ptr) {
+    if (!link_get(root_ptr)) {
         to_return.is_node = 0;
         to_return.node_or_parent = root_ptr;
 
@@ -294,7 +510,7 @@ static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
         AvlNode **rotate_root_ptr = root_ptr;
 
         while (1) {
-            AvlNode *const current = *current_ptr;
+            AvlNode *const current = link_get(current_ptr);
             const int ordering = compare(key, current, arg);
 
             if (ordering == 0) { /* key == current */
@@ -304,11 +520,15 @@ static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
                 return to_return;
             }
 
-            if (current->balance_factor != 0) {
+            if (balance_factor_of(current) != 0) {
                 rotate_root_ptr = current_ptr;
                 BitStack_clear(is_left_flags);
             }
 
+            if (path) {
+                NodeStack_push(path, current);
+            }
+
             if (ordering < 0) { /* key < current */
                 BitStack_push_set(is_left_flags);
                 current_ptr = &current->left;
@@ -317,7 +537,7 @@ static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
                 current_ptr = &current->right;
             }
 
-            if (!*current_ptr) {
+            if (!link_get(current_ptr)) {
                 to_return.is_node = 0;
                 to_return.node_or_parent = current_ptr;
                 to_return.last_with_nonzero_balance_factor = rotate_root_ptr;
@@ -328,35 +548,110 @@ static NodeOrParentRet find_node_or_parent(AvlNode **root_ptr, const void *key,
     }
 }
 
-static void rebalance(const BitStack *is_left_flags, AvlNode **root_ptr, AvlNode *inserted) {
+static void rebalance(const AvlTree *self, const BitStack *is_left_flags, AvlNode **root_ptr,
+                      AvlNode *inserted) {
     AvlNode *current;
     size_t depth_from_root;
 
     assert(is_left_flags);
     assert(root_ptr);
-    assert(*root_ptr);
+    assert(link_get(root_ptr));
 
-    for (depth_from_root = BitStack_len(is_left_flags) - 1, current = *root_ptr;
+    for (depth_from_root = BitStack_len(is_left_flags) - 1, current = link_get(root_ptr);
          current != inserted; --depth_from_root) {
         const int is_left = BitStack_get(is_left_flags, depth_from_root);
         assert(is_left != -1);
 
         if (is_left) {
-            --current->balance_factor;
-            current = current->left;
+            adjust_balance_factor(current, -1);
+            current = left_of(current);
         } else {
-            ++current->balance_factor;
-            current = current->right;
+            adjust_balance_factor(current, 1);
+            current = right_of(current);
         }
     }
 
-    *root_ptr = rotate(*root_ptr);
+    link_set(root_ptr, rotate(self, link_get(root_ptr)));
+}
+
+/*
+ *  recomputes the metadata of each node on path, deepest first. parent
+ *  links only change below the deepest node, which is the only one
+ *  whose children changed
+ */
+static void update_path(const AvlTree *self, const NodeStack *path) {
+    size_t i;
+
+    assert(self);
+    assert(path);
+
+    if (!has_metadata(self)) {
+        return;
+    } else if (!has_subtree_metadata(self)) {
+        if (NodeStack_len(path) > 0) {
+            update_node(self, NodeStack_get(path, -1));
+        }
+
+        return;
+    }
+
+    for (i = NodeStack_len(path); i > 0; --i) {
+        update_node(self, NodeStack_get(path, (ptrdiff_t) i - 1));
+    }
+}
+
+/**
+ *  Recomputes the aggregates on the path to the node that compares
+ *  equal to a key.
+ *
+ *  Call this after modifying a node in a way that changes the
+ *  aggregate computed from it, such as changing its value through
+ *  AvlTree_get_mut.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The node that compares equal to key, if there is one.
+ */
+AvlNode* AvlTree_refresh(AvlTree *self, const void *key, AvlHetComparator compare, void *arg) {
+    AvlNode *path_buf[AVL_MAX_HEIGHT];
+    NodeStack path;
+    AvlNode *current;
+
+    assert(self);
+    assert(compare);
+
+    NodeStack_from_adopted_slice(&path, path_buf, AVL_MAX_HEIGHT);
+
+    for (current = self->root; current;) {
+        const int ordering = compare(key, current, arg);
+
+        NodeStack_push(&path, current);
+
+        if (ordering == 0) {
+            break;
+        } else if (ordering < 0) {
+            current = left_of(current);
+        } else { /* ordering > 0 */
+            current = right_of(current);
+        }
+    }
+
+    if (current) {
+        update_path(self, &path);
+    }
+
+    NodeStack_drop(&path);
+
+    return current;
 }
 
 static void remove_node(AvlTree *self, AvlNode **node_ptr, NodeStack *nodes,
                         BitStack *is_left_flags);
 
-static size_t max_height(size_t num_nodes);
+static AvlNode** link_to(AvlTree *self, AvlNode *const *path, size_t index);
 
 /**
  *  Removes the node that compares equal to a key.
@@ -369,6 +664,7 @@ static size_t max_height(size_t num_nodes);
  *  @returns The node that compared equal to key, if there was one.
  */
 AvlNode* AvlTree_remove(AvlTree *self, const void *key, AvlHetComparator compare, void *arg) {
+    AvlNode *nodes_buf[AVL_MAX_HEIGHT];
     NodeStack nodes;
     unsigned long is_left_flags_buf[IS_LEFT_FLAGS_BUF_SZ];
     BitStack is_left_flags;
@@ -379,20 +675,20 @@ AvlNode* AvlTree_remove(AvlTree *self, const void *key, AvlHetComparator compare
     assert(self);
     assert(compare);
 
-    NodeStack_with_capacity(&nodes, max_height(self->len) + 1);
+    NodeStack_from_adopted_slice(&nodes, nodes_buf, AVL_MAX_HEIGHT);
     BitStack_from_adopted_slice(&is_left_flags, is_left_flags_buf, IS_LEFT_FLAGS_BUF_SZ);
-    for (current_ptr = &self->root; *current_ptr; ++current_depth) {
-        AvlNode *const current = *current_ptr;
+    for (current_ptr = &self->root; link_get(current_ptr); ++current_depth) {
+        AvlNode *const current = link_get(current_ptr);
         const int ordering = compare(key, current, arg);
 
         NodeStack_push(&nodes, current);
 
         if (ordering == 0) {
             break; /* we got em */
-        } else if (ordering < 0 && current->left) {
+        } else if (ordering < 0 && left_of(current)) {
             current_ptr = &current->left;
             BitStack_push_set(&is_left_flags);
-        } else if (ordering > 0 && current->right) {
+        } else if (ordering > 0 && right_of(current)) {
             current_ptr = &current->right;
             BitStack_push_clear(&is_left_flags);
         } else {
@@ -403,9 +699,10 @@ AvlNode* AvlTree_remove(AvlTree *self, const void *key, AvlHetComparator compare
         }
     }
 
-    to_remove = *current_ptr;
+    to_remove = link_get(current_ptr);
     remove_node(self, current_ptr, &nodes, &is_left_flags);
     --self->len;
+    note_removed(self, to_remove);
 
     BitStack_drop(&is_left_flags);
     NodeStack_drop(&nodes);
@@ -413,6 +710,382 @@ AvlNode* AvlTree_remove(AvlTree *self, const void *key, AvlHetComparator compare
     return to_remove;
 }
 
+/**
+ *  Inserts a node at a position found by searching the tree yourself.
+ *
+ *  This is the comparison-free half of AvlTree_insert, for code that
+ *  descends the tree on its own, such as the functions generated by
+ *  AVL_DEFINE_TREE. Runs in O(log n) time and makes no comparator
+ *  calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param path Must not be NULL unless depth is 0. path[0] must be the
+ *              root and each following node a child of the one before
+ *              it. If ordering is nonzero, the child of
+ *              path[depth - 1] on the side given by ordering must be
+ *              NULL.
+ *  @param depth The number of nodes in path. Must be 0 if and only if
+ *               self is empty.
+ *  @param ordering The result of comparing node to path[depth - 1].
+ *                  If 0, node takes its place in the tree. Ignored if
+ *                  depth is 0.
+ *  @param node Must not be NULL. Must not be in the tree.
+ *  @returns The node that node replaced, if ordering was 0.
+ */
+AvlNode* AvlTree_insert_at(AvlTree *self, AvlNode *const *path, size_t depth, int ordering,
+                           AvlNode *node) {
+    unsigned long is_left_flags_buf[IS_LEFT_FLAGS_BUF_SZ];
+    BitStack is_left_flags;
+    AvlNode *previous = NULL;
+    size_t anchor;
+    size_t i;
+
+    assert(self);
+    assert(path || depth == 0);
+    assert((depth == 0) == (self->root == NULL));
+    assert(node);
+    assert(is_tag_aligned(node));
+
+    if (depth > 0 && ordering == 0) {
+        previous = path[depth - 1];
+        link_set(link_to(self, path, depth - 1), node);
+        set_left(node, left_of(previous));
+        set_right(node, right_of(previous));
+        set_balance_factor(node, balance_factor_of(previous));
+        reset_node(previous);
+        note_replaced(self, previous, node);
+    } else {
+        reset_node(node);
+
+        if (depth == 0) {
+            self->root = node;
+            note_linked(self, &self->root, node);
+        } else if (ordering < 0) {
+            assert(!left_of(path[depth - 1]));
+            set_left(path[depth - 1], node);
+            note_linked(self, &path[depth - 1]->left, node);
+        } else {
+            assert(!right_of(path[depth - 1]));
+            set_right(path[depth - 1], node);
+            note_linked(self, &path[depth - 1]->right, node);
+        }
+
+        ++self->len;
+    }
+
+    if (has_metadata(self)) {
+        update_node(self, node);
+
+        for (i = depth; i > 0; --i) {
+            update_node(self, path[i - 1]);
+
+            /* parent links only change below the node that node was linked under */
+            if (!has_subtree_metadata(self) && path[i - 1] != previous) {
+                break;
+            }
+        }
+    }
+
+    if (ordering == 0 || depth == 0) {
+        return previous;
+    }
+
+    /* the deepest node that might need rotating, as find_node_or_parent would find it */
+    for (anchor = depth - 1; anchor > 0 && balance_factor_of(path[anchor]) == 0; --anchor) { }
+
+    BitStack_from_adopted_slice(&is_left_flags, is_left_flags_buf, IS_LEFT_FLAGS_BUF_SZ);
+
+    for (i = anchor; i < depth; ++i) {
+        const AvlNode *const child = (i + 1 < depth) ? path[i + 1] : node;
+
+        if (child == left_of(path[i])) {
+            BitStack_push_set(&is_left_flags);
+        } else {
+            BitStack_push_clear(&is_left_flags);
+        }
+    }
+
+    rebalance(self, &is_left_flags, link_to(self, path, anchor), node);
+    assert_correct_balance_factors(self->root);
+    assert_correct_sizes(self);
+    BitStack_drop(&is_left_flags);
+
+    return NULL;
+}
+
+/**
+ *  Inserts an element into an AvlTree just before the position of a
+ *  cursor.
+ *
+ *  If node belongs between the cursor's node and its predecessor, it
+ *  is linked there after at most two comparisons and the tree is
+ *  rebalanced along the path to it; otherwise this falls back to
+ *  AvlTree_insert. A cursor positioned at the end hints that node is
+ *  greater than every element, so appending increasing keys only
+ *  walks the right spine and compares against the last element. The
+ *  end position survives modifications, so one such cursor can be
+ *  reused for every append.
+ *
+ *  Runs in O(log n) time even when the hint is right. The cursor
+ *  saves comparisons, not pointer chasing. An end cursor holds no
+ *  path, so each append walks the right spine from the root and is
+ *  then rebalanced through AvlTree_insert_at. Appending increasing
+ *  keys one at a time is therefore about four times slower than
+ *  AvlTree_build_sorted. Prefer that, or
+ *  AvlTree_insert_sorted_batch, when the keys arrive together.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param hint Must not be NULL. Must be positioned in self.
+ *  @param node Must not be NULL.
+ *  @returns The previous element that compares equal to node, if there
+ *           was one.
+ */
+AvlNode* AvlTree_insert_hint(AvlTree *self, const AvlCursor *hint, AvlNode *node) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    size_t depth;
+    AvlNode *current;
+    int ordering;
+
+    assert(self);
+    assert(hint);
+    assert(hint->tree == self);
+    assert(node);
+    assert(is_tag_aligned(node));
+
+    if (!self->root) {
+        return AvlTree_insert_at(self, NULL, 0, 0, node);
+    }
+
+    for (depth = 0; depth < hint->depth; ++depth) {
+        path[depth] = hint->path[depth];
+    }
+
+    if (depth == 0) {
+        current = self->root;
+    } else {
+        ordering = self->compare(node, path[depth - 1], self->compare_arg);
+
+        if (ordering == 0) {
+            return AvlTree_insert_at(self, path, depth, 0, node);
+        } else if (ordering > 0) {
+            return AvlTree_insert(self, node); /* bad hint */
+        }
+
+        current = left_of(path[depth - 1]);
+
+        if (!current) {
+            size_t i;
+
+            /* the predecessor is the deepest ancestor whose right subtree holds the hint */
+            for (i = depth - 1; i > 0 && left_of(path[i - 1]) == path[i]; --i) { }
+
+            if (i > 0) {
+                ordering = self->compare(node, path[i - 1], self->compare_arg);
+
+                if (ordering == 0) {
+                    return AvlTree_insert_at(self, path, i, 0, node);
+                } else if (ordering < 0) {
+                    return AvlTree_insert(self, node); /* bad hint */
+                }
+            }
+
+            return AvlTree_insert_at(self, path, depth, -1, node);
+        }
+    }
+
+    /* the predecessor is the rightmost node of current's subtree */
+    for (; current; current = right_of(current)) {
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth++] = current;
+    }
+
+    ordering = self->compare(node, path[depth - 1], self->compare_arg);
+
+    if (ordering < 0) {
+        return AvlTree_insert(self, node); /* bad hint */
+    }
+
+    return AvlTree_insert_at(self, path, depth, (ordering == 0) ? 0 : 1, node);
+}
+
+/**
+ *  Removes a node at a position found by searching the tree yourself.
+ *
+ *  This is the comparison-free half of AvlTree_remove. Runs in
+ *  O(log n) time and makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param path Must not be NULL. path[0] must be the root and each
+ *              following node a child of the one before it.
+ *  @param depth The number of nodes in path. Must be at least 1.
+ *  @returns path[depth - 1], which is no longer in the tree.
+ */
+AvlNode* AvlTree_remove_at(AvlTree *self, AvlNode *const *path, size_t depth) {
+    AvlNode *nodes_buf[AVL_MAX_HEIGHT];
+    NodeStack nodes;
+    unsigned long is_left_flags_buf[IS_LEFT_FLAGS_BUF_SZ];
+    BitStack is_left_flags;
+    AvlNode *const to_remove = path[depth - 1];
+    size_t i;
+
+    assert(self);
+    assert(path);
+    assert(depth > 0);
+    assert(path[0] == self->root);
+
+    NodeStack_from_adopted_slice(&nodes, nodes_buf, AVL_MAX_HEIGHT);
+    BitStack_from_adopted_slice(&is_left_flags, is_left_flags_buf, IS_LEFT_FLAGS_BUF_SZ);
+
+    for (i = 0; i < depth; ++i) {
+        NodeStack_push(&nodes, path[i]);
+
+        if (i + 1 == depth) {
+            break;
+        } else if (path[i + 1] == left_of(path[i])) {
+            BitStack_push_set(&is_left_flags);
+        } else {
+            assert(path[i + 1] == right_of(path[i]));
+            BitStack_push_clear(&is_left_flags);
+        }
+    }
+
+    remove_node(self, link_to(self, path, depth - 1), &nodes, &is_left_flags);
+    --self->len;
+    note_removed(self, to_remove);
+
+    BitStack_drop(&is_left_flags);
+    NodeStack_drop(&nodes);
+
+    return to_remove;
+}
+
+/**
+ *  Runs in O(1) time if the tree caches its extremes, otherwise in
+ *  O(log n) time. Makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that compares less than every other node, if the
+ *           tree is not empty.
+ */
+const AvlNode* AvlTree_first(const AvlTree *self) {
+    const AvlNode *current;
+
+    assert(self);
+
+    if (!self->root) {
+        return NULL;
+    } else if (self->caches_extremes) {
+        return self->first;
+    }
+
+    for (current = self->root; left_of(current); current = left_of(current)) { }
+
+    return current;
+}
+
+/**
+ *  Runs in O(1) time if the tree caches its extremes, otherwise in
+ *  O(log n) time. Makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that compares greater than every other node, if
+ *           the tree is not empty.
+ */
+const AvlNode* AvlTree_last(const AvlTree *self) {
+    const AvlNode *current;
+
+    assert(self);
+
+    if (!self->root) {
+        return NULL;
+    } else if (self->caches_extremes) {
+        return self->last;
+    }
+
+    for (current = self->root; right_of(current); current = right_of(current)) { }
+
+    return current;
+}
+
+/**
+ *  Removes the first node of an AvlTree.
+ *
+ *  Walks the left spine and rebalances along it, making no comparator
+ *  calls. The node is not passed to the deleter.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that was removed, or NULL if the tree was empty.
+ */
+AvlNode* AvlTree_pop_first(AvlTree *self) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    AvlNode *current;
+    size_t depth = 0;
+
+    assert(self);
+
+    for (current = self->root; current; current = left_of(current)) {
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth++] = current;
+    }
+
+    if (depth == 0) {
+        return NULL;
+    }
+
+    /* the new first node is the only child or else the parent, saving a walk to find it */
+    if (self->caches_extremes && depth > 1) {
+        self->first = right_of(path[depth - 1]) ? right_of(path[depth - 1]) : path[depth - 2];
+    }
+
+    return AvlTree_remove_at(self, path, depth);
+}
+
+/**
+ *  Removes the last node of an AvlTree.
+ *
+ *  Walks the right spine and rebalances along it, making no comparator
+ *  calls. The node is not passed to the deleter.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns The node that was removed, or NULL if the tree was empty.
+ */
+AvlNode* AvlTree_pop_last(AvlTree *self) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    AvlNode *current;
+    size_t depth = 0;
+
+    assert(self);
+
+    for (current = self->root; current; current = right_of(current)) {
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth++] = current;
+    }
+
+    if (depth == 0) {
+        return NULL;
+    }
+
+    /* the new last node is the only child or else the parent, saving a walk to find it */
+    if (self->caches_extremes && depth > 1) {
+        self->last = left_of(path[depth - 1]) ? left_of(path[depth - 1]) : path[depth - 2];
+    }
+
+    return AvlTree_remove_at(self, path, depth);
+}
+
+/* returns the link that points to path[index] */
+static AvlNode** link_to(AvlTree *self, AvlNode *const *path, size_t index) {
+    if (index == 0) {
+        return &self->root;
+    } else if (path[index] == left_of(path[index - 1])) {
+        return &path[index - 1]->left;
+    } else {
+        assert(path[index] == right_of(path[index - 1]));
+
+        return &path[index - 1]->right;
+    }
+}
+
 static AvlNode* swap_for_delete(NodeStack *nodes, BitStack *is_left_flags, AvlNode *node);
 
 static void update_balance_factors_and_rebalance(AvlTree *self, NodeStack *nodes,
@@ -424,32 +1097,42 @@ static void remove_node(AvlTree *self, AvlNode **node_ptr, NodeStack *nodes,
 
     assert(self);
     assert(node_ptr);
-    assert(*node_ptr);
+    assert(link_get(node_ptr));
     assert(nodes);
 
-    node = *node_ptr;
+    node = link_get(node_ptr);
+
+    if (left_of(node) && right_of(node)) {
+        AvlNode *const successor = swap_for_delete(nodes, is_left_flags, node);
 
-    if (node->left && node->right) {
-        *node_ptr = swap_for_delete(nodes, is_left_flags, *node_ptr);
-    } else if (node->left) {
-        *node_ptr = node->left;
-        node->left = NULL;
-    } else if (node->right) {
-        *node_ptr = node->right;
-        node->right = NULL;
+        link_set(node_ptr, successor);
+
+        /* update_path only fixes the parent links below the successor's old parent */
+        if (self->tracks_parents) {
+            parent_of(successor) = parent_of(node);
+            update_node(self, successor);
+        }
+    } else if (left_of(node)) {
+        link_set(node_ptr, left_of(node));
+        set_left(node, NULL);
+    } else if (right_of(node)) {
+        link_set(node_ptr, right_of(node));
+        set_right(node, NULL);
     } else {
-        *node_ptr = NULL;
+        link_set(node_ptr, NULL);
     }
 
-    node->balance_factor = 0;
+    set_balance_factor(node, 0);
 
-    assert(!node->left);
-    assert(!node->right);
+    assert(!left_of(node));
+    assert(!right_of(node));
 
     NodeStack_pop(nodes);
+    update_path(self, nodes);
 
     update_balance_factors_and_rebalance(self, nodes, is_left_flags);
     assert_correct_balance_factors(self->root);
+    assert_correct_sizes(self);
 }
 
 /* find inorder sucessor */
@@ -461,34 +1144,34 @@ static AvlNode* swap_for_delete(NodeStack *nodes, BitStack *is_left_flags, AvlNo
     assert(nodes);
     assert(is_left_flags);
     assert(node);
-    assert(node->left && node->right);
+    assert(left_of(node) && right_of(node));
 
     successor_ptr = &node->right;
     BitStack_push_clear(is_left_flags);
     assert(NodeStack_get(nodes, -1) == node);
-    swap_idx = NodeStack_push(nodes, *successor_ptr) - 2;
+    swap_idx = NodeStack_push(nodes, link_get(successor_ptr)) - 2;
 
-    while ((*successor_ptr)->left) {
-        successor_ptr = &(*successor_ptr)->left;
+    while (left_of(link_get(successor_ptr))) {
+        successor_ptr = &link_get(successor_ptr)->left;
         BitStack_push_set(is_left_flags);
-        NodeStack_push(nodes, *successor_ptr);
+        NodeStack_push(nodes, link_get(successor_ptr));
     }
 
-    successor = *successor_ptr;
+    successor = link_get(successor_ptr);
 
     assert(successor);
-    assert(!successor->left);
+    assert(!left_of(successor));
 
-    if (successor != node->right) {
-        *successor_ptr = successor->right;
-        successor->right = node->right;
+    if (successor != right_of(node)) {
+        link_set(successor_ptr, right_of(successor));
+        set_right(successor, right_of(node));
     }
 
-    successor->left = node->left;
-    successor->balance_factor = node->balance_factor;
+    set_left(successor, left_of(node));
+    set_balance_factor(successor, balance_factor_of(node));
 
-    node->right = NULL;
-    node->left = NULL;
+    set_right(node, NULL);
+    set_left(node, NULL);
 
     *NodeStack_get_mut(nodes, (ptrdiff_t) swap_idx) = successor;
 
@@ -523,105 +1206,105 @@ static void update_balance_factors_and_rebalance(AvlTree *self, NodeStack *nodes
             }
         }
 
-        assert(node == *parent_ptr);
+        assert(node == link_get(parent_ptr));
 
         if (is_left) {
-            ++node->balance_factor;
+            adjust_balance_factor(node, 1);
 
-            if (node->balance_factor == 1) {
+            if (balance_factor_of(node) == 1) {
                 return;
-            } else if (node->balance_factor == 2) {
-                AvlNode *const middle_or_bottom = node->right;
+            } else if (balance_factor_of(node) == 2) {
+                AvlNode *const middle_or_bottom = right_of(node);
                 assert(middle_or_bottom);
 
-                if (middle_or_bottom->balance_factor == -1) {
+                if (balance_factor_of(middle_or_bottom) == -1) {
                     AvlNode *const middle = middle_or_bottom;
-                    AvlNode *const bottom = middle->left;
+                    AvlNode *const bottom = left_of(middle);
 
                     assert(bottom);
 
-                    node->right = rotate_right_unchecked(middle, bottom);
-                    *parent_ptr = rotate_left_unchecked(node, bottom);
+                    set_right(node, rotate_right_unchecked(self, middle, bottom));
+                    link_set(parent_ptr, rotate_left_unchecked(self, node, bottom));
 
-                    if (bottom->balance_factor == 1) {
-                        node->balance_factor = -1;
-                        middle->balance_factor = 0;
-                    } else if (bottom->balance_factor == 0) {
-                        node->balance_factor = 0;
-                        middle->balance_factor = 0;
+                    if (balance_factor_of(bottom) == 1) {
+                        set_balance_factor(node, -1);
+                        set_balance_factor(middle, 0);
+                    } else if (balance_factor_of(bottom) == 0) {
+                        set_balance_factor(node, 0);
+                        set_balance_factor(middle, 0);
                     } else {
-                        assert(bottom->balance_factor == -1);
+                        assert(balance_factor_of(bottom) == -1);
 
-                        node->balance_factor = 0;
-                        middle->balance_factor = 1;
+                        set_balance_factor(node, 0);
+                        set_balance_factor(middle, 1);
                     }
 
-                    bottom->balance_factor = 0;
+                    set_balance_factor(bottom, 0);
                 } else {
                     AvlNode *const bottom = middle_or_bottom;
 
-                    *parent_ptr = rotate_left_unchecked(node, bottom);
+                    link_set(parent_ptr, rotate_left_unchecked(self, node, bottom));
 
-                    if (bottom->balance_factor == 0) {
-                        bottom->balance_factor = -1;
-                        node->balance_factor = 1;
+                    if (balance_factor_of(bottom) == 0) {
+                        set_balance_factor(bottom, -1);
+                        set_balance_factor(node, 1);
 
                         break;
                     } else {
-                        assert(bottom->balance_factor == 1);
+                        assert(balance_factor_of(bottom) == 1);
 
-                        bottom->balance_factor = 0;
-                        node->balance_factor = 0;
+                        set_balance_factor(bottom, 0);
+                        set_balance_factor(node, 0);
                     }
                 }
             }
         } else if (!is_left) {
-            --node->balance_factor;
+            adjust_balance_factor(node, -1);
 
-            if (node->balance_factor == -1) {
+            if (balance_factor_of(node) == -1) {
                 return;
-            } else if (node->balance_factor == -2) {
-                AvlNode *const middle_or_bottom = node->left;
+            } else if (balance_factor_of(node) == -2) {
+                AvlNode *const middle_or_bottom = left_of(node);
                 assert(middle_or_bottom);
 
-                if (middle_or_bottom->balance_factor == 1) {
+                if (balance_factor_of(middle_or_bottom) == 1) {
                     AvlNode *const middle = middle_or_bottom;
-                    AvlNode *const bottom = middle->right;
+                    AvlNode *const bottom = right_of(middle);
 
                     assert(bottom);
 
-                    node->left = rotate_left_unchecked(middle, bottom);
-                    *parent_ptr = rotate_right_unchecked(node, bottom);
+                    set_left(node, rotate_left_unchecked(self, middle, bottom));
+                    link_set(parent_ptr, rotate_right_unchecked(self, node, bottom));
 
-                    if (bottom->balance_factor == -1) {
-                        node->balance_factor = 1;
-                        middle->balance_factor = 0;
-                    } else if (bottom->balance_factor == 0) {
-                        node->balance_factor = 0;
-                        middle->balance_factor = 0;
+                    if (balance_factor_of(bottom) == -1) {
+                        set_balance_factor(node, 1);
+                        set_balance_factor(middle, 0);
+                    } else if (balance_factor_of(bottom) == 0) {
+                        set_balance_factor(node, 0);
+                        set_balance_factor(middle, 0);
                     } else {
-                        assert(bottom->balance_factor == 1);
+                        assert(balance_factor_of(bottom) == 1);
 
-                        node->balance_factor = 0;
-                        middle->balance_factor = -1;
+                        set_balance_factor(node, 0);
+                        set_balance_factor(middle, -1);
                     }
 
-                    bottom->balance_factor = 0;
+                    set_balance_factor(bottom, 0);
                 } else {
                     AvlNode *const bottom = middle_or_bottom;
 
-                    *parent_ptr = rotate_right_unchecked(node, bottom);
+                    link_set(parent_ptr, rotate_right_unchecked(self, node, bottom));
 
-                    if (bottom->balance_factor == 0) {
-                        bottom->balance_factor = 1;
-                        node->balance_factor = -1;
+                    if (balance_factor_of(bottom) == 0) {
+                        set_balance_factor(bottom, 1);
+                        set_balance_factor(node, -1);
 
                         break;
                     } else {
-                        assert(bottom->balance_factor == -1);
+                        assert(balance_factor_of(bottom) == -1);
 
-                        bottom->balance_factor = 0;
-                        node->balance_factor = 0;
+                        set_balance_factor(bottom, 0);
+                        set_balance_factor(node, 0);
                     }
                 }
             }
@@ -629,19 +1312,13 @@ static void update_balance_factors_and_rebalance(AvlTree *self, NodeStack *nodes
     }
 }
 
-static double log2(double x);
-
-static size_t max_height(size_t num_nodes) {
-    return (size_t) ceil(1.44 * log2((double) num_nodes + 1.065) - 0.328);
-}
-
-static double log2(double x) {
-    return log(x) / log(2.0);
-}
-
 /**
  *  Clears the tree, removing all members.
  *
+ *  Runs in O(1) time if the deleter is AvlArena_deleter. If the
+ *  deleter is AvlNodePool_deleter and every node in the pool belongs
+ *  to this tree, the pool is reset instead of visiting each node.
+ *
  *  @param self Must not be NULL. Must be initialized.
  */
 void AvlTree_clear(AvlTree *self) {
@@ -649,19 +1326,38 @@ void AvlTree_clear(AvlTree *self) {
 
     assert(self);
 
+    self->first = NULL;
+    self->last = NULL;
+
     if (!self->root) {
         return;
     }
 
+    if (self->deleter == AvlArena_deleter) {
+        self->len = 0;
+        self->root = NULL;
+
+        return;
+    }
+
+    if (self->deleter == AvlNodePool_deleter
+        && ((const AvlNodePool*) self->deleter_arg)->len == self->len) {
+        AvlNodePool_reset((AvlNodePool*) self->deleter_arg);
+        self->len = 0;
+        self->root = NULL;
+
+        return;
+    }
+
     current = self->root;
     while (current) {
         AvlNode *next;
 
-        while (current->left) {
-            current = rotate_right_unchecked(current, current->left);
+        while (left_of(current)) {
+            current = rotate_right_unchecked(NULL, current, left_of(current));
         }
 
-        next = current->right;
+        next = right_of(current);
         self->deleter(current, self->deleter_arg);
         current = next;
     }
@@ -675,14 +1371,26 @@ static int do_assert_balance_factors(const AvlNode *node) {
     if (!node) {
         return 0;
     } else {
-        const int left_height = assert_correct_balance_factors(node->left);
-        const int right_height = assert_correct_balance_factors(node->right);
+        const int left_height = assert_correct_balance_factors(left_of(node));
+        const int right_height = assert_correct_balance_factors(right_of(node));
 
         const signed char balance_factor = (signed char) (right_height - left_height);
 
-        assert(node->balance_factor == balance_factor);
+        assert(balance_factor_of(node) == balance_factor);
 
         return MAX(left_height, right_height) + 1;
     }
 }
+
+static size_t do_assert_sizes(const AvlNode *node) {
+    if (!node) {
+        return 0;
+    } else {
+        const size_t size = do_assert_sizes(left_of(node)) + do_assert_sizes(right_of(node)) + 1;
+
+        assert(subtree_size(node) == size);
+
+        return size;
+    }
+}
 #endif
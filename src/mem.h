@@ -33,6 +33,22 @@
 extern "C" {
 #endif
 
+/* a type whose alignment is at least that of any object type */
+typedef union MaxAlign {
+    void *pointer;
+    void (*function)(void);
+    long integer;
+    double floating;
+    long double long_floating;
+} MaxAlign;
+
+/* hints that the cache line holding P will be read soon; P need not be valid */
+#ifdef __GNUC__
+#define prefetch(P) __builtin_prefetch(P)
+#else
+#define prefetch(P) ((void) 0)
+#endif
+
 /**
  *  Allocates uninitialized memory.
  *
@@ -27,6 +27,14 @@
 #include "node.h"
 
 #include <assert.h>
+#include <stddef.h>
+
+static void inherit_parent(const AvlTree *tree, AvlNode *node, AvlNode *replaced);
+
+#ifdef AVL_TAGGED_NODES
+/* fails to compile unless node pointers leave their two low bits free for tags */
+typedef char TagBitsCheck[(offsetof(struct { char c; AvlNode *node; }, node) >= 4) ? 1 : -1];
+#endif
 
 /**
  *  Automatically selects a rotation to execute on a tree.
@@ -39,47 +47,49 @@
  *  child has a balance factor of 1, executes a left-right rotation
  *  around root.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param root Must not be NULL. Must have a left or right child,
  *              depending on its balance factor, which may also then
  *              require a left or right child.
  *  @returns The new root of the tree.
  */
-AvlNode* rotate(AvlNode *root) {
+AvlNode* rotate(const AvlTree *tree, AvlNode *root) {
     assert(root);
 
-    if (root->balance_factor == -2) {
-        AvlNode *const middle_or_bottom = root->left;
+    if (balance_factor_of(root) == -2) {
+        AvlNode *const middle_or_bottom = left_of(root);
         assert(middle_or_bottom);
 
-        if (middle_or_bottom->balance_factor == -1) {
+        if (balance_factor_of(middle_or_bottom) == -1) {
             AvlNode *const bottom = middle_or_bottom;
 
-            return rotate_right(root, bottom);
+            return rotate_right(tree, root, bottom);
         } else { /* middle_or_bottom->balance_factor == 1 */
             AvlNode *const middle = middle_or_bottom;
-            AvlNode *const bottom = middle->right;
+            AvlNode *const bottom = right_of(middle);
 
-            assert(middle->balance_factor == 1);
+            assert(balance_factor_of(middle) == 1);
             assert(bottom);
 
-            return rotate_leftright(root, middle, bottom);
+            return rotate_leftright(tree, root, middle, bottom);
         }
-    } else if (root->balance_factor == 2) {
-        AvlNode *const middle_or_bottom = root->right;
+    } else if (balance_factor_of(root) == 2) {
+        AvlNode *const middle_or_bottom = right_of(root);
         assert(middle_or_bottom);
 
-        if (middle_or_bottom->balance_factor == 1) {
+        if (balance_factor_of(middle_or_bottom) == 1) {
             AvlNode *const bottom = middle_or_bottom;
 
-            return rotate_left(root, bottom);
+            return rotate_left(tree, root, bottom);
         } else { /* middle_or_bottom->balance_factor == -1 */
             AvlNode *const middle = middle_or_bottom;
-            AvlNode *const bottom = middle->left;
+            AvlNode *const bottom = left_of(middle);
 
-            assert(middle->balance_factor == -1);
+            assert(balance_factor_of(middle) == -1);
             assert(bottom);
 
-            return rotate_rightleft(root, middle, bottom);
+            return rotate_rightleft(tree, root, middle, bottom);
         }
     } else {
         return root;
@@ -90,6 +100,8 @@ AvlNode* rotate(AvlNode *root) {
  *  Executes a left rotation around middle, then a right rotation
  *  around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have a balance factor of -2. Must
  *             have middle as its left child.
  *  @param middle Must not be NULL. Must have a balance factor of 1.
@@ -97,32 +109,32 @@ AvlNode* rotate(AvlNode *root) {
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_leftright(AvlNode *top, AvlNode *middle, AvlNode *bottom) {
+AvlNode* rotate_leftright(const AvlTree *tree, AvlNode *top, AvlNode *middle, AvlNode *bottom) {
     assert(top);
-    assert(top->balance_factor == -2);
-    assert(top->left == middle);
+    assert(balance_factor_of(top) == -2);
+    assert(left_of(top) == middle);
     assert(middle);
-    assert(middle->balance_factor == 1);
-    assert(middle->right = bottom);
+    assert(balance_factor_of(middle) == 1);
+    assert(right_of(middle) == bottom);
     assert(bottom);
 
-    top->left = rotate_left_unchecked(middle, bottom);
-    rotate_right_unchecked(top, bottom);
+    set_left(top, rotate_left_unchecked(tree, middle, bottom));
+    rotate_right_unchecked(tree, top, bottom);
 
-    if (bottom->balance_factor == -1) {
-        top->balance_factor = 1;
-        middle->balance_factor = 0;
-    } else if (bottom->balance_factor == 0) {
-        top->balance_factor = 0;
-        middle->balance_factor = 0;
+    if (balance_factor_of(bottom) == -1) {
+        set_balance_factor(top, 1);
+        set_balance_factor(middle, 0);
+    } else if (balance_factor_of(bottom) == 0) {
+        set_balance_factor(top, 0);
+        set_balance_factor(middle, 0);
     } else {
-        assert(bottom->balance_factor == 1);
+        assert(balance_factor_of(bottom) == 1);
 
-        top->balance_factor = 0;
-        middle->balance_factor = -1;
+        set_balance_factor(top, 0);
+        set_balance_factor(middle, -1);
     }
 
-    bottom->balance_factor = 0;
+    set_balance_factor(bottom, 0);
 
     return bottom;
 }
@@ -131,6 +143,8 @@ AvlNode* rotate_leftright(AvlNode *top, AvlNode *middle, AvlNode *bottom) {
  *  Executes a right rotation around middle, then a left rotation
  *  around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have a balance factor of 2. Must
  *             have middle as its right child.
  *  @param middle Must not be NULL. Must have a balance factor of -1.
@@ -138,32 +152,32 @@ AvlNode* rotate_leftright(AvlNode *top, AvlNode *middle, AvlNode *bottom) {
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_rightleft(AvlNode *top, AvlNode *middle, AvlNode *bottom) {
+AvlNode* rotate_rightleft(const AvlTree *tree, AvlNode *top, AvlNode *middle, AvlNode *bottom) {
     assert(top);
-    assert(top->balance_factor == 2);
-    assert(top->right == middle);
+    assert(balance_factor_of(top) == 2);
+    assert(right_of(top) == middle);
     assert(middle);
-    assert(middle->balance_factor == -1);
-    assert(middle->left = bottom);
+    assert(balance_factor_of(middle) == -1);
+    assert(left_of(middle) == bottom);
     assert(bottom);
 
-    top->right = rotate_right_unchecked(middle, bottom);
-    rotate_left_unchecked(top, bottom);
+    set_right(top, rotate_right_unchecked(tree, middle, bottom));
+    rotate_left_unchecked(tree, top, bottom);
 
-    if (bottom->balance_factor == 1) {
-        top->balance_factor = -1;
-        middle->balance_factor = 0;
-    } else if (bottom->balance_factor == 0) {
-        top->balance_factor = 0;
-        middle->balance_factor = 0;
+    if (balance_factor_of(bottom) == 1) {
+        set_balance_factor(top, -1);
+        set_balance_factor(middle, 0);
+    } else if (balance_factor_of(bottom) == 0) {
+        set_balance_factor(top, 0);
+        set_balance_factor(middle, 0);
     } else {
-        assert(bottom->balance_factor == -1);
+        assert(balance_factor_of(bottom) == -1);
 
-        top->balance_factor = 0;
-        middle->balance_factor = 1;
+        set_balance_factor(top, 0);
+        set_balance_factor(middle, 1);
     }
 
-    bottom->balance_factor = 0;
+    set_balance_factor(bottom, 0);
 
     return bottom;
 }
@@ -171,22 +185,24 @@ AvlNode* rotate_rightleft(AvlNode *top, AvlNode *middle, AvlNode *bottom) {
 /**
  *  Executes a left rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its right child.
  *             Must have a balance factor of 2.
  *  @param bottom Must not be NULL. Must have a balance factor of 1.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_left(AvlNode *top, AvlNode *bottom) {
+AvlNode* rotate_left(const AvlTree *tree, AvlNode *top, AvlNode *bottom) {
     assert(top);
-    assert(top->right == bottom);
-    assert(top->balance_factor == 2);
+    assert(right_of(top) == bottom);
+    assert(balance_factor_of(top) == 2);
     assert(bottom);
-    assert(bottom->balance_factor == 1);
+    assert(balance_factor_of(bottom) == 1);
 
-    rotate_left_unchecked(top, bottom);
+    rotate_left_unchecked(tree, top, bottom);
 
-    top->balance_factor = 0;
-    bottom->balance_factor = 0;
+    set_balance_factor(top, 0);
+    set_balance_factor(bottom, 0);
 
     return bottom;
 }
@@ -194,44 +210,447 @@ AvlNode* rotate_left(AvlNode *top, AvlNode *bottom) {
 /**
  *  Executes a right rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its left child.
  *             Must have a balance factor of -2.
  *  @param bottom Must not be NULL. Must have a balance factor of -1.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_right(AvlNode *top, AvlNode *bottom) {
+AvlNode* rotate_right(const AvlTree *tree, AvlNode *top, AvlNode *bottom) {
     assert(top);
-    assert(top->left == bottom);
-    assert(top->balance_factor == -2);
+    assert(left_of(top) == bottom);
+    assert(balance_factor_of(top) == -2);
     assert(bottom);
-    assert(bottom->balance_factor == -1);
+    assert(balance_factor_of(bottom) == -1);
 
-    rotate_right_unchecked(top, bottom);
+    rotate_right_unchecked(tree, top, bottom);
 
-    top->balance_factor = 0;
-    bottom->balance_factor = 0;
+    set_balance_factor(top, 0);
+    set_balance_factor(bottom, 0);
 
     return bottom;
 }
 
-AvlNode* rotate_left_unchecked(AvlNode *top, AvlNode *bottom) {
+/**
+ *  Executes a left rotation around top.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param top Must not be NULL. Must have bottom as its right child.
+ *  @param bottom Must not be NULL.
+ *  @returns bottom, the new root of the tree.
+ */
+AvlNode* rotate_left_unchecked(const AvlTree *tree, AvlNode *top, AvlNode *bottom) {
     assert(top);
     assert(bottom);
-    assert(top->right == bottom);
+    assert(right_of(top) == bottom);
 
-    top->right = bottom->left;
-    bottom->left = top;
+    set_right(top, left_of(bottom));
+    set_left(bottom, top);
+    inherit_parent(tree, bottom, top);
+
+    update_node(tree, top);
+    update_node(tree, bottom);
 
     return bottom;
 }
 
-AvlNode* rotate_right_unchecked(AvlNode *top, AvlNode *bottom) {
+/**
+ *  Executes a right rotation around top.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param top Must not be NULL. Must have bottom as its left child.
+ *  @param bottom Must not be NULL.
+ *  @returns bottom, the new root of the tree.
+ */
+AvlNode* rotate_right_unchecked(const AvlTree *tree, AvlNode *top, AvlNode *bottom) {
     assert(top);
     assert(bottom);
-    assert(top->left == bottom);
+    assert(left_of(top) == bottom);
+
+    set_left(top, right_of(bottom));
+    set_right(bottom, top);
+    inherit_parent(tree, bottom, top);
 
-    top->left = bottom->right;
-    bottom->right = top;
+    update_node(tree, top);
+    update_node(tree, bottom);
 
     return bottom;
 }
+
+/**
+ *  Computes the height of a subtree in O(log n) time by following the
+ *  taller child of each node, as indicated by its balance factor.
+ *
+ *  @returns The height of the subtree rooted at node, or 0 if node is
+ *           NULL.
+ */
+size_t subtree_height(const AvlNode *node) {
+    size_t height = 0;
+
+    while (node) {
+        ++height;
+
+        if (balance_factor_of(node) < 0) {
+            node = left_of(node);
+        } else {
+            node = right_of(node);
+        }
+    }
+
+    return height;
+}
+
+/**
+ *  @param node Must not be NULL. Must have a balance factor in
+ *              {-1, 0, 1}.
+ *  @param height Must be the height of the subtree rooted at node.
+ *  @returns The height of the left subtree of node.
+ */
+size_t left_child_height(const AvlNode *node, size_t height) {
+    assert(node);
+    assert(balance_factor_of(node) >= -1 && balance_factor_of(node) <= 1);
+    assert(height > 0);
+
+    if (balance_factor_of(node) > 0) {
+        return height - 2;
+    }
+
+    return height - 1;
+}
+
+/**
+ *  @param node Must not be NULL. Must have a balance factor in
+ *              {-1, 0, 1}.
+ *  @param height Must be the height of the subtree rooted at node.
+ *  @returns The height of the right subtree of node.
+ */
+size_t right_child_height(const AvlNode *node, size_t height) {
+    assert(node);
+    assert(balance_factor_of(node) >= -1 && balance_factor_of(node) <= 1);
+    assert(height > 0);
+
+    if (balance_factor_of(node) < 0) {
+        return height - 2;
+    }
+
+    return height - 1;
+}
+
+static size_t max_height(size_t x, size_t y);
+
+static signed char balance_factor(size_t left_height, size_t right_height);
+
+/**
+ *  Restores the AVL condition at a node whose subtrees have known
+ *  heights.
+ *
+ *  Unlike rotate, this does not rely on balance factors that were
+ *  updated incrementally; it recomputes the balance factor of every
+ *  node it touches from the heights of their subtrees. The metadata
+ *  of every touched node is updated, including root's when no
+ *  rotation is needed.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param root Must not be NULL. Both of its subtrees must satisfy the
+ *              AVL condition.
+ *  @param left_height Must be the height of root's left subtree.
+ *  @param right_height Must be the height of root's right subtree.
+ *                      Must not differ from left_height by more than
+ *                      two.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                rebalanced subtree.
+ *  @returns The new root of the subtree.
+ */
+AvlNode* rebalance_subtree(const AvlTree *tree, AvlNode *root, size_t left_height,
+                           size_t right_height, size_t *height) {
+    assert(root);
+    assert(height);
+    assert(left_height <= right_height + 2 && right_height <= left_height + 2);
+
+    if (right_height == left_height + 2) {
+        AvlNode *const middle_or_bottom = right_of(root);
+        const size_t inner_height = left_child_height(middle_or_bottom, right_height);
+        const size_t outer_height = right_child_height(middle_or_bottom, right_height);
+
+        if (outer_height >= inner_height) {
+            AvlNode *const bottom = middle_or_bottom;
+            size_t root_height;
+
+            rotate_left_unchecked(tree, root, bottom);
+
+            set_balance_factor(root, balance_factor(left_height, inner_height));
+            root_height = max_height(left_height, inner_height) + 1;
+            set_balance_factor(bottom, balance_factor(root_height, outer_height));
+            *height = max_height(root_height, outer_height) + 1;
+
+            return bottom;
+        } else {
+            AvlNode *const middle = middle_or_bottom;
+            AvlNode *const bottom = left_of(middle);
+            const size_t bottom_left_height = left_child_height(bottom, inner_height);
+            const size_t bottom_right_height = right_child_height(bottom, inner_height);
+            size_t root_height;
+            size_t middle_height;
+
+            set_right(root, rotate_right_unchecked(tree, middle, bottom));
+            rotate_left_unchecked(tree, root, bottom);
+
+            set_balance_factor(root, balance_factor(left_height, bottom_left_height));
+            root_height = max_height(left_height, bottom_left_height) + 1;
+            set_balance_factor(middle, balance_factor(bottom_right_height, outer_height));
+            middle_height = max_height(bottom_right_height, outer_height) + 1;
+            set_balance_factor(bottom, balance_factor(root_height, middle_height));
+            *height = max_height(root_height, middle_height) + 1;
+
+            return bottom;
+        }
+    } else if (left_height == right_height + 2) {
+        AvlNode *const middle_or_bottom = left_of(root);
+        const size_t inner_height = right_child_height(middle_or_bottom, left_height);
+        const size_t outer_height = left_child_height(middle_or_bottom, left_height);
+
+        if (outer_height >= inner_height) {
+            AvlNode *const bottom = middle_or_bottom;
+            size_t root_height;
+
+            rotate_right_unchecked(tree, root, bottom);
+
+            set_balance_factor(root, balance_factor(inner_height, right_height));
+            root_height = max_height(inner_height, right_height) + 1;
+            set_balance_factor(bottom, balance_factor(outer_height, root_height));
+            *height = max_height(outer_height, root_height) + 1;
+
+            return bottom;
+        } else {
+            AvlNode *const middle = middle_or_bottom;
+            AvlNode *const bottom = right_of(middle);
+            const size_t bottom_left_height = left_child_height(bottom, inner_height);
+            const size_t bottom_right_height = right_child_height(bottom, inner_height);
+            size_t root_height;
+            size_t middle_height;
+
+            set_left(root, rotate_left_unchecked(tree, middle, bottom));
+            rotate_right_unchecked(tree, root, bottom);
+
+            set_balance_factor(root, balance_factor(bottom_right_height, right_height));
+            root_height = max_height(bottom_right_height, right_height) + 1;
+            set_balance_factor(middle, balance_factor(outer_height, bottom_left_height));
+            middle_height = max_height(outer_height, bottom_left_height) + 1;
+            set_balance_factor(bottom, balance_factor(middle_height, root_height));
+            *height = max_height(middle_height, root_height) + 1;
+
+            return bottom;
+        }
+    } else {
+        set_balance_factor(root, balance_factor(left_height, right_height));
+        update_node(tree, root);
+        *height = max_height(left_height, right_height) + 1;
+
+        return root;
+    }
+}
+
+/* node becomes the child of replaced's parent, taking replaced's place */
+static void inherit_parent(const AvlTree *tree, AvlNode *node, AvlNode *replaced) {
+    if (tree && tree->tracks_parents) {
+        parent_of(node) = parent_of(replaced);
+    }
+}
+
+static size_t max_height(size_t x, size_t y) {
+    return (x < y) ? y : x;
+}
+
+static signed char balance_factor(size_t left_height, size_t right_height) {
+    assert(left_height <= right_height + 1 && right_height <= left_height + 1);
+
+    return (signed char) ((long) right_height - (long) left_height);
+}
+
+/**
+ *  @returns The number of nodes in the subtree rooted at node. node
+ *           must be NULL or belong to a tree that tracks sizes.
+ */
+size_t subtree_size(const AvlNode *node) {
+    if (!node) {
+        return 0;
+    }
+
+    return ((const AvlSizedNode*) node)->size;
+}
+
+/**
+ *  Passes every node in a subtree to a tree's deleter.
+ *
+ *  Flattens the subtree into a list with right rotations as it goes,
+ *  so it neither recurses nor allocates.
+ *
+ *  @returns The number of nodes that were deleted.
+ */
+size_t drop_subtree(const AvlTree *tree, AvlNode *root) {
+    size_t num_dropped = 0;
+
+    assert(tree);
+
+    while (root) {
+        AvlNode *next;
+
+        while (left_of(root)) {
+            root = rotate_right_unchecked(NULL, root, left_of(root));
+        }
+
+        next = right_of(root);
+        tree->deleter(root, tree->deleter_arg);
+        ++num_dropped;
+        root = next;
+    }
+
+    return num_dropped;
+}
+
+/**
+ *  @returns Nonzero if tree keeps metadata on its nodes that must be
+ *           recomputed when their subtrees change.
+ */
+int has_metadata(const AvlTree *tree) {
+    return tree && (tree->tracks_sizes || tree->tracks_parents || tree->augment);
+}
+
+/**
+ *  @returns Nonzero if tree keeps metadata on its nodes that depends on
+ *           their whole subtree, rather than only on their children.
+ */
+int has_subtree_metadata(const AvlTree *tree) {
+    return tree && (tree->tracks_sizes || tree->augment);
+}
+
+/**
+ *  Recomputes the first and last nodes of a tree that caches them.
+ *
+ *  Must be called after any change to the tree that is not covered by
+ *  note_linked, note_replaced or note_removed.
+ *
+ *  @param tree Must not be NULL.
+ */
+void refresh_extremes(AvlTree *tree) {
+    AvlNode *current;
+
+    assert(tree);
+
+    if (!tree->caches_extremes) {
+        return;
+    }
+
+    tree->first = NULL;
+    tree->last = NULL;
+
+    for (current = tree->root; current; current = left_of(current)) {
+        tree->first = current;
+    }
+
+    for (current = tree->root; current; current = right_of(current)) {
+        tree->last = current;
+    }
+}
+
+/**
+ *  Updates the cached extremes of a tree after node was stored in
+ *  *link as a new leaf.
+ *
+ *  @param tree Must not be NULL.
+ *  @param link Must be &tree->root or the left or right link of the
+ *              node that is now node's parent.
+ */
+void note_linked(AvlTree *tree, AvlNode *const *link, AvlNode *node) {
+    assert(tree);
+    assert(link);
+    assert(node);
+
+    if (!tree->caches_extremes) {
+        return;
+    }
+
+    if (link == &tree->root) {
+        tree->first = node;
+        tree->last = node;
+    } else if (link == &tree->first->left) {
+        tree->first = node;
+    } else if (link == &tree->last->right) {
+        tree->last = node;
+    }
+}
+
+/**
+ *  Updates the cached extremes of a tree after node took the place of
+ *  previous.
+ *
+ *  @param tree Must not be NULL.
+ */
+void note_replaced(AvlTree *tree, const AvlNode *previous, AvlNode *node) {
+    assert(tree);
+
+    if (!tree->caches_extremes) {
+        return;
+    }
+
+    if (tree->first == previous) {
+        tree->first = node;
+    }
+
+    if (tree->last == previous) {
+        tree->last = node;
+    }
+}
+
+/**
+ *  Updates the cached extremes of a tree after removed was unlinked.
+ *
+ *  @param tree Must not be NULL.
+ */
+void note_removed(AvlTree *tree, const AvlNode *removed) {
+    assert(tree);
+
+    if (tree->caches_extremes && (tree->first == removed || tree->last == removed)) {
+        refresh_extremes(tree);
+    }
+}
+
+/**
+ *  Recomputes the metadata a tree keeps on node from its children.
+ *
+ *  Must be called whenever the children of node change, after the
+ *  metadata of those children is up to date.
+ *
+ *  @param tree If NULL, this call is a no-op.
+ *  @param node Must not be NULL.
+ */
+void update_node(const AvlTree *tree, AvlNode *node) {
+    assert(node);
+
+    if (!tree) {
+        return;
+    }
+
+    if (tree->tracks_sizes) {
+        ((AvlSizedNode*) node)->size =
+            subtree_size(left_of(node)) + subtree_size(right_of(node)) + 1;
+    }
+
+    if (tree->tracks_parents) {
+        if (left_of(node)) {
+            parent_of(left_of(node)) = node;
+        }
+
+        if (right_of(node)) {
+            parent_of(right_of(node)) = node;
+        }
+    }
+
+    if (tree->augment) {
+        tree->augment(node, tree->augment_arg);
+    }
+}
@@ -33,6 +33,57 @@
 extern "C" {
 #endif
 
+/*
+ *  Every read and write of a node's links goes through these macros,
+ *  so that the same code works whether or not the balance factor is
+ *  packed into the low bits of the child pointers. Arguments may be
+ *  evaluated more than once, so the balance factor passed to
+ *  set_balance_factor must not be read from the node it is written to;
+ *  use adjust_balance_factor to add to it instead.
+ *
+ *  link_get and link_set operate on a pointer to a link, such as
+ *  &node->left or &tree->root, and preserve any tag bits stored there.
+ */
+#define left_of(N) AVL_NODE_LEFT(N)
+#define right_of(N) AVL_NODE_RIGHT(N)
+#define balance_factor_of(N) AVL_NODE_BALANCE_FACTOR(N)
+
+#ifdef AVL_TAGGED_NODES
+#define link_get(L) ((AvlNode*) ((size_t) *(L) & ~AVL_NODE_TAG_MASK))
+#define link_set(L, C) \
+    (*(L) = (AvlNode*) ((size_t) (C) | ((size_t) *(L) & AVL_NODE_TAG_MASK)))
+/* the low two bits go in left and the sign bit in right */
+#define set_balance_factor(N, B) \
+    ((N)->left = (AvlNode*) (((size_t) (N)->left & ~AVL_NODE_TAG_MASK) \
+                             | ((size_t) (B) & 3)), \
+     (N)->right = (AvlNode*) (((size_t) (N)->right & ~AVL_NODE_TAG_MASK) \
+                              | (((size_t) (B) >> 2) & 1)))
+/* right is written first, since the low bits of the sum only depend on left */
+#define adjust_balance_factor(N, D) \
+    ((N)->right = (AvlNode*) (((size_t) (N)->right & ~AVL_NODE_TAG_MASK) \
+                              | (((((size_t) (N)->left & 3) \
+                                   | (((size_t) (N)->right & 1) << 2)) \
+                                  + (size_t) (D)) >> 2 & 1)), \
+     (N)->left = (AvlNode*) (((size_t) (N)->left & ~AVL_NODE_TAG_MASK) \
+                             | ((((size_t) (N)->left & 3) + (size_t) (D)) & 3)))
+#define reset_node(N) ((N)->left = NULL, (N)->right = NULL)
+#define is_tag_aligned(N) (((size_t) (N) & AVL_NODE_TAG_MASK) == 0)
+#else
+#define link_get(L) (*(L))
+#define link_set(L, C) (*(L) = (C))
+#define set_balance_factor(N, B) ((N)->balance_factor = (signed char) (B))
+#define adjust_balance_factor(N, D) \
+    ((N)->balance_factor = (signed char) ((N)->balance_factor + (D)))
+#define reset_node(N) ((N)->left = NULL, (N)->right = NULL, (N)->balance_factor = 0)
+#define is_tag_aligned(N) 1
+#endif
+
+/* only for nodes in trees that track parents */
+#define parent_of(N) (((AvlParentNode*) (N))->parent)
+
+#define set_left(N, C) link_set(&(N)->left, (C))
+#define set_right(N, C) link_set(&(N)->right, (C))
+
 /**
  *  Automatically selects a rotation to execute on a tree.
  *
@@ -44,17 +95,21 @@ extern "C" {
  *  child has a balance factor of 1, executes a left-right rotation
  *  around root.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param root Must not be NULL. Must have a left or right child,
  *              depending on its balance factor, which may also then
  *              require a left or right child.
  *  @returns The new root of the tree.
  */
-AvlNode* rotate(AvlNode *root);
+AvlNode* rotate(const AvlTree *tree, AvlNode *root);
 
 /**
  *  Executes a left rotation around middle, then a right rotation
  *  around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have a balance factor of -2. Must
  *             have middle as its left child.
  *  @param middle Must not be NULL. Must have a balance factor of 1.
@@ -62,12 +117,14 @@ AvlNode* rotate(AvlNode *root);
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_leftright(AvlNode *top, AvlNode *middle, AvlNode *bottom);
+AvlNode* rotate_leftright(const AvlTree *tree, AvlNode *top, AvlNode *middle, AvlNode *bottom);
 
 /**
  *  Executes a right rotation around middle, then a left rotation
  *  around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have a balance factor of 2. Must
  *             have middle as its right child.
  *  @param middle Must not be NULL. Must have a balance factor of -1.
@@ -75,45 +132,178 @@ AvlNode* rotate_leftright(AvlNode *top, AvlNode *middle, AvlNode *bottom);
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_rightleft(AvlNode *top, AvlNode *middle, AvlNode *bottom);
+AvlNode* rotate_rightleft(const AvlTree *tree, AvlNode *top, AvlNode *middle, AvlNode *bottom);
 
 /**
  *  Executes a left rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its right child.
  *             Must have a balance factor of 2.
  *  @param bottom Must not be NULL. Must have a balance factor of 1.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_left(AvlNode *top, AvlNode *bottom);
+AvlNode* rotate_left(const AvlTree *tree, AvlNode *top, AvlNode *bottom);
 
 /**
  *  Executes a right rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its left child.
  *             Must have a balance factor of -2.
  *  @param bottom Must not be NULL. Must have a balance factor of -1.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_right(AvlNode *top, AvlNode *bottom);
+AvlNode* rotate_right(const AvlTree *tree, AvlNode *top, AvlNode *bottom);
 
 /**
  *  Executes a left rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its right child.
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_left_unchecked(AvlNode *top, AvlNode *bottom);
+AvlNode* rotate_left_unchecked(const AvlTree *tree, AvlNode *top, AvlNode *bottom);
 
 /**
  *  Executes a right rotation around top.
  *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
  *  @param top Must not be NULL. Must have bottom as its left child.
  *  @param bottom Must not be NULL.
  *  @returns bottom, the new root of the tree.
  */
-AvlNode* rotate_right_unchecked(AvlNode *top, AvlNode *bottom);
+AvlNode* rotate_right_unchecked(const AvlTree *tree, AvlNode *top, AvlNode *bottom);
+
+/**
+ *  Computes the height of a subtree in O(log n) time by following the
+ *  taller child of each node, as indicated by its balance factor.
+ *
+ *  @returns The height of the subtree rooted at node, or 0 if node is
+ *           NULL.
+ */
+size_t subtree_height(const AvlNode *node);
+
+/**
+ *  @param node Must not be NULL. Must have a balance factor in
+ *              {-1, 0, 1}.
+ *  @param height Must be the height of the subtree rooted at node.
+ *  @returns The height of the left subtree of node.
+ */
+size_t left_child_height(const AvlNode *node, size_t height);
+
+/**
+ *  @param node Must not be NULL. Must have a balance factor in
+ *              {-1, 0, 1}.
+ *  @param height Must be the height of the subtree rooted at node.
+ *  @returns The height of the right subtree of node.
+ */
+size_t right_child_height(const AvlNode *node, size_t height);
+
+/**
+ *  Restores the AVL condition at a node whose subtrees have known
+ *  heights.
+ *
+ *  Unlike rotate, this does not rely on balance factors that were
+ *  updated incrementally; it recomputes the balance factor of every
+ *  node it touches from the heights of their subtrees. The metadata
+ *  of every touched node is updated, including root's when no
+ *  rotation is needed.
+ *
+ *  @param tree If not NULL, the tree whose subtree metadata will be
+ *              kept up to date.
+ *  @param root Must not be NULL. Both of its subtrees must satisfy the
+ *              AVL condition.
+ *  @param left_height Must be the height of root's left subtree.
+ *  @param right_height Must be the height of root's right subtree.
+ *                      Must not differ from left_height by more than
+ *                      two.
+ *  @param height Must not be NULL. Will be set to the height of the
+ *                rebalanced subtree.
+ *  @returns The new root of the subtree.
+ */
+AvlNode* rebalance_subtree(const AvlTree *tree, AvlNode *root, size_t left_height,
+                           size_t right_height, size_t *height);
+
+/**
+ *  @returns The number of nodes in the subtree rooted at node. node
+ *           must be NULL or belong to a tree that tracks sizes.
+ */
+size_t subtree_size(const AvlNode *node);
+
+/**
+ *  Passes every node in a subtree to a tree's deleter.
+ *
+ *  Flattens the subtree into a list with right rotations as it goes,
+ *  so it neither recurses nor allocates.
+ *
+ *  @param tree Must not be NULL.
+ *  @returns The number of nodes that were deleted.
+ */
+size_t drop_subtree(const AvlTree *tree, AvlNode *root);
+
+/**
+ *  @returns Nonzero if tree keeps metadata on its nodes that must be
+ *           recomputed when their subtrees change.
+ */
+int has_metadata(const AvlTree *tree);
+
+/**
+ *  @returns Nonzero if tree keeps metadata on its nodes that depends on
+ *           their whole subtree, rather than only on their children.
+ */
+int has_subtree_metadata(const AvlTree *tree);
+
+/**
+ *  Recomputes the first and last nodes of a tree that caches them.
+ *
+ *  Must be called after any change to the tree that is not covered by
+ *  note_linked, note_replaced or note_removed.
+ *
+ *  @param tree Must not be NULL.
+ */
+void refresh_extremes(AvlTree *tree);
+
+/**
+ *  Updates the cached extremes of a tree after node was stored in
+ *  *link as a new leaf.
+ *
+ *  @param tree Must not be NULL.
+ *  @param link Must be &tree->root or the left or right link of the
+ *              node that is now node's parent.
+ */
+void note_linked(AvlTree *tree, AvlNode *const *link, AvlNode *node);
+
+/**
+ *  Updates the cached extremes of a tree after node took the place of
+ *  previous.
+ *
+ *  @param tree Must not be NULL.
+ */
+void note_replaced(AvlTree *tree, const AvlNode *previous, AvlNode *node);
+
+/**
+ *  Updates the cached extremes of a tree after removed was unlinked.
+ *
+ *  @param tree Must not be NULL.
+ */
+void note_removed(AvlTree *tree, const AvlNode *removed);
+
+/**
+ *  Recomputes the metadata a tree keeps on node from its children.
+ *
+ *  Must be called whenever the children of node change, after the
+ *  metadata of those children is up to date.
+ *
+ *  @param tree If NULL, this call is a no-op.
+ *  @param node Must not be NULL.
+ */
+void update_node(const AvlTree *tree, AvlNode *node);
 
 #ifdef __cplusplus
 } // extern "C"
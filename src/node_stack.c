@@ -30,6 +30,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  *  Initializes an empty NodeStack.
@@ -42,6 +43,7 @@ void NodeStack_new(NodeStack *self) {
     self->data = NULL;
     self->len = 0;
     self->capacity = 0;
+    self->is_owned = 1;
 }
 
 /**
@@ -62,6 +64,27 @@ void NodeStack_with_capacity(NodeStack *self, size_t size) {
     self->data = checked_malloc(sizeof(AvlNode*) * size);
     self->len = 0;
     self->capacity = size;
+    self->is_owned = 1;
+}
+
+/**
+ *  Initializes an empty NodeStack that will initially use the adopted
+ *  slice of memory until it fills up.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param data Must point to a buffer at least len * sizeof(AvlNode*)
+ *              bytes long.
+ *  @param len Must be > 0.
+ */
+void NodeStack_from_adopted_slice(NodeStack *self, AvlNode **data, size_t len) {
+    assert(self);
+    assert(data);
+    assert(len > 0);
+
+    self->data = data;
+    self->len = 0;
+    self->capacity = len;
+    self->is_owned = 0;
 }
 
 /**
@@ -70,7 +93,11 @@ void NodeStack_with_capacity(NodeStack *self, size_t size) {
  *  @param self Must not be NULL. Must not be initialized.
  */
 void NodeStack_drop(NodeStack *self) {
-    free(self->data);
+    assert(self);
+
+    if (self->is_owned) {
+        free(self->data);
+    }
 }
 
 /**
@@ -79,7 +106,8 @@ void NodeStack_drop(NodeStack *self) {
  *  If not enough space is available for this NodeStack, realloc() is
  *  called to increase the capacity of the NodeStack by 1.5 - if there
  *  is no capacity, malloc() is called to initialize the NodeStack with
- *  space for 8 node pointers.
+ *  space for 8 node pointers. If the NodeStack is using an adopted
+ *  slice, its contents are copied into newly malloc()ed memory.
  *
  *  @param self Must not be NULL. Must be initialized.
  *  @param node Will be yielded as the next result of pop().
@@ -102,7 +130,15 @@ size_t NodeStack_push(NodeStack *self, AvlNode *node) {
             self->capacity *= 3;
             self->capacity /= 2;
 
-            self->data = checked_realloc(self->data, sizeof(AvlNode*) * self->capacity);
+            if (self->is_owned) {
+                self->data = checked_realloc(self->data, sizeof(AvlNode*) * self->capacity);
+            } else {
+                AvlNode **const adopted = self->data;
+
+                self->data = checked_malloc(sizeof(AvlNode*) * self->capacity);
+                memcpy(self->data, adopted, sizeof(AvlNode*) * self->len);
+                self->is_owned = 1;
+            }
         }
     }
 
@@ -57,6 +57,17 @@ void NodeStack_new(NodeStack *self);
  */
 void NodeStack_with_capacity(NodeStack *self, size_t size);
 
+/**
+ *  Initializes an empty NodeStack that will initially use the adopted
+ *  slice of memory until it fills up.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param data Must point to a buffer at least len * sizeof(AvlNode*)
+ *              bytes long.
+ *  @param len Must be > 0.
+ */
+void NodeStack_from_adopted_slice(NodeStack *self, AvlNode **data, size_t len);
+
 /**
  *  Drops a NodeStack, deallocating all owned resources.
  *
@@ -70,7 +81,8 @@ void NodeStack_drop(NodeStack *self);
  *  If not enough space is available for this NodeStack, realloc() is
  *  called to increase the capacity of the NodeStack by 1.5 - if there
  *  is no capacity, malloc() is called to initialize the NodeStack with
- *  space for 8 node pointers.
+ *  space for 8 node pointers. If the NodeStack is using an adopted
+ *  slice, its contents are copied into newly malloc()ed memory.
  *
  *  @param self Must not be NULL. Must be initialized.
  *  @param node Will be yielded as the next result of pop().
@@ -125,6 +137,7 @@ struct NodeStack {
     AvlNode **data;
     size_t len;
     size_t capacity;
+    int is_owned;
 };
 
 #ifdef __cplusplus
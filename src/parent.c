@@ -0,0 +1,145 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "node.h"
+
+#include <assert.h>
+
+#define parent_of_const(N) (((const AvlParentNode*) (N))->parent)
+
+/**
+ *  Finds the in-order successor of a node.
+ *
+ *  Runs in O(1) amortized time and makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ *  @returns The first node that compares greater than node, if there
+ *           is one.
+ */
+const AvlNode* AvlTree_next(const AvlTree *self, const AvlNode *node) {
+    const AvlNode *current;
+
+    assert(self);
+    assert(self->tracks_parents);
+    assert(node);
+
+    if (right_of(node)) {
+        for (current = right_of(node); left_of(current); current = left_of(current)) { }
+
+        return current;
+    }
+
+    /* climb until we leave a left subtree */
+    for (current = node; current != self->root; current = parent_of_const(current)) {
+        const AvlNode *const parent = parent_of_const(current);
+
+        if (left_of(parent) == current) {
+            return parent;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  Finds the in-order predecessor of a node.
+ *
+ *  Runs in O(1) amortized time and makes no comparator calls.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ *  @returns The last node that compares less than node, if there is
+ *           one.
+ */
+const AvlNode* AvlTree_prev(const AvlTree *self, const AvlNode *node) {
+    const AvlNode *current;
+
+    assert(self);
+    assert(self->tracks_parents);
+    assert(node);
+
+    if (left_of(node)) {
+        for (current = left_of(node); right_of(current); current = right_of(current)) { }
+
+        return current;
+    }
+
+    /* climb until we leave a right subtree */
+    for (current = node; current != self->root; current = parent_of_const(current)) {
+        const AvlNode *const parent = parent_of_const(current);
+
+        if (right_of(parent) == current) {
+            return parent;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  Removes a node from an AvlTree without searching for it.
+ *
+ *  The path to node is found by following parent links, so this runs
+ *  in O(log n) time and makes no comparator calls. The node is not
+ *  passed to the deleter.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track
+ *              parents.
+ *  @param node Must not be NULL. Must be in self.
+ */
+void AvlTree_remove_node(AvlTree *self, AvlNode *node) {
+    AvlNode *path[AVL_MAX_HEIGHT];
+    AvlNode *current;
+    size_t depth = 0;
+    size_t i;
+
+    assert(self);
+    assert(self->tracks_parents);
+    assert(node);
+
+    /* collect the path deepest first, then reverse it */
+    for (current = node; current != self->root; current = parent_of(current)) {
+        assert(depth < AVL_MAX_HEIGHT);
+        path[depth++] = current;
+    }
+
+    assert(depth < AVL_MAX_HEIGHT);
+    path[depth++] = current;
+
+    for (i = 0; i < depth / 2; ++i) {
+        AvlNode *const swapped = path[i];
+
+        path[i] = path[depth - 1 - i];
+        path[depth - 1 - i] = swapped;
+    }
+
+    AvlTree_remove_at(self, path, depth);
+}
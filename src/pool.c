@@ -0,0 +1,217 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/* chunks start with a header that points to the previous chunk */
+typedef union ChunkHeader {
+    void *previous;
+    MaxAlign align;
+} ChunkHeader;
+
+#define DEFAULT_CHUNK_SIZE ((size_t) 65536)
+
+static void new_chunk(AvlNodePool *self);
+
+/**
+ *  Initializes an empty AvlNodePool.
+ *
+ *  @param self Must not be NULL. Must not be initialized.
+ *  @param node_size Must be nonzero. The size of each node in bytes.
+ *  @param nodes_per_chunk The number of nodes to allocate at once. If
+ *                         0, chunks will be about 64 KiB.
+ */
+void AvlNodePool_new(AvlNodePool *self, size_t node_size, size_t nodes_per_chunk) {
+    size_t slot_size;
+
+    assert(self);
+    assert(node_size > 0);
+
+    /* round up so that every slot is aligned and can hold a free list link */
+    slot_size = (node_size < sizeof(void*)) ? sizeof(void*) : node_size;
+    slot_size = (slot_size + sizeof(MaxAlign) - 1) / sizeof(MaxAlign) * sizeof(MaxAlign);
+
+    if (nodes_per_chunk == 0) {
+        nodes_per_chunk = (DEFAULT_CHUNK_SIZE - sizeof(ChunkHeader)) / slot_size;
+
+        if (nodes_per_chunk == 0) {
+            nodes_per_chunk = 1;
+        }
+    }
+
+    self->slot_size = slot_size;
+    self->slots_per_chunk = nodes_per_chunk;
+    self->chunks = NULL;
+    self->next_slot = NULL;
+    self->num_untouched = 0;
+    self->free_list = NULL;
+    self->len = 0;
+}
+
+/**
+ *  Drops an AvlNodePool, freeing every chunk.
+ *
+ *  Every node allocated from the pool becomes invalid.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlNodePool_drop(AvlNodePool *self) {
+    void *chunk;
+
+    assert(self);
+
+    chunk = self->chunks;
+
+    while (chunk) {
+        void *const previous = ((ChunkHeader*) chunk)->previous;
+
+        free(chunk);
+        chunk = previous;
+    }
+
+    self->chunks = NULL;
+    self->next_slot = NULL;
+    self->num_untouched = 0;
+    self->free_list = NULL;
+    self->len = 0;
+}
+
+/**
+ *  Allocates a node from an AvlNodePool.
+ *
+ *  Runs in O(1) time. If a new chunk is needed and malloc() returns
+ *  NULL, a message is printed to stderr and abort() is called.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @returns A pointer to uninitialized memory of at least the pool's
+ *           node size, aligned for any object type.
+ */
+void* AvlNodePool_alloc(AvlNodePool *self) {
+    void *node;
+
+    assert(self);
+
+    if (self->free_list) {
+        node = self->free_list;
+        self->free_list = *(void**) node;
+    } else {
+        if (self->num_untouched == 0) {
+            new_chunk(self);
+        }
+
+        node = self->next_slot;
+        self->next_slot += self->slot_size;
+        --self->num_untouched;
+    }
+
+    ++self->len;
+
+    return node;
+}
+
+/**
+ *  Returns a node to an AvlNodePool for reuse.
+ *
+ *  Runs in O(1) time.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ *  @param node Must not be NULL. Must have been returned by
+ *              AvlNodePool_alloc(self) and not freed since.
+ */
+void AvlNodePool_free(AvlNodePool *self, void *node) {
+    assert(self);
+    assert(node);
+    assert(self->len > 0);
+
+    *(void**) node = self->free_list;
+    self->free_list = node;
+    --self->len;
+}
+
+/**
+ *  Frees every node in an AvlNodePool at once.
+ *
+ *  Runs in O(c) time, where c is the number of chunks. The newest
+ *  chunk is kept for reuse.
+ *
+ *  @param self Must not be NULL. Must be initialized.
+ */
+void AvlNodePool_reset(AvlNodePool *self) {
+    void *newest;
+
+    assert(self);
+
+    newest = self->chunks;
+
+    if (!newest) {
+        return;
+    }
+
+    self->chunks = ((ChunkHeader*) newest)->previous;
+    AvlNodePool_drop(self);
+
+    ((ChunkHeader*) newest)->previous = NULL;
+    self->chunks = newest;
+    self->next_slot = (unsigned char*) newest + sizeof(ChunkHeader);
+    self->num_untouched = self->slots_per_chunk;
+}
+
+/**
+ *  AvlDeleter that returns nodes to the AvlNodePool passed as arg.
+ *
+ *  Nodes are not finalized in any other way. If they own resources,
+ *  use a deleter that releases them before calling AvlNodePool_free;
+ *  AvlTree_clear only skips its traversal for this exact deleter.
+ *
+ *  Like AvlNodePool_free, this is not thread-safe. The *_parallel set
+ *  operations merge on the calling thread only when they see this
+ *  deleter; a wrapper around it must not be passed to them.
+ *
+ *  @param node Must not be NULL. Must have been allocated from arg.
+ *  @param pool Must not be NULL. Must be an initialized AvlNodePool.
+ */
+void AvlNodePool_deleter(AvlNode *node, void *pool) {
+    AvlNodePool_free((AvlNodePool*) pool, node);
+}
+
+static void new_chunk(AvlNodePool *self) {
+    void *chunk;
+
+    assert(self);
+    assert(self->num_untouched == 0);
+
+    chunk = checked_malloc(sizeof(ChunkHeader) + self->slots_per_chunk * self->slot_size);
+    ((ChunkHeader*) chunk)->previous = self->chunks;
+
+    self->chunks = chunk;
+    self->next_slot = (unsigned char*) chunk + sizeof(ChunkHeader);
+    self->num_untouched = self->slots_per_chunk;
+}
@@ -0,0 +1,115 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#include <bloodhound.h>
+
+#include "node.h"
+
+#include <assert.h>
+
+/**
+ *  Finds the node at a given position in the in-order sequence.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track sizes.
+ *  @param index The zero-based position of the node to find.
+ *  @param cursor If not NULL, will be initialized and positioned at
+ *                the returned node, or at the end if NULL is returned.
+ *  @returns The node that has exactly index nodes before it, if
+ *           index < self->len.
+ */
+const AvlNode* AvlTree_select(const AvlTree *self, size_t index, AvlCursor *cursor) {
+    AvlNode *current;
+    size_t depth = 0;
+
+    assert(self);
+    assert(self->tracks_sizes);
+
+    if (cursor) {
+        AvlCursor_new(cursor, self);
+    }
+
+    for (current = self->root; current; ++depth) {
+        const size_t left_size = subtree_size(left_of(current));
+
+        if (cursor) {
+            assert(depth < AVL_MAX_HEIGHT);
+            cursor->path[depth] = current;
+        }
+
+        if (index < left_size) {
+            current = left_of(current);
+        } else if (index == left_size) {
+            if (cursor) {
+                cursor->depth = depth + 1;
+            }
+
+            return current;
+        } else { /* index > left_size */
+            index -= left_size + 1;
+            current = right_of(current);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  Counts the nodes that compare less than a key.
+ *
+ *  If a node compares equal to key, this is its zero-based position
+ *  in the in-order sequence.
+ *
+ *  @param self Must not be NULL. Must be initialized. Must track sizes.
+ *  @param compare Must not be NULL. Must form the same total ordering
+ *                 over the contained elements as the one formed by one
+ *                 passed to AvlTree_new. Will be invoked by
+ *                 compare(key, node, arg).
+ *  @returns The number of nodes that compare less than key.
+ */
+size_t AvlTree_rank(const AvlTree *self, const void *key, AvlHetComparator compare,
+                    void *arg) {
+    const AvlNode *current;
+    size_t rank = 0;
+
+    assert(self);
+    assert(self->tracks_sizes);
+    assert(compare);
+
+    for (current = self->root; current;) {
+        const int ordering = compare(key, current, arg);
+
+        if (ordering == 0) {
+            return rank + subtree_size(left_of(current));
+        } else if (ordering < 0) {
+            current = left_of(current);
+        } else { /* ordering > 0 */
+            rank += subtree_size(left_of(current)) + 1;
+            current = right_of(current);
+        }
+    }
+
+    return rank;
+}
@@ -0,0 +1,423 @@
+/*  MIT License
+ *
+ *  Copyright (c) 2019 Gregory Meyer
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use, copy,
+ *  modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice (including
+ *  the next paragraph) shall be included in all copies or substantial
+ *  portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifdef BLOODHOUND_USE_PTHREADS
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <bloodhound.h>
+
+#include "join.h"
+#include "node.h"
+
+#include <assert.h>
+
+#ifdef BLOODHOUND_USE_PTHREADS
+#include <pthread.h>
+#endif
+
+/**
+ *  Subtrees whose heights are both below this are always merged on
+ *  the calling thread; below roughly a thousand nodes, starting a
+ *  thread costs more than the merge itself.
+ */
+#define PARALLEL_MIN_HEIGHT 10
+
+typedef enum SetOpKind {
+    SET_OP_UNION,
+    SET_OP_INTERSECTION,
+    SET_OP_DIFFERENCE
+} SetOpKind;
+
+typedef struct SetOp {
+    const AvlTree *self;
+    const AvlTree *other;
+    SetOpKind kind;
+    size_t num_threads;
+    size_t dropped_from_self;
+    size_t dropped_from_other;
+} SetOp;
+
+static void run(AvlTree *self, AvlTree *other, SetOpKind kind, size_t num_threads);
+
+/**
+ *  Moves every node from other into self.
+ *
+ *  Runs in O(m log(n/m + 1)) time, where m is the length of the
+ *  smaller tree and n the length of the larger tree.
+ *
+ *  @param self Must not be NULL. Must be initialized. Will hold every
+ *              node from self and every node from other that does not
+ *              compare equal to a node in self.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               that compares equal to a node in self will be passed
+ *               to other's deleter. Will be left empty.
+ */
+void AvlTree_union(AvlTree *self, AvlTree *other) {
+    run(self, other, SET_OP_UNION, 1);
+}
+
+/**
+ *  Removes every node from self that does not compare equal to a node
+ *  in other.
+ *
+ *  Makes O(m log(n/m + 1)) comparisons, where m is the length of the
+ *  smaller tree and n the length of the larger tree. Every node of
+ *  other and every unmatched node of self is passed to a deleter, so
+ *  it runs in O(m + n) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              does not compare equal to a node in other will be
+ *              passed to self's deleter.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               will be passed to other's deleter. Will be left empty.
+ */
+void AvlTree_intersection(AvlTree *self, AvlTree *other) {
+    run(self, other, SET_OP_INTERSECTION, 1);
+}
+
+/**
+ *  Removes every node from self that compares equal to a node in
+ *  other.
+ *
+ *  Makes O(m log(n/m + 1)) comparisons, where m is the length of the
+ *  smaller tree and n the length of the larger tree. Every node of
+ *  other is passed to its deleter, so it runs in
+ *  O(m log(n/m + 1) + |other|) time.
+ *
+ *  @param self Must not be NULL. Must be initialized. Every node that
+ *              compares equal to a node in other will be passed to
+ *              self's deleter.
+ *  @param other Must not be NULL. Must be initialized with the same
+ *               configuration as self. Must not be self. Every node
+ *               will be passed to other's deleter. Will be left empty.
+ */
+void AvlTree_difference(AvlTree *self, AvlTree *other) {
+    run(self, other, SET_OP_DIFFERENCE, 1);
+}
+
+/**
+ *  Equivalent to AvlTree_union, but merges independent subtrees on up
+ *  to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_union.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_union_parallel(AvlTree *self, AvlTree *other, size_t num_threads) {
+    run(self, other, SET_OP_UNION, num_threads);
+}
+
+/**
+ *  Equivalent to AvlTree_intersection, but merges independent
+ *  subtrees on up to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_intersection.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_intersection_parallel(AvlTree *self, AvlTree *other, size_t num_threads) {
+    run(self, other, SET_OP_INTERSECTION, num_threads);
+}
+
+/**
+ *  Equivalent to AvlTree_difference, but merges independent subtrees
+ *  on up to num_threads threads.
+ *
+ *  The comparator, deleter and augmenter may be invoked concurrently
+ *  on distinct nodes. If the library was built without thread support,
+ *  or if either tree's deleter is AvlNodePool_deleter, which is not
+ *  thread-safe, this is equivalent to AvlTree_difference.
+ *
+ *  @param num_threads The maximum number of threads to merge on,
+ *                     including the calling thread. 0 and 1 both
+ *                     merge on the calling thread only.
+ */
+void AvlTree_difference_parallel(AvlTree *self, AvlTree *other, size_t num_threads) {
+    run(self, other, SET_OP_DIFFERENCE, num_threads);
+}
+
+static AvlNode* merge_subtrees(SetOp *op, AvlNode *root, size_t height,
+                               AvlNode *other_root, size_t other_height,
+                               size_t *merged_height);
+
+static void run(AvlTree *self, AvlTree *other, SetOpKind kind, size_t num_threads) {
+    SetOp op;
+    size_t height;
+
+    assert(self);
+    assert(other);
+    assert(self != other);
+    assert(self->compare == other->compare);
+    assert(self->tracks_sizes == other->tracks_sizes);
+    assert(self->tracks_parents == other->tracks_parents);
+    assert(self->augment == other->augment);
+    assert(self->caches_extremes == other->caches_extremes);
+
+    op.self = self;
+    op.other = other;
+    op.kind = kind;
+    op.num_threads = (num_threads > 0) ? num_threads : 1;
+
+    if (self->deleter == AvlNodePool_deleter || other->deleter == AvlNodePool_deleter) {
+        op.num_threads = 1;
+    }
+    op.dropped_from_self = 0;
+    op.dropped_from_other = 0;
+
+    self->root = merge_subtrees(&op, self->root, subtree_height(self->root),
+                                other->root, subtree_height(other->root), &height);
+
+    if (kind == SET_OP_UNION) {
+        self->len += other->len - op.dropped_from_other;
+    } else {
+        self->len -= op.dropped_from_self;
+    }
+
+    other->root = NULL;
+    other->len = 0;
+
+    refresh_extremes(self);
+    refresh_extremes(other);
+}
+
+static AvlNode* merge_leftover(SetOp *op, AvlNode *root, size_t height,
+                               AvlNode *other_root, size_t other_height,
+                               size_t *merged_height);
+
+static void split_other(SetOp *op, AvlNode *other_root, size_t other_height,
+                        const AvlNode *pivot, SplitRet *split);
+
+static void merge_children(SetOp *op, AvlNode *root, size_t height, SplitRet *split,
+                           AvlNode **left, size_t *left_height,
+                           AvlNode **right, size_t *right_height);
+
+/**
+ *  Splits the subtree of other around the root of self, merges the
+ *  halves with root's children, then joins the merged halves back
+ *  together through root if root is kept.
+ */
+static AvlNode* merge_subtrees(SetOp *op, AvlNode *root, size_t height,
+                               AvlNode *other_root, size_t other_height,
+                               size_t *merged_height) {
+    SplitRet split;
+    AvlNode *left;
+    AvlNode *right;
+    size_t left_height;
+    size_t right_height;
+    int keep_root;
+
+    assert(op);
+    assert(merged_height);
+
+    if (!root || !other_root) {
+        return merge_leftover(op, root, height, other_root, other_height, merged_height);
+    }
+
+    split_other(op, other_root, other_height, root, &split);
+    merge_children(op, root, height, &split, &left, &left_height, &right, &right_height);
+
+    if (split.equal) {
+        op->other->deleter(split.equal, op->other->deleter_arg);
+        ++op->dropped_from_other;
+    }
+
+    switch (op->kind) {
+    case SET_OP_UNION:
+        keep_root = 1;
+
+        break;
+    case SET_OP_INTERSECTION:
+        keep_root = split.equal != NULL;
+
+        break;
+    default: /* SET_OP_DIFFERENCE */
+        keep_root = split.equal == NULL;
+
+        break;
+    }
+
+    if (keep_root) {
+        return join_subtrees(op->self, left, left_height, root, right, right_height,
+                             merged_height);
+    }
+
+    op->self->deleter(root, op->self->deleter_arg);
+    ++op->dropped_from_self;
+
+    return concat_subtrees(op->self, left, left_height, right, right_height, merged_height);
+}
+
+/**
+ *  Merges subtrees when at least one of them is empty.
+ */
+static AvlNode* merge_leftover(SetOp *op, AvlNode *root, size_t height,
+                               AvlNode *other_root, size_t other_height,
+                               size_t *merged_height) {
+    assert(op);
+    assert(!root || !other_root);
+    assert(merged_height);
+
+    switch (op->kind) {
+    case SET_OP_UNION:
+        if (root) {
+            *merged_height = height;
+
+            return root;
+        }
+
+        *merged_height = other_height;
+
+        return other_root;
+    case SET_OP_INTERSECTION:
+        op->dropped_from_self += drop_subtree(op->self, root);
+        op->dropped_from_other += drop_subtree(op->other, other_root);
+        *merged_height = 0;
+
+        return NULL;
+    default: /* SET_OP_DIFFERENCE */
+        op->dropped_from_other += drop_subtree(op->other, other_root);
+        *merged_height = height;
+
+        return root;
+    }
+}
+
+static int compare_nodes(const void *lhs, const AvlNode *rhs, void *op_v);
+
+/**
+ *  Splits a subtree of other around a node of self.
+ */
+static void split_other(SetOp *op, AvlNode *other_root, size_t other_height,
+                        const AvlNode *pivot, SplitRet *split) {
+    assert(op);
+    assert(pivot);
+    assert(split);
+
+    split_subtree(op->self, other_root, other_height, pivot, compare_nodes, op, split);
+}
+
+#ifdef BLOODHOUND_USE_PTHREADS
+typedef struct MergeTask {
+    SetOp op;
+    AvlNode *root;
+    size_t height;
+    AvlNode *other_root;
+    size_t other_height;
+    AvlNode *merged;
+    size_t merged_height;
+} MergeTask;
+
+static void* run_merge_task(void *task_v);
+#endif
+
+/**
+ *  Merges the left and right children of root with the left and right
+ *  halves of split, forking the right merge onto another thread if
+ *  both are large enough and op may use more than one thread.
+ */
+static void merge_children(SetOp *op, AvlNode *root, size_t height, SplitRet *split,
+                           AvlNode **left, size_t *left_height,
+                           AvlNode **right, size_t *right_height) {
+    const size_t root_left_height = left_child_height(root, height);
+    const size_t root_right_height = right_child_height(root, height);
+
+#ifdef BLOODHOUND_USE_PTHREADS
+    if (op->num_threads > 1 && height >= PARALLEL_MIN_HEIGHT
+        && split->left_height >= PARALLEL_MIN_HEIGHT
+        && split->right_height >= PARALLEL_MIN_HEIGHT) {
+        const size_t num_threads = op->num_threads;
+        const size_t num_forked_threads = num_threads / 2;
+        MergeTask task;
+        pthread_t thread;
+
+        task.op = *op;
+        task.op.num_threads = num_forked_threads;
+        task.op.dropped_from_self = 0;
+        task.op.dropped_from_other = 0;
+        task.root = right_of(root);
+        task.height = root_right_height;
+        task.other_root = split->right;
+        task.other_height = split->right_height;
+
+        if (pthread_create(&thread, NULL, run_merge_task, &task) == 0) {
+            op->num_threads = num_threads - num_forked_threads;
+            *left = merge_subtrees(op, left_of(root), root_left_height, split->left,
+                                   split->left_height, left_height);
+            op->num_threads = num_threads;
+
+            pthread_join(thread, NULL);
+
+            *right = task.merged;
+            *right_height = task.merged_height;
+            op->dropped_from_self += task.op.dropped_from_self;
+            op->dropped_from_other += task.op.dropped_from_other;
+
+            return;
+        }
+    }
+#endif
+
+    *left = merge_subtrees(op, left_of(root), root_left_height, split->left, split->left_height,
+                           left_height);
+    *right = merge_subtrees(op, right_of(root), root_right_height, split->right,
+                            split->right_height, right_height);
+}
+
+#ifdef BLOODHOUND_USE_PTHREADS
+static void* run_merge_task(void *task_v) {
+    MergeTask *const task = (MergeTask*) task_v;
+
+    assert(task);
+
+    task->merged = merge_subtrees(&task->op, task->root, task->height, task->other_root,
+                                  task->other_height, &task->merged_height);
+
+    return NULL;
+}
+#endif
+
+static int compare_nodes(const void *lhs, const AvlNode *rhs, void *op_v) {
+    const SetOp *const op = (const SetOp*) op_v;
+
+    assert(lhs);
+    assert(rhs);
+    assert(op);
+
+    return op->self->compare((const AvlNode*) lhs, rhs, op->self->compare_arg);
+}
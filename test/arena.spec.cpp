@@ -0,0 +1,133 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+IntNode* new_arena_node(AvlArena &arena, int key) {
+    return new (AvlArena_alloc(&arena, sizeof(IntNode))) IntNode(key);
+}
+
+bool is_aligned(const void *ptr) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+}
+
+} // namespace
+
+TEST_CASE("arena allocations are aligned and disjoint") {
+    AvlArena arena;
+    std::vector<unsigned char*> allocated;
+
+    AvlArena_new(&arena, 256);
+
+    for (std::size_t size = 0; size < 600; size += 7) {
+        unsigned char *const bytes = static_cast<unsigned char*>(AvlArena_alloc(&arena, size));
+
+        REQUIRE(is_aligned(bytes));
+        std::memset(bytes, static_cast<int>(size % 256), size);
+        allocated.push_back(bytes);
+    }
+
+    for (std::size_t i = 0; i < allocated.size(); ++i) {
+        const std::size_t size = 7 * i;
+
+        for (std::size_t j = 0; j < size; ++j) {
+            REQUIRE(allocated[i][j] == static_cast<unsigned char>(size % 256));
+        }
+    }
+
+    AvlArena_drop(&arena);
+}
+
+TEST_CASE("arena reset keeps the newest chunk") {
+    AvlArena arena;
+
+    AvlArena_new(&arena, 1024);
+
+    for (int i = 0; i < 100; ++i) {
+        AvlArena_alloc(&arena, 48);
+    }
+
+    // oversized allocations do not displace the chunk being bumped through
+    void *const newest = arena.chunks;
+    AvlArena_alloc(&arena, 4096);
+    REQUIRE(arena.chunks == newest);
+
+    AvlArena_reset(&arena);
+
+    REQUIRE(arena.chunks == newest);
+    REQUIRE(arena.num_free_bytes == arena.chunk_size);
+
+    void *const first = arena.next_byte;
+    REQUIRE(AvlArena_alloc(&arena, 48) == first);
+
+    AvlArena_drop(&arena);
+}
+
+TEST_CASE("arena tree") {
+    const auto urbg_ptr = make_urbg();
+    AvlArena arena;
+    AvlTree tree;
+
+    AvlArena_new(&arena, 0);
+
+    for (int round = 0; round < 3; ++round) {
+        AvlTree_new_in_arena(&tree, int_node_compare, nullptr, &arena);
+
+        for (int key : rand_iota(5000, *urbg_ptr)) {
+            REQUIRE_FALSE(AvlTree_insert(&tree, new_arena_node(arena, key)));
+        }
+
+        // replaced nodes are left to the arena
+        IntNode *const replacement = new_arena_node(arena, 7);
+        const AvlNode *const replaced = AvlTree_insert(&tree, replacement);
+        REQUIRE(replaced);
+        REQUIRE(int_node_key(replaced) == 7);
+
+        const int key = 7;
+        REQUIRE(AvlTree_get(&tree, &key, int_node_het_compare, nullptr) == replacement);
+        REQUIRE(AvlTree_remove(&tree, &key, int_node_het_compare, nullptr) == replacement);
+        REQUIRE(tree.len == 4999);
+        REQUIRE(checked_height(tree.root) >= 0);
+
+        AvlTree_drop(&tree);
+
+        REQUIRE_FALSE(tree.root);
+        REQUIRE(tree.len == 0);
+
+        AvlArena_reset(&arena);
+    }
+
+    AvlArena_drop(&arena);
+}
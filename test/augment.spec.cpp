@@ -0,0 +1,207 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "bloodhound.h"
+#include "util.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+namespace {
+
+struct SumNode {
+    explicit SumNode(int k) noexcept : key(k), value(k % 17), sum(0), max_value(0) {
+        base.node = AvlNode();
+        base.size = 1;
+    }
+
+    AvlSizedNode base;
+    int key;
+    long value;
+    long sum;
+    long max_value;
+};
+
+SumNode& as_sum_node(AvlNode *node) {
+    return *reinterpret_cast<SumNode*>(node);
+}
+
+const SumNode& as_sum_node(const AvlNode *node) {
+    return *reinterpret_cast<const SumNode*>(node);
+}
+
+int compare(const AvlNode *lhs, const AvlNode *rhs, void*) {
+    const int l = as_sum_node(lhs).key;
+    const int r = as_sum_node(rhs).key;
+
+    return (l > r) - (l < r);
+}
+
+int het_compare(const void *lhs, const AvlNode *rhs, void*) {
+    const int l = *static_cast<const int*>(lhs);
+    const int r = as_sum_node(rhs).key;
+
+    return (l > r) - (l < r);
+}
+
+void noop_delete(AvlNode*, void*) { }
+
+void augment(AvlNode *node, void *num_calls) {
+    SumNode &n = as_sum_node(node);
+
+    ++*static_cast<std::size_t*>(num_calls);
+
+    n.sum = n.value;
+    n.max_value = n.value;
+
+    for (const AvlNode *child : {AVL_NODE_LEFT(node), AVL_NODE_RIGHT(node)}) {
+        if (child) {
+            n.sum += as_sum_node(child).sum;
+            n.max_value = std::max(n.max_value, as_sum_node(child).max_value);
+        }
+    }
+}
+
+// sum of the values of every node with a key < key
+long prefix_sum(const AvlTree &tree, int key) {
+    long sum = 0;
+
+    for (const AvlNode *current = tree.root; current;) {
+        if (as_sum_node(current).key < key) {
+            if (AVL_NODE_LEFT(current)) {
+                sum += as_sum_node(AVL_NODE_LEFT(current)).sum;
+            }
+
+            sum += as_sum_node(current).value;
+            current = AVL_NODE_RIGHT(current);
+        } else {
+            current = AVL_NODE_LEFT(current);
+        }
+    }
+
+    return sum;
+}
+
+void require_aggregates(const AvlTree &tree, const std::map<int, long> &contained) {
+    long total = 0;
+    long max_value = 0;
+
+    for (const auto &kv : contained) {
+        REQUIRE(prefix_sum(tree, kv.first) == total);
+        total += kv.second;
+        max_value = std::max(max_value, kv.second);
+    }
+
+    if (tree.root) {
+        REQUIRE(as_sum_node(tree.root).sum == total);
+        REQUIRE(as_sum_node(tree.root).max_value == max_value);
+    }
+}
+
+} // namespace
+
+TEST_CASE("augmented insert, replace, remove") {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(NUM_INSERTIONS, *urbg_ptr);
+    std::vector<SumNode> nodes(keys.begin(), keys.end());
+    std::vector<SumNode> replacements(keys.begin(), keys.end());
+    std::map<int, long> contained;
+    std::size_t num_calls = 0;
+    AvlTree tree;
+
+    AvlTree_new(&tree, compare, nullptr, noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+    AvlTree_set_augmenter(&tree, augment, &num_calls);
+
+    for (SumNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+        contained[node.key] = node.value;
+
+        if (contained.size() % 256 == 0) {
+            require_aggregates(tree, contained);
+        }
+    }
+
+    REQUIRE(num_calls > 0);
+
+    for (std::size_t i = 0; i < replacements.size(); i += 3) {
+        replacements[i].value = 100;
+        REQUIRE(AvlTree_insert(&tree, &replacements[i].base.node) == &nodes[i].base.node);
+        contained[replacements[i].key] = 100;
+    }
+
+    require_aggregates(tree, contained);
+
+    for (int key : shuffled(std::vector<int>(keys), *urbg_ptr)) {
+        REQUIRE(AvlTree_remove(&tree, &key, het_compare, nullptr));
+        contained.erase(key);
+
+        if (contained.size() % 256 == 0) {
+            require_aggregates(tree, contained);
+        }
+    }
+
+    REQUIRE_FALSE(tree.root);
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("refresh after modifying a node") {
+    std::vector<int> keys = iota(NUM_INSERTIONS);
+    std::vector<SumNode> nodes(keys.begin(), keys.end());
+    std::map<int, long> contained;
+    std::size_t num_calls = 0;
+    AvlTree tree;
+
+    AvlTree_new(&tree, compare, nullptr, noop_delete, nullptr);
+    AvlTree_set_augmenter(&tree, augment, &num_calls);
+
+    for (SumNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+        contained[node.key] = node.value;
+    }
+
+    for (int key = 0; key < static_cast<int>(NUM_INSERTIONS); key += 5) {
+        AvlNode *const node = AvlTree_get_mut(&tree, &key, het_compare, nullptr);
+        REQUIRE(node);
+
+        as_sum_node(node).value = 1000 + key;
+        contained[key] = 1000 + key;
+
+        REQUIRE(AvlTree_refresh(&tree, &key, het_compare, nullptr) == node);
+    }
+
+    const int missing = -1;
+    REQUIRE_FALSE(AvlTree_refresh(&tree, &missing, het_compare, nullptr));
+
+    require_aggregates(tree, contained);
+
+    AvlTree_drop(&tree);
+}
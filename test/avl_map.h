@@ -29,8 +29,10 @@
 #include "bloodhound.h"
 
 #include <functional>
+#include <new>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace avl {
 
@@ -46,22 +48,24 @@ template <typename K, typename V>
 class Map {
 public:
     Map() noexcept {
-        AvlTree_new(&impl_, Map::comparator, &comparator_, Map::deleter, nullptr);
+        AvlNodePool_new(&pool_, sizeof(Node), 0);
+        AvlTree_new(&impl_, Map::comparator, &comparator_, Map::node_deleter(), &pool_);
     }
 
     ~Map() {
         AvlTree_drop(&impl_);
+        AvlNodePool_drop(&pool_);
     }
 
     template <typename L, typename W,
               typename std::enable_if<std::is_constructible<K, L>::value
                                       && std::is_constructible<V, W>::value, int>::type = 0>
     std::pair<std::pair<K, V>&, bool> insert(L &&key, W &&value) {
-        Node *const node = new Node(std::forward<L>(key), std::forward<W>(value));
+        Node *const node = new_node(std::forward<L>(key), std::forward<W>(value));
         Node *const previous = reinterpret_cast<Node*>(AvlTree_insert(&impl_, &node->node));
 
         if (previous) {
-            delete previous;
+            Map::deleter(&previous->node, &pool_);
 
             return {node->kv, true};
         }
@@ -78,13 +82,13 @@ public:
     std::pair<std::pair<K, V>&, bool> insert_or_assign(L &&key, W &&value) {
         using T = typename std::decay<L>::type;
 
-        std::pair<L&&, W&&> kv(std::forward<L>(key), std::forward<W>(value));
+        InsertContext<L, W> context = {this, {std::forward<L>(key), std::forward<W>(value)}};
         const T &key_ref = key;
         int inserted;
 
         Node *const node = reinterpret_cast<Node*>(
             AvlTree_get_or_insert(&impl_, &key_ref, Map::het_comparator<T>,
-                                  &comparator_, Map::do_insert<L, W>, &kv, &inserted)
+                                  &comparator_, Map::do_insert<L, W>, &context, &inserted)
         );
 
         if (!inserted) {
@@ -102,7 +106,7 @@ public:
         );
 
         if (previous) {
-            delete previous;
+            Map::deleter(&previous->node, &pool_);
 
             return true;
         }
@@ -138,9 +142,85 @@ public:
         AvlTree_clear(&impl_);
     }
 
+    std::vector<K> keys() const {
+        std::vector<K> keys;
+        AvlCursor cursor;
+
+        AvlCursor_new(&cursor, &impl_);
+
+        for (const AvlNode *node = AvlCursor_first(&cursor); node;
+             node = AvlCursor_next(&cursor)) {
+            keys.push_back(reinterpret_cast<const Node*>(node)->kv.first);
+        }
+
+        return keys;
+    }
+
+    std::vector<K> reverse_keys() const {
+        std::vector<K> keys;
+        AvlCursor cursor;
+
+        AvlCursor_new(&cursor, &impl_);
+
+        for (const AvlNode *node = AvlCursor_last(&cursor); node;
+             node = AvlCursor_prev(&cursor)) {
+            keys.push_back(reinterpret_cast<const Node*>(node)->kv.first);
+        }
+
+        return keys;
+    }
+
+    std::vector<K> keys_from(const K &key) const {
+        std::vector<K> keys;
+        AvlCursor cursor;
+
+        AvlCursor_new(&cursor, &impl_);
+
+        for (const AvlNode *node = AvlCursor_seek(&cursor, &key, Map::het_comparator<K>,
+                                                  const_cast<Less*>(&comparator_)); node;
+             node = AvlCursor_next(&cursor)) {
+            keys.push_back(reinterpret_cast<const Node*>(node)->kv.first);
+        }
+
+        return keys;
+    }
+
 private:
-    static void deleter(AvlNode *node, void*) {
-        delete reinterpret_cast<Node*>(node);
+    struct Node;
+
+    template <typename L, typename W>
+    struct InsertContext {
+        Map *map;
+        std::pair<L&&, W&&> kv;
+    };
+
+    template <typename L, typename W>
+    Node* new_node(L &&key, W &&value) {
+        void *const memory = AvlNodePool_alloc(&pool_);
+
+        try {
+            return new (memory) Node(std::forward<L>(key), std::forward<W>(value));
+        } catch (...) {
+            AvlNodePool_free(&pool_, memory);
+
+            throw;
+        }
+    }
+
+    // trivially destructible nodes let AvlTree_clear reset the pool instead of walking the tree
+    static AvlDeleter node_deleter() noexcept {
+        if (std::is_trivially_destructible<Node>::value) {
+            return AvlNodePool_deleter;
+        }
+
+        return Map::deleter;
+    }
+
+    static void deleter(AvlNode *node_v, void *pool_v) {
+        Node *const node = reinterpret_cast<Node*>(node_v);
+
+        node->~Node();
+        AvlNodePool_free(static_cast<AvlNodePool*>(pool_v), node);
     }
 
     template <typename L>
@@ -173,10 +253,11 @@ private:
     }
 
     template <typename L, typename W>
-    static AvlNode* do_insert(const void*, void *kv_v) {
-        std::pair<L&&, W&&> &kv = *static_cast<std::pair<L&&, W&&>*>(kv_v);
+    static AvlNode* do_insert(const void*, void *context_v) {
+        InsertContext<L, W> &context = *static_cast<InsertContext<L, W>*>(context_v);
 
-        Node *const node = new Node(std::forward<L>(kv.first), std::forward<W>(kv.second));
+        Node *const node = context.map->new_node(std::forward<L>(context.kv.first),
+                                                 std::forward<W>(context.kv.second));
 
         return &node->node;
     }
@@ -190,10 +271,11 @@ private:
                  && std::is_nothrow_constructible<V, W>::value)
         : kv(std::forward<L>(l), std::forward<W>(w)) { }
 
-        AvlNode node = {nullptr, nullptr, 0};
+        AvlNode node = AvlNode();
         std::pair<K, V> kv;
     };
 
+    AvlNodePool pool_;
     AvlTree impl_;
     Less comparator_;
 };
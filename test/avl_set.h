@@ -125,7 +125,7 @@ private:
         Node(L &&l) noexcept(std::is_nothrow_constructible<K, L>::value)
         : key(std::forward<L>(l)) { }
 
-        AvlNode node = {nullptr, nullptr, 0};
+        AvlNode node = AvlNode();
         K key;
     };
 
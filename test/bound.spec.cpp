@@ -0,0 +1,151 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+namespace {
+
+struct Fixture {
+    Fixture() {
+        const auto urbg_ptr = make_urbg();
+        const std::vector<int> to_insert = rand_iota(NUM_INSERTIONS, *urbg_ptr);
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+        for (int i : to_insert) {
+            if (i % 3 == 0) {
+                keys.insert(i);
+            }
+        }
+
+        nodes = make_int_nodes(std::vector<int>(keys.begin(), keys.end()));
+
+        for (IntNode &node : nodes) {
+            AvlTree_insert(&tree, &node);
+        }
+    }
+
+    ~Fixture() {
+        AvlTree_drop(&tree);
+    }
+
+    std::set<int> keys;
+    std::vector<IntNode> nodes;
+    AvlTree tree;
+};
+
+template <typename It>
+const int* key_or_null(It it, It end) {
+    if (it == end) {
+        return nullptr;
+    }
+
+    return &*it;
+}
+
+void require_same(const AvlNode *node, const int *expected) {
+    if (!expected) {
+        REQUIRE_FALSE(node);
+    } else {
+        REQUIRE(node);
+        REQUIRE(int_node_key(node) == *expected);
+    }
+}
+
+} // namespace
+
+TEST_CASE("lower_bound, upper_bound, floor, ceiling") {
+    Fixture f;
+
+    for (int i = -2; i < static_cast<int>(NUM_INSERTIONS) + 2; ++i) {
+        const auto lower = f.keys.lower_bound(i);
+        const auto upper = f.keys.upper_bound(i);
+        const int *const floor = (upper == f.keys.begin()) ? nullptr : &*std::prev(upper);
+
+        require_same(AvlTree_lower_bound(&f.tree, &i, int_node_het_compare, nullptr, nullptr),
+                     key_or_null(lower, f.keys.end()));
+        require_same(AvlTree_upper_bound(&f.tree, &i, int_node_het_compare, nullptr, nullptr),
+                     key_or_null(upper, f.keys.end()));
+        require_same(AvlTree_floor(&f.tree, &i, int_node_het_compare, nullptr, nullptr),
+                     floor);
+        require_same(AvlTree_ceiling(&f.tree, &i, int_node_het_compare, nullptr, nullptr),
+                     key_or_null(lower, f.keys.end()));
+    }
+}
+
+TEST_CASE("bounds position cursors") {
+    Fixture f;
+
+    for (int i = -2; i < static_cast<int>(NUM_INSERTIONS) + 2; i += 7) {
+        AvlCursor cursor;
+        std::vector<int> scanned;
+
+        const AvlNode *node = AvlTree_upper_bound(&f.tree, &i, int_node_het_compare,
+                                                  nullptr, &cursor);
+        REQUIRE(AvlCursor_get(&cursor) == node);
+
+        for (; node; node = AvlCursor_next(&cursor)) {
+            scanned.push_back(int_node_key(node));
+        }
+
+        REQUIRE(scanned == std::vector<int>(f.keys.upper_bound(i), f.keys.end()));
+
+        scanned.clear();
+        node = AvlTree_floor(&f.tree, &i, int_node_het_compare, nullptr, &cursor);
+        REQUIRE(AvlCursor_get(&cursor) == node);
+
+        for (; node; node = AvlCursor_prev(&cursor)) {
+            scanned.push_back(int_node_key(node));
+        }
+
+        std::vector<int> expected(f.keys.begin(), f.keys.upper_bound(i));
+        REQUIRE(scanned == reversed(std::move(expected)));
+    }
+}
+
+TEST_CASE("bounds on an empty tree") {
+    AvlTree tree;
+    AvlCursor cursor;
+    const int key = 0;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    REQUIRE_FALSE(AvlTree_lower_bound(&tree, &key, int_node_het_compare, nullptr, &cursor));
+    REQUIRE_FALSE(AvlCursor_get(&cursor));
+    REQUIRE_FALSE(AvlTree_upper_bound(&tree, &key, int_node_het_compare, nullptr, &cursor));
+    REQUIRE_FALSE(AvlTree_floor(&tree, &key, int_node_het_compare, nullptr, &cursor));
+    REQUIRE_FALSE(AvlTree_ceiling(&tree, &key, int_node_het_compare, nullptr, &cursor));
+
+    AvlTree_drop(&tree);
+}
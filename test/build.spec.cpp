@@ -0,0 +1,337 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+int min_height(std::size_t n) {
+    int height = 0;
+
+    for (; n > 0; n /= 2) {
+        ++height;
+    }
+
+    return height;
+}
+
+struct Stream {
+    std::vector<IntNode> *nodes;
+    std::size_t taken;
+};
+
+AvlNode* next_node(void *stream_v) {
+    Stream &stream = *static_cast<Stream*>(stream_v);
+
+    return &(*stream.nodes)[stream.taken++];
+}
+
+void record_delete(AvlNode *node, void *deleted) {
+    static_cast<std::vector<const AvlNode*>*>(deleted)->push_back(node);
+}
+
+// sorted distinct keys in [min, min + range)
+template <typename URBG>
+std::vector<int> rand_sorted_keys(std::size_t n, int min, int range, URBG &&urbg) {
+    std::vector<int> keys = rand_iota(static_cast<std::size_t>(range), urbg, min);
+
+    keys.resize(n);
+    std::sort(keys.begin(), keys.end());
+
+    return keys;
+}
+
+} // namespace
+
+TEST_CASE("build from sorted array") {
+    for (std::size_t n = 0; n < 300; ++n) {
+        const std::vector<int> keys = iota(n);
+        std::vector<IntNode> nodes = make_int_nodes(keys);
+        std::vector<AvlNode*> node_ptrs;
+        AvlTree tree;
+
+        for (IntNode &node : nodes) {
+            node_ptrs.push_back(&node);
+        }
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+        AvlTree_build_sorted(&tree, node_ptrs.data(), n);
+
+        REQUIRE(tree.len == n);
+        REQUIRE(checked_height(tree.root) == min_height(n));
+        REQUIRE(keys_of(tree) == keys);
+
+        AvlTree_drop(&tree);
+    }
+}
+
+TEST_CASE("build from sorted stream, then modify") {
+    constexpr std::size_t NUM_NODES = 2048;
+    const std::vector<int> keys = mapped(iota(NUM_NODES), [](int i) { return 2 * i; });
+    std::vector<IntNode> nodes = make_int_nodes(keys);
+    std::vector<IntNode> odd_nodes = make_int_nodes(mapped(iota(NUM_NODES), [](int i) {
+        return 2 * i + 1;
+    }));
+    Stream stream = {&nodes, 0};
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_build_sorted_iter(&tree, NUM_NODES, next_node, &stream);
+
+    REQUIRE(stream.taken == NUM_NODES);
+    REQUIRE(tree.len == NUM_NODES);
+    REQUIRE(checked_height(tree.root) == min_height(NUM_NODES));
+    REQUIRE(keys_of(tree) == keys);
+
+    for (IntNode &node : odd_nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+
+    REQUIRE(keys_of(tree) == iota(2 * NUM_NODES));
+
+    for (int key : keys) {
+        REQUIRE(AvlTree_remove(&tree, &key, int_node_het_compare, nullptr));
+    }
+
+    REQUIRE(checked_height(tree.root) > 0);
+    REQUIRE(tree.len == NUM_NODES);
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("build a sized tree") {
+    constexpr std::size_t NUM_NODES = 1000;
+    std::vector<SizedIntNode> nodes = make_int_nodes<SizedIntNode>(iota(NUM_NODES));
+    std::vector<AvlNode*> node_ptrs;
+    AvlTree tree;
+
+    for (SizedIntNode &node : nodes) {
+        node_ptrs.push_back(&node.base.node);
+    }
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+    AvlTree_build_sorted(&tree, node_ptrs.data(), NUM_NODES);
+
+    for (std::size_t i = 0; i < NUM_NODES; ++i) {
+        REQUIRE(AvlTree_select(&tree, i, nullptr) == node_ptrs[i]);
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("insert sorted batches") {
+    constexpr std::size_t NUM_NODES = 4096;
+    constexpr int NUM_BATCHES = 4;
+    // the largest batch is merged in first and inserted node by node afterwards
+    const std::size_t batch_size = GENERATE(as<std::size_t>(), 1, 10, 200, 3000, 10000);
+    const bool caches_extremes = GENERATE(false, true);
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(mapped(iota(NUM_NODES), [](int i) { return 2 * i; }));
+    std::deque<IntNode> batch_nodes;
+    std::vector<const AvlNode*> deleted;
+    std::map<int, const AvlNode*> expected;
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, record_delete, &deleted);
+
+    if (caches_extremes) {
+        AvlTree_enable_extremes(&tree);
+    }
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+        expected.emplace(node.key, &node);
+    }
+
+    for (int i = 0; i < NUM_BATCHES; ++i) {
+        // reaches past both ends of the tree and hits many of its keys
+        const int range = 2 * static_cast<int>(std::max(NUM_NODES, batch_size)) + 200;
+        const std::vector<int> keys = rand_sorted_keys(batch_size, -100, range, *urbg_ptr);
+        std::vector<AvlNode*> batch;
+        std::vector<const AvlNode*> expected_deleted;
+
+        for (int key : keys) {
+            batch_nodes.emplace_back(key);
+            batch.push_back(&batch_nodes.back());
+
+            const auto found = expected.find(key);
+
+            if (found != expected.end()) {
+                expected_deleted.push_back(found->second);
+                found->second = &batch_nodes.back();
+            } else {
+                expected.emplace(key, &batch_nodes.back());
+            }
+        }
+
+        deleted.clear();
+        AvlTree_insert_sorted_batch(&tree, batch.data(), batch.size());
+
+        REQUIRE(tree.len == expected.size());
+        REQUIRE(checked_height(tree.root) >= 0);
+        std::sort(deleted.begin(), deleted.end());
+        std::sort(expected_deleted.begin(), expected_deleted.end());
+        REQUIRE(deleted == expected_deleted);
+        REQUIRE(AvlTree_first(&tree) == expected.begin()->second);
+        REQUIRE(AvlTree_last(&tree) == expected.rbegin()->second);
+
+        for (const auto &entry : expected) {
+            REQUIRE(AvlTree_get(&tree, &entry.first, int_node_het_compare, nullptr)
+                    == entry.second);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("insert clustered sorted batches") {
+    constexpr int NUM_NODES = 1000;
+    constexpr int SPACING = 100;
+    const bool tracks_sizes = GENERATE(false, true);
+    const auto urbg_ptr = make_urbg();
+    std::uniform_int_distribution<int> run_length(1, 40);
+    std::bernoulli_distribution replaces(0.5);
+    std::vector<SizedIntNode> nodes = make_int_nodes<SizedIntNode>(
+        mapped(iota(NUM_NODES), [](int i) { return SPACING * i; })
+    );
+    std::vector<int> keys;
+    std::vector<const AvlNode*> deleted;
+    std::map<int, const AvlNode*> expected;
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, record_delete, &deleted);
+
+    if (tracks_sizes) {
+        AvlTree_enable_sizes(&tree);
+    }
+
+    AvlTree_enable_extremes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        AvlTree_insert(&tree, &node.base.node);
+        expected.emplace(node.key, &node.base.node);
+    }
+
+    // runs of consecutive keys in a few gaps, including the ones past either end
+    std::vector<int> gaps = rand_iota(NUM_NODES - 1, *urbg_ptr);
+    gaps.resize(30);
+    gaps.push_back(-1);
+    gaps.push_back(NUM_NODES - 1);
+
+    for (int gap : gaps) {
+        const int length = run_length(*urbg_ptr);
+
+        if (gap >= 0 && replaces(*urbg_ptr)) {
+            keys.push_back(SPACING * gap);
+        }
+
+        for (int i = 1; i <= length; ++i) {
+            keys.push_back(SPACING * gap + i);
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    std::vector<SizedIntNode> batch_nodes = make_int_nodes<SizedIntNode>(keys);
+    std::vector<AvlNode*> batch;
+
+    for (SizedIntNode &node : batch_nodes) {
+        batch.push_back(&node.base.node);
+        expected[node.key] = &node.base.node;
+    }
+
+    AvlTree_insert_sorted_batch(&tree, batch.data(), batch.size());
+
+    REQUIRE(tree.len == expected.size());
+    REQUIRE(deleted.size() == NUM_NODES + batch.size() - expected.size());
+    REQUIRE(checked_height(tree.root) >= 0);
+    REQUIRE(AvlTree_first(&tree) == expected.begin()->second);
+    REQUIRE(AvlTree_last(&tree) == expected.rbegin()->second);
+
+    std::size_t rank = 0;
+
+    for (const auto &entry : expected) {
+        REQUIRE(AvlTree_get(&tree, &entry.first, sized_int_node_het_compare, nullptr)
+                == entry.second);
+
+        if (tracks_sizes) {
+            REQUIRE(AvlTree_select(&tree, rank, nullptr) == entry.second);
+        }
+
+        ++rank;
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("insert sorted batches into a sized tree") {
+    constexpr std::size_t NUM_NODES = 1000;
+    const std::size_t batch_size = GENERATE(as<std::size_t>(), 500, 2500);
+    const auto urbg_ptr = make_urbg();
+    std::vector<SizedIntNode> nodes =
+        make_int_nodes<SizedIntNode>(mapped(iota(NUM_NODES), [](int i) { return 2 * i; }));
+    std::vector<SizedIntNode> batch_nodes = make_int_nodes<SizedIntNode>(
+        rand_sorted_keys(batch_size, 0, 2 * static_cast<int>(batch_size), *urbg_ptr)
+    );
+    std::vector<AvlNode*> batch;
+    std::vector<const AvlNode*> deleted;
+    std::map<int, const AvlNode*> expected;
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, record_delete, &deleted);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        AvlTree_insert(&tree, &node.base.node);
+        expected.emplace(node.key, &node.base.node);
+    }
+
+    for (SizedIntNode &node : batch_nodes) {
+        batch.push_back(&node.base.node);
+        expected[node.key] = &node.base.node;
+    }
+
+    AvlTree_insert_sorted_batch(&tree, batch.data(), batch.size());
+
+    REQUIRE(tree.len == expected.size());
+    REQUIRE(deleted.size() == NUM_NODES + batch_size - expected.size());
+
+    std::size_t rank = 0;
+
+    for (const auto &entry : expected) {
+        REQUIRE(AvlTree_select(&tree, rank, nullptr) == entry.second);
+        ++rank;
+    }
+
+    AvlTree_drop(&tree);
+}
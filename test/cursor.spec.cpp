@@ -0,0 +1,119 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "avl_map.h"
+#include "int_node.h"
+#include "util.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+TEST_CASE("empty cursor") {
+    avl::Map<int, int> map;
+
+    REQUIRE(map.keys().empty());
+    REQUIRE(map.reverse_keys().empty());
+    REQUIRE(map.keys_from(0).empty());
+}
+
+TEST_CASE("sorted insert, forward and reverse iteration") {
+    avl::Map<int, int> map;
+    const std::vector<int> to_insert = iota(NUM_INSERTIONS);
+
+    for (int i : to_insert) {
+        REQUIRE_FALSE(map.insert(i, i).second);
+    }
+
+    REQUIRE(map.keys() == to_insert);
+    REQUIRE(map.reverse_keys() == reversed(std::vector<int>(to_insert)));
+}
+
+TEST_CASE("random insert, forward and reverse iteration") {
+    avl::Map<int, int> map;
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> to_insert = rand_iota(NUM_INSERTIONS, *urbg_ptr);
+
+    for (int i : to_insert) {
+        REQUIRE_FALSE(map.insert(i, i).second);
+    }
+
+    const std::vector<int> expected = sorted(std::vector<int>(to_insert));
+
+    REQUIRE(map.keys() == expected);
+    REQUIRE(map.reverse_keys() == reversed(std::vector<int>(expected)));
+}
+
+TEST_CASE("random insert, seek") {
+    avl::Map<int, int> map;
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> to_insert = rand_iota(NUM_INSERTIONS, *urbg_ptr);
+
+    for (int i : to_insert) {
+        if (i % 2 == 0) {
+            REQUIRE_FALSE(map.insert(i, i).second);
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(NUM_INSERTIONS); i += 64) {
+        std::vector<int> expected;
+
+        for (int j = i; j < static_cast<int>(NUM_INSERTIONS); j += 2) {
+            expected.push_back(j);
+        }
+
+        REQUIRE(map.keys_from(i) == expected);
+        REQUIRE(map.keys_from(i + 1).empty());
+    }
+}
+
+TEST_CASE("cursor wraps around the end") {
+    std::vector<IntNode> nodes = make_int_nodes(iota(16));
+    AvlTree tree;
+    AvlCursor cursor;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+
+    AvlCursor_new(&cursor, &tree);
+    REQUIRE_FALSE(AvlCursor_get(&cursor));
+
+    REQUIRE(AvlCursor_next(&cursor) == &nodes.front());
+    REQUIRE(AvlCursor_prev(&cursor) == nullptr);
+    REQUIRE(AvlCursor_prev(&cursor) == &nodes.back());
+    REQUIRE(AvlCursor_next(&cursor) == nullptr);
+    REQUIRE_FALSE(AvlCursor_get_mut(&cursor));
+
+    REQUIRE(AvlCursor_last(&cursor) == &nodes.back());
+    REQUIRE(AvlCursor_prev(&cursor) == &nodes[14]);
+    REQUIRE(AvlCursor_get_mut(&cursor) == &nodes[14]);
+
+    AvlTree_drop(&tree);
+}
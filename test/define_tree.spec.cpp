@@ -0,0 +1,131 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+namespace {
+
+AVL_DEFINE_TREE(int_tree, IntNode, (lhs->key > rhs->key) - (lhs->key < rhs->key))
+
+AVL_DEFINE_TREE(sized_int_tree, SizedIntNode, (lhs->key > rhs->key) - (lhs->key < rhs->key))
+
+// is not called, but must compile without warnings
+AVL_DEFINE_TREE(unused_tree, IntNode, lhs->key - rhs->key)
+
+void require_contents(const AvlTree &tree, const std::set<int> &contained) {
+    REQUIRE(tree.len == contained.size());
+    REQUIRE(checked_height(tree.root) >= 0);
+
+    for (int key = -1; key <= static_cast<int>(NUM_INSERTIONS); ++key) {
+        const IntNode probe(key);
+        const IntNode *const found = int_tree_get(&tree, &probe);
+        const IntNode *const lower_bound = int_tree_lower_bound(&tree, &probe);
+        const auto expected_lower_bound = contained.lower_bound(key);
+
+        REQUIRE(found == AvlTree_get(&tree, &key, int_node_het_compare, nullptr));
+        REQUIRE(static_cast<bool>(found) == (contained.count(key) == 1));
+
+        if (expected_lower_bound == contained.end()) {
+            REQUIRE_FALSE(lower_bound);
+        } else {
+            REQUIRE(lower_bound);
+            REQUIRE(lower_bound->key == *expected_lower_bound);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("defined tree insert, get and remove") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(NUM_INSERTIONS, *urbg_ptr));
+    std::set<int> contained;
+    AvlTree tree;
+
+    int_tree_new(&tree, int_node_noop_delete, nullptr);
+    require_contents(tree, contained);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(int_tree_insert(&tree, &node));
+        contained.insert(node.key);
+    }
+
+    require_contents(tree, contained);
+
+    // replacing a node hands back the old one
+    IntNode replacement(nodes[0].key);
+    REQUIRE(int_tree_insert(&tree, &replacement) == &nodes[0]);
+    REQUIRE(int_tree_get(&tree, &replacement) == &replacement);
+
+    for (int key : rand_iota(NUM_INSERTIONS / 2, *urbg_ptr)) {
+        const IntNode probe(key);
+        const IntNode *const removed = int_tree_remove(&tree, &probe);
+
+        REQUIRE(removed);
+        REQUIRE(removed->key == key);
+        REQUIRE_FALSE(int_tree_remove(&tree, &probe));
+        contained.erase(key);
+    }
+
+    require_contents(tree, contained);
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("defined tree keeps sizes") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<SizedIntNode> nodes =
+        make_int_nodes<SizedIntNode>(rand_iota(NUM_INSERTIONS, *urbg_ptr));
+    AvlTree tree;
+
+    sized_int_tree_new(&tree, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(sized_int_tree_insert(&tree, &node));
+    }
+
+    for (int key = 0; key < static_cast<int>(NUM_INSERTIONS); key += 2) {
+        const SizedIntNode probe(key);
+        REQUIRE(sized_int_tree_remove(&tree, &probe));
+    }
+
+    for (std::size_t i = 0; i < tree.len; ++i) {
+        const AvlNode *const node = AvlTree_select(&tree, i, nullptr);
+
+        REQUIRE(node);
+        REQUIRE(sized_int_node_key(node) == static_cast<int>(2 * i + 1));
+    }
+
+    AvlTree_drop(&tree);
+}
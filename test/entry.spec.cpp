@@ -0,0 +1,166 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+#include "int_node.h"
+#include "util.h"
+
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr int NUM_KEYS = 256;
+constexpr std::size_t NUM_UPDATES = 8192;
+
+namespace {
+
+struct Counter : IntNode {
+    explicit Counter(int k) noexcept : IntNode(k), count(0) { }
+
+    int count;
+};
+
+std::map<int, int> collect_counts(const AvlTree &tree) {
+    std::map<int, int> counts;
+    AvlCursor cursor;
+
+    AvlCursor_new(&cursor, &tree);
+
+    for (const AvlNode *node = AvlCursor_first(&cursor); node; node = AvlCursor_next(&cursor)) {
+        counts.emplace(int_node_key(node), static_cast<const Counter*>(node)->count);
+    }
+
+    return counts;
+}
+
+} // namespace
+
+TEST_CASE("entry counting and deleting at zero") {
+    const bool caches_extremes = GENERATE(false, true);
+    const auto urbg_ptr = make_urbg();
+    std::uniform_int_distribution<int> key_dist(0, NUM_KEYS - 1);
+    std::bernoulli_distribution increment_dist(0.6);
+    std::vector<Counter> counters;
+    std::map<int, int> expected;
+    AvlTree tree;
+
+    for (int key = 0; key < NUM_KEYS; ++key) {
+        counters.emplace_back(key);
+    }
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    if (caches_extremes) {
+        AvlTree_enable_extremes(&tree);
+    }
+
+    for (std::size_t i = 0; i < NUM_UPDATES; ++i) {
+        const int key = key_dist(*urbg_ptr);
+        AvlEntry entry;
+        Counter *const counter = static_cast<Counter*>(
+            AvlTree_entry(&tree, &key, int_node_het_compare, nullptr, &entry)
+        );
+
+        REQUIRE(AvlEntry_get(&entry) == counter);
+        REQUIRE((counter != nullptr) == (expected.count(key) == 1));
+
+        if (!counter) {
+            counters[key].count = 1;
+            REQUIRE_FALSE(AvlEntry_insert(&entry, &counters[key]));
+            expected[key] = 1;
+        } else if (increment_dist(*urbg_ptr)) {
+            ++counter->count;
+            ++expected[key];
+        } else if (--counter->count == 0) {
+            REQUIRE(AvlEntry_remove(&entry) == counter);
+            REQUIRE_FALSE(AVL_NODE_LEFT(counter));
+            REQUIRE_FALSE(AVL_NODE_RIGHT(counter));
+            expected.erase(key);
+        } else {
+            --expected[key];
+        }
+
+        REQUIRE(tree.len == expected.size());
+        REQUIRE(checked_height(tree.root) >= 0);
+
+        if (caches_extremes && !expected.empty()) {
+            REQUIRE(int_node_key(AvlTree_first(&tree)) == expected.begin()->first);
+            REQUIRE(int_node_key(AvlTree_last(&tree)) == std::prev(expected.end())->first);
+        }
+    }
+
+    REQUIRE(collect_counts(tree) == expected);
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("entry replacing and then removing") {
+    std::vector<IntNode> nodes = make_int_nodes(iota(NUM_KEYS));
+    std::vector<IntNode> replacements = make_int_nodes(iota(NUM_KEYS));
+    AvlTree tree;
+    AvlEntry entry;
+    const int missing = NUM_KEYS;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    REQUIRE_FALSE(AvlTree_entry(&tree, &missing, int_node_het_compare, nullptr, &entry));
+    REQUIRE_FALSE(AvlEntry_get_mut(&entry));
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+    }
+
+    REQUIRE_FALSE(AvlTree_entry(&tree, &missing, int_node_het_compare, nullptr, &entry));
+    REQUIRE_FALSE(AvlEntry_get(&entry));
+
+    for (int key = 0; key < NUM_KEYS; key += 2) {
+        REQUIRE(AvlTree_entry(&tree, &key, int_node_het_compare, nullptr, &entry) == &nodes[key]);
+        REQUIRE(AvlEntry_insert(&entry, &replacements[key]) == &nodes[key]);
+        REQUIRE(AvlEntry_get_mut(&entry) == &replacements[key]);
+
+        // the entry survives replacing its node
+        if (key % 4 == 0) {
+            REQUIRE(AvlEntry_remove(&entry) == &replacements[key]);
+        }
+
+        REQUIRE(checked_height(tree.root) >= 0);
+    }
+
+    REQUIRE(tree.len == NUM_KEYS - NUM_KEYS / 4);
+
+    for (int key = 0; key < NUM_KEYS; ++key) {
+        const AvlNode *const found = AvlTree_get(&tree, &key, int_node_het_compare, nullptr);
+
+        if (key % 4 == 0) {
+            REQUIRE_FALSE(found);
+        } else if (key % 2 == 0) {
+            REQUIRE(found == &replacements[key]);
+        } else {
+            REQUIRE(found == &nodes[key]);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
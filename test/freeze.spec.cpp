@@ -0,0 +1,102 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <cstring>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+void extract_int_key(const AvlNode *node, void *key, void*) {
+    const int k = int_node_key(node);
+
+    std::memcpy(key, &k, sizeof(int));
+}
+
+int compare_int_keys(const void *lhs_v, const void *rhs_v, void*) {
+    int lhs;
+    int rhs;
+
+    std::memcpy(&lhs, lhs_v, sizeof(int));
+    std::memcpy(&rhs, rhs_v, sizeof(int));
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+} // namespace
+
+TEST_CASE("empty frozen tree") {
+    AvlTree tree;
+    AvlFrozenTree frozen;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_freeze(&tree, &frozen, sizeof(int), extract_int_key, nullptr);
+
+    const int key = 0;
+    REQUIRE(frozen.len == 0);
+    REQUIRE_FALSE(AvlFrozenTree_get(&frozen, &key, compare_int_keys, nullptr));
+    REQUIRE_FALSE(AvlFrozenTree_lower_bound(&frozen, &key, compare_int_keys, nullptr));
+
+    AvlFrozenTree_drop(&frozen);
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("frozen tree lookups") {
+    const auto urbg_ptr = make_urbg();
+
+    // every size from 1 to 64 covers complete and incomplete last levels
+    for (int n = 1; n <= 64; ++n) {
+        // even keys from 0 to 2n - 2, so odd keys are missing
+        std::vector<IntNode> nodes =
+            make_int_nodes(mapped(rand_iota(static_cast<std::size_t>(n), *urbg_ptr),
+                                  [](int k) { return 2 * k; }));
+        AvlTree tree;
+        AvlFrozenTree frozen;
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+        for (IntNode &node : nodes) {
+            AvlTree_insert(&tree, &node);
+        }
+
+        AvlTree_freeze(&tree, &frozen, sizeof(int), extract_int_key, nullptr);
+        REQUIRE(frozen.len == static_cast<std::size_t>(n));
+
+        for (int key = -1; key <= 2 * n; ++key) {
+            REQUIRE(AvlFrozenTree_get(&frozen, &key, compare_int_keys, nullptr)
+                    == AvlTree_get(&tree, &key, int_node_het_compare, nullptr));
+            REQUIRE(AvlFrozenTree_lower_bound(&frozen, &key, compare_int_keys, nullptr)
+                    == AvlTree_lower_bound(&tree, &key, int_node_het_compare, nullptr,
+                                           nullptr));
+        }
+
+        AvlFrozenTree_drop(&frozen);
+        AvlTree_drop(&tree);
+    }
+}
@@ -0,0 +1,141 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "freeze_int.h"
+#include "int_node.h"
+#include "util.h"
+
+#include <climits>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+AvlIntKey extract_int_key(const AvlNode *node, void*) {
+    return int_node_key(node);
+}
+
+using LowerBoundIndex = size_t (*)(const AvlFrozenIntTree*, AvlIntKey);
+
+// every search this processor can run
+std::vector<LowerBoundIndex> supported_searches() {
+    std::vector<LowerBoundIndex> searches = {int_lower_bound_index_scalar};
+
+#ifdef BLOODHOUND_X86_SIMD
+    if (__builtin_cpu_supports("sse2")) {
+        searches.push_back(int_lower_bound_index_sse2);
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        searches.push_back(int_lower_bound_index_avx2);
+    }
+#endif
+
+    return searches;
+}
+
+} // namespace
+
+TEST_CASE("empty frozen int tree") {
+    AvlTree tree;
+    AvlFrozenIntTree frozen;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_freeze_ints(&tree, &frozen, extract_int_key, nullptr);
+
+    REQUIRE(frozen.num_blocks == 0);
+    REQUIRE_FALSE(AvlFrozenIntTree_get(&frozen, 0));
+    REQUIRE_FALSE(AvlFrozenIntTree_get(&frozen, AVL_INT_KEY_MAX));
+    REQUIRE_FALSE(AvlFrozenIntTree_lower_bound(&frozen, 0));
+
+    AvlFrozenIntTree_drop(&frozen);
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("frozen int tree lookups") {
+    const auto urbg_ptr = make_urbg();
+
+    // one to three levels of blocks, each with a partly filled last block
+    for (int n : {1, 15, 16, 17, 100, 272, 300, 4913, 5000}) {
+        // even keys from -n to n - 2, so odd keys are missing
+        std::vector<IntNode> nodes =
+            make_int_nodes(mapped(rand_iota(static_cast<std::size_t>(n), *urbg_ptr),
+                                  [n](int k) { return 2 * k - n; }));
+        AvlTree tree;
+        AvlFrozenIntTree frozen;
+
+        AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+        for (IntNode &node : nodes) {
+            AvlTree_insert(&tree, &node);
+        }
+
+        AvlTree_freeze_ints(&tree, &frozen, extract_int_key, nullptr);
+        REQUIRE(frozen.len == static_cast<std::size_t>(n));
+
+        for (LowerBoundIndex search : supported_searches()) {
+            frozen.lower_bound_index = search;
+
+            for (int key = -n - 1; key <= n; ++key) {
+                REQUIRE(AvlFrozenIntTree_get(&frozen, key)
+                        == AvlTree_get(&tree, &key, int_node_het_compare, nullptr));
+                REQUIRE(AvlFrozenIntTree_lower_bound(&frozen, key)
+                        == AvlTree_lower_bound(&tree, &key, int_node_het_compare, nullptr,
+                                               nullptr));
+            }
+        }
+
+        AvlFrozenIntTree_drop(&frozen);
+        AvlTree_drop(&tree);
+    }
+}
+
+TEST_CASE("frozen int tree with extreme keys") {
+    std::vector<IntNode> nodes = make_int_nodes({INT_MIN, -1, 0, INT_MAX});
+    AvlTree tree;
+    AvlFrozenIntTree frozen;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+    }
+
+    AvlTree_freeze_ints(&tree, &frozen, extract_int_key, nullptr);
+
+    for (LowerBoundIndex search : supported_searches()) {
+        frozen.lower_bound_index = search;
+
+        REQUIRE(AvlFrozenIntTree_get(&frozen, INT_MIN) == &nodes[0]);
+        REQUIRE(AvlFrozenIntTree_get(&frozen, INT_MAX) == &nodes[3]);
+        REQUIRE(AvlFrozenIntTree_lower_bound(&frozen, 1) == &nodes[3]);
+        REQUIRE(AvlFrozenIntTree_lower_bound(&frozen, INT_MAX) == &nodes[3]);
+        REQUIRE_FALSE(AvlFrozenIntTree_get(&frozen, INT_MAX - 1));
+    }
+
+    AvlFrozenIntTree_drop(&frozen);
+    AvlTree_drop(&tree);
+}
@@ -24,8 +24,10 @@
 //  IN THE SOFTWARE.
 
 #include "avl_map.h"
+#include "int_node.h"
 #include "util.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -93,3 +95,48 @@ TEST_CASE("random insert, random get") {
         REQUIRE(map.get(i));
     }
 }
+
+TEST_CASE("batched get") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(NUM_INSERTIONS, *urbg_ptr));
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    // half of the keys are missing, and the batch is not a multiple of its width
+    const std::vector<int> keys =
+        shuffled(iota(2 * NUM_INSERTIONS + 5, -static_cast<int>(NUM_INSERTIONS) / 2), *urbg_ptr);
+    std::vector<const void*> key_ptrs;
+
+    for (const int &key : keys) {
+        key_ptrs.push_back(&key);
+    }
+
+    std::vector<const AvlNode*> found(keys.size(), &nodes[0]);
+    AvlTree_get_batch(&tree, key_ptrs.data(), key_ptrs.size(), int_node_het_compare, nullptr,
+                      found.data());
+
+    for (const AvlNode *node : found) {
+        REQUIRE_FALSE(node);
+    }
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+    }
+
+    for (std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(15), keys.size()}) {
+        std::fill(found.begin(), found.end(), nullptr);
+        AvlTree_get_batch(&tree, key_ptrs.data(), n, int_node_het_compare, nullptr,
+                          found.data());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            REQUIRE(found[i] == AvlTree_get(&tree, &keys[i], int_node_het_compare, nullptr));
+        }
+
+        for (std::size_t i = n; i < found.size(); ++i) {
+            REQUIRE_FALSE(found[i]);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
@@ -0,0 +1,166 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "bloodhound.h"
+#include "util.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+static_assert(sizeof(AvlIndexNode) == 8, "index nodes must be 8 bytes");
+
+namespace {
+
+constexpr AvlIndex NUM_ELEMENTS = 4096;
+
+int compare_keys(AvlIndex lhs, AvlIndex rhs, void *keys_v) {
+    const int *const keys = static_cast<const int*>(keys_v);
+
+    return (keys[lhs] > keys[rhs]) - (keys[lhs] < keys[rhs]);
+}
+
+int compare_key(const void *lhs_v, AvlIndex rhs, void *keys_v) {
+    const int lhs = *static_cast<const int*>(lhs_v);
+    const int *const keys = static_cast<const int*>(keys_v);
+
+    return (lhs > keys[rhs]) - (lhs < keys[rhs]);
+}
+
+int push_index(void *indices_v, AvlIndex index) {
+    static_cast<std::vector<AvlIndex>*>(indices_v)->push_back(index);
+
+    return 0;
+}
+
+std::vector<AvlIndex> indices_of(const AvlIndexTree &tree) {
+    std::vector<AvlIndex> indices;
+
+    AvlIndexTree_traverse(&tree, push_index, &indices);
+
+    return indices;
+}
+
+// returns the height of the subtree rooted at index, or -1 if a balance bit is wrong
+int checked_index_height(const AvlIndexTree &tree, AvlIndex index) {
+    if (index == AVL_INDEX_NIL) {
+        return 0;
+    }
+
+    const AvlIndexNode &node = tree.nodes[index];
+    const int left = checked_index_height(tree, node.left & AVL_INDEX_NIL);
+    const int right = checked_index_height(tree, node.right & AVL_INDEX_NIL);
+    const bool left_taller = (node.left & ~AVL_INDEX_NIL) != 0;
+    const bool right_taller = (node.right & ~AVL_INDEX_NIL) != 0;
+
+    if (left < 0 || right < 0 || left_taller != (left == right + 1)
+        || right_taller != (right == left + 1) || left > right + 1 || right > left + 1) {
+        return -1;
+    }
+
+    return std::max(left, right) + 1;
+}
+
+} // namespace
+
+TEST_CASE("index tree random insert and remove") {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> order = rand_iota(NUM_ELEMENTS, *urbg_ptr);
+    std::vector<int> keys(NUM_ELEMENTS);
+    std::vector<AvlIndexNode> nodes(NUM_ELEMENTS);
+    AvlIndexTree tree;
+
+    // element i holds key 3 * order[i]
+    for (AvlIndex i = 0; i < NUM_ELEMENTS; ++i) {
+        keys[i] = 3 * order[i];
+    }
+
+    AvlIndexTree_new(&tree, nodes.data(), compare_keys, keys.data());
+
+    for (AvlIndex i = 0; i < NUM_ELEMENTS; ++i) {
+        REQUIRE(AvlIndexTree_insert(&tree, i) == AVL_INDEX_NIL);
+
+        if (i % 256 == 0) {
+            REQUIRE(checked_index_height(tree, tree.root) >= 0);
+        }
+    }
+
+    REQUIRE(tree.len == NUM_ELEMENTS);
+    REQUIRE(checked_index_height(tree, tree.root) >= 0);
+
+    std::vector<AvlIndex> expected(NUM_ELEMENTS);
+    for (AvlIndex i = 0; i < NUM_ELEMENTS; ++i) {
+        expected[static_cast<std::size_t>(order[i])] = i;
+    }
+
+    REQUIRE(indices_of(tree) == expected);
+
+    for (AvlIndex i = 0; i < NUM_ELEMENTS; ++i) {
+        const int key = keys[i];
+        const int missing = key + 1;
+
+        REQUIRE(AvlIndexTree_get(&tree, &key, compare_key, keys.data()) == i);
+        REQUIRE(AvlIndexTree_get(&tree, &missing, compare_key, keys.data()) == AVL_INDEX_NIL);
+    }
+
+    for (int key : shuffled(mapped(iota(NUM_ELEMENTS), [](int k) { return 3 * k; }), *urbg_ptr)) {
+        const int missing = key + 1;
+        const AvlIndex removed = AvlIndexTree_remove(&tree, &key, compare_key, keys.data());
+
+        REQUIRE(removed != AVL_INDEX_NIL);
+        REQUIRE(keys[removed] == key);
+        REQUIRE(AvlIndexTree_remove(&tree, &missing, compare_key, keys.data()) == AVL_INDEX_NIL);
+
+        if (tree.len % 256 == 0) {
+            REQUIRE(checked_index_height(tree, tree.root) >= 0);
+        }
+    }
+
+    REQUIRE(tree.len == 0);
+    REQUIRE(tree.root == AVL_INDEX_NIL);
+}
+
+TEST_CASE("index tree replaces equal elements") {
+    std::vector<int> keys = {5, 3, 8, 1, 4, 7, 9, 4};
+    std::vector<AvlIndexNode> nodes(keys.size());
+    AvlIndexTree tree;
+
+    AvlIndexTree_new(&tree, nodes.data(), compare_keys, keys.data());
+
+    for (AvlIndex i = 0; i < 7; ++i) {
+        REQUIRE(AvlIndexTree_insert(&tree, i) == AVL_INDEX_NIL);
+    }
+
+    REQUIRE(AvlIndexTree_insert(&tree, 7) == 4);
+    REQUIRE(tree.len == 7);
+    REQUIRE(checked_index_height(tree, tree.root) >= 0);
+    REQUIRE(indices_of(tree) == std::vector<AvlIndex>({3, 1, 7, 0, 5, 2, 6}));
+
+    AvlIndexTree_clear(&tree);
+
+    REQUIRE(tree.len == 0);
+    REQUIRE(indices_of(tree).empty());
+}
@@ -24,6 +24,7 @@
 //  IN THE SOFTWARE.
 
 #include "avl_map.h"
+#include "int_node.h"
 #include "util.h"
 
 #include <algorithm>
@@ -89,3 +90,98 @@ TEST_CASE("random insertion") {
         }
     }
 }
+
+TEST_CASE("hinted insertion") {
+    std::vector<IntNode> nodes;
+    std::vector<IntNode> duplicates;
+    std::vector<IntNode> odd_nodes;
+    AvlTree tree;
+    AvlCursor end;
+
+    for (int i = 0; i < NUM_INSERTIONS; ++i) {
+        nodes.emplace_back(2 * i);
+        duplicates.emplace_back(2 * i);
+        odd_nodes.emplace_back(2 * i + 1);
+    }
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlCursor_new(&end, &tree);
+
+    SECTION("appending at the end") {
+        for (IntNode &node : nodes) {
+            REQUIRE_FALSE(AvlTree_insert_hint(&tree, &end, &node));
+            REQUIRE(AvlCursor_get(&end) == nullptr);
+        }
+
+        REQUIRE(checked_height(tree.root) >= 0);
+        REQUIRE(tree.len == nodes.size());
+
+        // equal to the last node, so it replaces it
+        REQUIRE(AvlTree_insert_hint(&tree, &end, &duplicates.back()) == &nodes.back());
+    }
+
+    SECTION("inserting before the hint") {
+        AvlCursor cursor;
+
+        for (IntNode &node : nodes) {
+            AvlTree_insert(&tree, &node);
+        }
+
+        // walk backwards, inserting key + 1 before each successor of key
+        AvlCursor_new(&cursor, &tree);
+
+        for (int i = NUM_INSERTIONS - 1; i >= 0; --i) {
+            if (i + 1 < NUM_INSERTIONS) {
+                const int successor = 2 * (i + 1);
+                REQUIRE(AvlCursor_seek(&cursor, &successor, int_node_het_compare, nullptr));
+            } else {
+                AvlCursor_new(&cursor, &tree);
+            }
+
+            REQUIRE_FALSE(AvlTree_insert_hint(&tree, &cursor, &odd_nodes[i]));
+            REQUIRE(checked_height(tree.root) >= 0);
+        }
+
+        REQUIRE(tree.len == 2 * nodes.size());
+
+        AvlCursor_new(&cursor, &tree);
+        int expected = 0;
+
+        for (const AvlNode *node = AvlCursor_first(&cursor); node;
+             node = AvlCursor_next(&cursor), ++expected) {
+            REQUIRE(int_node_key(node) == expected);
+        }
+
+        REQUIRE(expected == 2 * NUM_INSERTIONS);
+    }
+
+    SECTION("wrong and equal hints") {
+        const auto urbg_ptr = make_urbg();
+        AvlCursor cursor;
+
+        for (int i : rand_iota(NUM_INSERTIONS, *urbg_ptr)) {
+            const int hint_key = 2 * ((i * 7) % NUM_INSERTIONS);
+            AvlCursor_new(&cursor, &tree);
+            AvlCursor_seek(&cursor, &hint_key, int_node_het_compare, nullptr);
+
+            REQUIRE_FALSE(AvlTree_insert_hint(&tree, &cursor, &nodes[static_cast<std::size_t>(i)]));
+            REQUIRE(checked_height(tree.root) >= 0);
+        }
+
+        REQUIRE(tree.len == nodes.size());
+
+        for (int i : rand_iota(NUM_INSERTIONS, *urbg_ptr)) {
+            const int hint_key = 2 * ((i * 5) % NUM_INSERTIONS);
+            const std::size_t index = static_cast<std::size_t>(i);
+            AvlCursor_new(&cursor, &tree);
+            AvlCursor_seek(&cursor, &hint_key, int_node_het_compare, nullptr);
+
+            REQUIRE(AvlTree_insert_hint(&tree, &cursor, &duplicates[index]) == &nodes[index]);
+            REQUIRE(checked_height(tree.root) >= 0);
+        }
+
+        REQUIRE(tree.len == nodes.size());
+    }
+
+    AvlTree_drop(&tree);
+}
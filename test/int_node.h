@@ -0,0 +1,169 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#ifndef INT_NODE_H
+#define INT_NODE_H
+
+#include "bloodhound.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+struct IntNode : AvlNode {
+    explicit IntNode(int k) noexcept : AvlNode(), key(k) { }
+
+    int key;
+};
+
+inline int int_node_key(const AvlNode *node) noexcept {
+    return static_cast<const IntNode*>(node)->key;
+}
+
+inline int int_node_compare(const AvlNode *lhs, const AvlNode *rhs, void*) {
+    const int l = int_node_key(lhs);
+    const int r = int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+inline int int_node_het_compare(const void *lhs, const AvlNode *rhs, void*) {
+    const int l = *static_cast<const int*>(lhs);
+    const int r = int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+inline void int_node_noop_delete(AvlNode*, void*) { }
+
+struct SizedIntNode {
+    explicit SizedIntNode(int k) noexcept : key(k) {
+        base.node = AvlNode();
+        base.size = 1;
+    }
+
+    AvlSizedNode base;
+    int key;
+};
+
+inline int sized_int_node_key(const AvlNode *node) noexcept {
+    return reinterpret_cast<const SizedIntNode*>(node)->key;
+}
+
+inline int sized_int_node_compare(const AvlNode *lhs, const AvlNode *rhs, void*) {
+    const int l = sized_int_node_key(lhs);
+    const int r = sized_int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+inline int sized_int_node_het_compare(const void *lhs, const AvlNode *rhs, void*) {
+    const int l = *static_cast<const int*>(lhs);
+    const int r = sized_int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+struct ParentIntNode {
+    explicit ParentIntNode(int k) noexcept : key(k) {
+        base.node = AvlNode();
+        base.parent = nullptr;
+    }
+
+    AvlParentNode base;
+    int key;
+};
+
+inline int parent_int_node_key(const AvlNode *node) noexcept {
+    return reinterpret_cast<const ParentIntNode*>(node)->key;
+}
+
+inline int parent_int_node_compare(const AvlNode *lhs, const AvlNode *rhs, void*) {
+    const int l = parent_int_node_key(lhs);
+    const int r = parent_int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+inline int parent_int_node_het_compare(const void *lhs, const AvlNode *rhs, void*) {
+    const int l = *static_cast<const int*>(lhs);
+    const int r = parent_int_node_key(rhs);
+
+    return (l > r) - (l < r);
+}
+
+// returns the height of the subtree rooted at node, checking every balance factor on the way
+inline int checked_height(const AvlNode *node) {
+    if (!node) {
+        return 0;
+    }
+
+    const int left = checked_height(AVL_NODE_LEFT(node));
+    const int right = checked_height(AVL_NODE_RIGHT(node));
+    const int balance_factor = AVL_NODE_BALANCE_FACTOR(node);
+
+    if (left < 0 || right < 0 || balance_factor != right - left
+        || balance_factor < -1 || balance_factor > 1) {
+        return -1;
+    }
+
+    return (left > right ? left : right) + 1;
+}
+
+// the keys of every node in tree, in order
+inline std::vector<int> keys_of(const AvlTree &tree,
+                                int (*key_of)(const AvlNode*) = int_node_key) {
+    std::vector<int> keys;
+    AvlCursor cursor;
+
+    AvlCursor_new(&cursor, &tree);
+
+    for (const AvlNode *node = AvlCursor_first(&cursor); node; node = AvlCursor_next(&cursor)) {
+        keys.push_back(key_of(node));
+    }
+
+    return keys;
+}
+
+// checks the AVL invariants, the length and the keys of tree, whether or not it tracks sizes
+inline void require_valid(const AvlTree &tree, const std::vector<int> &expected) {
+    REQUIRE(checked_height(tree.root) >= 0);
+    REQUIRE(tree.len == expected.size());
+    REQUIRE(keys_of(tree, tree.tracks_sizes ? sized_int_node_key : int_node_key) == expected);
+}
+
+template <typename N = IntNode>
+std::vector<N> make_int_nodes(const std::vector<int> &keys) {
+    std::vector<N> nodes;
+    nodes.reserve(keys.size());
+
+    for (int key : keys) {
+        nodes.emplace_back(key);
+    }
+
+    return nodes;
+}
+
+#endif
@@ -0,0 +1,305 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+void insert_all(AvlTree &tree, std::vector<IntNode> &nodes) {
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+}
+
+void insert_all(AvlTree &tree, std::vector<SizedIntNode> &nodes) {
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+    }
+}
+
+template <typename N>
+void split_at_every_key(AvlHetComparator compare) {
+    const auto urbg_ptr = make_urbg();
+
+    for (int n : {0, 1, 2, 3, 7, 8, 31, 100, 257}) {
+        const std::vector<int> evens = mapped(iota(n), [](int i) { return 2 * i; });
+
+        for (int key = -1; key <= 2 * n; ++key) {
+            std::vector<N> nodes = make_int_nodes<N>(shuffled(std::vector<int>(evens), *urbg_ptr));
+            AvlTree tree;
+            AvlTree left;
+            AvlTree right;
+
+            insert_all(tree, nodes);
+            AvlTree_split(&tree, &key, compare, nullptr, &left, &right);
+
+            const auto middle = std::lower_bound(evens.begin(), evens.end(), key);
+
+            REQUIRE_FALSE(tree.root);
+            REQUIRE(tree.len == 0);
+            require_valid(left, std::vector<int>(evens.begin(), middle));
+            require_valid(right, std::vector<int>(middle, evens.end()));
+
+            AvlTree_concat(&left, &right);
+
+            require_valid(left, evens);
+            require_valid(right, {});
+
+            AvlTree_drop(&left);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("split at every key") {
+    SECTION("without sizes, counting the smaller half") {
+        split_at_every_key<IntNode>(int_node_het_compare);
+    }
+
+    SECTION("with sizes") {
+        split_at_every_key<SizedIntNode>(sized_int_node_het_compare);
+    }
+}
+
+TEST_CASE("split into self") {
+    const std::vector<int> keys = iota(64);
+    std::vector<IntNode> nodes = make_int_nodes(keys);
+    AvlTree tree;
+    AvlTree right;
+    const int key = 40;
+
+    insert_all(tree, nodes);
+    AvlTree_split(&tree, &key, int_node_het_compare, nullptr, &tree, &right);
+
+    require_valid(tree, iota(40));
+    require_valid(right, iota(24, 40));
+
+    AvlTree_drop(&tree);
+    AvlTree_drop(&right);
+}
+
+TEST_CASE("join trees of different heights") {
+    const auto urbg_ptr = make_urbg();
+
+    for (int left_len = 0; left_len < 48; ++left_len) {
+        for (int right_len = 0; right_len < 48; ++right_len) {
+            std::vector<IntNode> left_nodes =
+                make_int_nodes(shuffled(iota(left_len), *urbg_ptr));
+            IntNode pivot(left_len);
+            std::vector<IntNode> right_nodes =
+                make_int_nodes(shuffled(iota(right_len, left_len + 1), *urbg_ptr));
+            AvlTree left;
+            AvlTree right;
+
+            insert_all(left, left_nodes);
+            insert_all(right, right_nodes);
+            AvlTree_join(&left, &pivot, &right);
+
+            require_valid(left, iota(left_len + right_len + 1));
+            require_valid(right, {});
+
+            AvlTree_drop(&left);
+        }
+    }
+}
+
+TEST_CASE("concatenate trees of different heights") {
+    for (int left_len = 0; left_len < 48; ++left_len) {
+        for (int right_len = 0; right_len < 48; ++right_len) {
+            std::vector<IntNode> left_nodes = make_int_nodes(iota(left_len));
+            std::vector<IntNode> right_nodes =
+                make_int_nodes(reversed(iota(right_len, left_len)));
+            AvlTree left;
+            AvlTree right;
+
+            insert_all(left, left_nodes);
+            insert_all(right, right_nodes);
+            AvlTree_concat(&left, &right);
+
+            require_valid(left, iota(left_len + right_len));
+            require_valid(right, {});
+
+            AvlTree_drop(&left);
+        }
+    }
+}
+
+TEST_CASE("split and join keep sizes") {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = iota(1000);
+    std::vector<SizedIntNode> nodes =
+        make_int_nodes<SizedIntNode>(shuffled(std::vector<int>(keys), *urbg_ptr));
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+    AvlTree_enable_extremes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+    }
+
+    for (int key : {0, 1, 499, 500, 998, 999, 1000}) {
+        AvlTree left;
+        AvlTree right;
+
+        AvlTree_split(&tree, &key, sized_int_node_het_compare, nullptr, &left, &right);
+
+        REQUIRE(left.tracks_sizes);
+        REQUIRE(right.tracks_sizes);
+        REQUIRE(left.len == static_cast<std::size_t>(key));
+        REQUIRE(right.len == keys.size() - static_cast<std::size_t>(key));
+        REQUIRE(checked_height(left.root) >= 0);
+        REQUIRE(checked_height(right.root) >= 0);
+        REQUIRE(keys_of(left, sized_int_node_key) == iota(key));
+        REQUIRE(keys_of(right, sized_int_node_key) == iota(1000 - key, key));
+
+        if (left.len > 0) {
+            REQUIRE(sized_int_node_key(AvlTree_first(&left)) == 0);
+            REQUIRE(sized_int_node_key(AvlTree_last(&left)) == key - 1);
+        }
+
+        if (right.len > 0) {
+            REQUIRE(sized_int_node_key(AvlTree_first(&right)) == key);
+            REQUIRE(sized_int_node_key(AvlTree_last(&right)) == 999);
+        }
+
+        for (std::size_t i = 0; i < left.len; ++i) {
+            REQUIRE(sized_int_node_key(AvlTree_select(&left, i, nullptr))
+                    == static_cast<int>(i));
+        }
+
+        for (std::size_t i = 0; i < right.len; ++i) {
+            REQUIRE(sized_int_node_key(AvlTree_select(&right, i, nullptr))
+                    == key + static_cast<int>(i));
+        }
+
+        AvlTree_concat(&left, &right);
+        tree = left;
+    }
+
+    REQUIRE(tree.len == keys.size());
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        REQUIRE(sized_int_node_key(AvlTree_select(&tree, i, nullptr)) == static_cast<int>(i));
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("remove every range") {
+    const auto urbg_ptr = make_urbg();
+
+    for (int n : {0, 1, 2, 3, 8, 31, 100}) {
+        const std::vector<int> evens = mapped(iota(n), [](int i) { return 2 * i; });
+
+        for (int lo = -1; lo <= 2 * n; ++lo) {
+            for (int hi = lo - 2; hi <= 2 * n + 1; ++hi) {
+                std::vector<IntNode> nodes =
+                    make_int_nodes(shuffled(std::vector<int>(evens), *urbg_ptr));
+                std::vector<int> removed;
+                std::vector<int> expected;
+                AvlTree tree;
+
+                AvlTree_new(&tree, int_node_compare, nullptr, [](AvlNode *node, void *removed_v) {
+                    static_cast<std::vector<int>*>(removed_v)->push_back(int_node_key(node));
+                }, &removed);
+                AvlTree_enable_extremes(&tree);
+
+                for (IntNode &node : nodes) {
+                    AvlTree_insert(&tree, &node);
+                }
+
+                const std::size_t num_removed =
+                    AvlTree_remove_range(&tree, &lo, &hi, int_node_het_compare, nullptr);
+
+                std::copy_if(evens.begin(), evens.end(), std::back_inserter(expected),
+                             [lo, hi](int key) { return key < lo || key >= hi; });
+                std::sort(removed.begin(), removed.end());
+
+                REQUIRE(num_removed == removed.size());
+                REQUIRE(removed.size() + expected.size() == evens.size());
+                require_valid(tree, expected);
+                REQUIRE(std::all_of(removed.begin(), removed.end(),
+                                    [lo, hi](int key) { return key >= lo && key < hi; }));
+
+                if (!expected.empty()) {
+                    REQUIRE(int_node_key(AvlTree_first(&tree)) == expected.front());
+                    REQUIRE(int_node_key(AvlTree_last(&tree)) == expected.back());
+                }
+
+                AvlTree_drop(&tree);
+            }
+        }
+    }
+}
+
+TEST_CASE("remove range keeps sizes") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<SizedIntNode> nodes =
+        make_int_nodes<SizedIntNode>(shuffled(iota(1000), *urbg_ptr));
+    std::vector<int> expected = iota(1000);
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+    }
+
+    for (const auto &range : std::vector<std::pair<int, int>>{{100, 200}, {0, 50}, {990, 2000},
+                                                               {150, 600}, {-5, 75}}) {
+        const auto first = std::lower_bound(expected.begin(), expected.end(), range.first);
+        const auto last = std::lower_bound(expected.begin(), expected.end(), range.second);
+        const auto num_expected = static_cast<std::size_t>(last - first);
+
+        expected.erase(first, last);
+        REQUIRE(AvlTree_remove_range(&tree, &range.first, &range.second,
+                                     sized_int_node_het_compare, nullptr) == num_expected);
+        REQUIRE(tree.len == expected.size());
+        REQUIRE(checked_height(tree.root) >= 0);
+
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(sized_int_node_key(AvlTree_select(&tree, i, nullptr)) == expected[i]);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
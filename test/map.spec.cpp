@@ -0,0 +1,356 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "bloodhound.hpp"
+#include "util.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define HAS_MEMORY_RESOURCE
+#endif
+#endif
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+namespace {
+
+// allocator with state, so that copies and rebinds must carry it along
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(std::size_t *counter) noexcept : live(counter) { }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) noexcept : live(other.live) { }
+
+    T* allocate(std::size_t n) {
+        *live += n;
+
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        *live -= n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    std::size_t *live;
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T> &lhs, const CountingAllocator<U> &rhs) noexcept {
+    return lhs.live == rhs.live;
+}
+
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T> &lhs, const CountingAllocator<U> &rhs) noexcept {
+    return lhs.live != rhs.live;
+}
+
+// orders std::strings and C strings against each other without constructing a std::string
+struct StringLess {
+    using is_transparent = void;
+
+    bool operator()(const std::string &lhs, const std::string &rhs) const noexcept {
+        return lhs < rhs;
+    }
+
+    bool operator()(const std::string &lhs, const char *rhs) const noexcept {
+        return std::strcmp(lhs.c_str(), rhs) < 0;
+    }
+
+    bool operator()(const char *lhs, const std::string &rhs) const noexcept {
+        return std::strcmp(lhs, rhs.c_str()) < 0;
+    }
+};
+
+// counts every call, so tests can assert that an operation never compares keys
+struct CountingLess {
+    explicit CountingLess(std::size_t *counter) noexcept : count(counter) { }
+
+    bool operator()(int lhs, int rhs) const noexcept {
+        ++*count;
+
+        return lhs < rhs;
+    }
+
+    std::size_t *count;
+};
+
+template <typename M>
+void require_equal(const M &actual, const std::map<int, int> &expected) {
+    REQUIRE(actual.size() == expected.size());
+    REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+    REQUIRE(std::equal(actual.rbegin(), actual.rend(), expected.rbegin()));
+}
+
+} // namespace
+
+TEST_CASE("avl::map random insertions and erasures match std::map") {
+    const auto urbg_ptr = make_urbg();
+    avl::map<int, int> map;
+    std::map<int, int> expected;
+
+    for (int key : rand_iota(NUM_INSERTIONS, *urbg_ptr)) {
+        const auto result = map.emplace(key / 2, key);
+        const auto expected_result = expected.emplace(key / 2, key);
+
+        REQUIRE(result.second == expected_result.second);
+        REQUIRE(*result.first == *expected_result.first);
+    }
+
+    require_equal(map, expected);
+
+    for (int key = -1; key <= static_cast<int>(NUM_INSERTIONS); ++key) {
+        const auto lower_bound = map.lower_bound(key);
+        const auto upper_bound = map.upper_bound(key);
+
+        REQUIRE(map.count(key) == expected.count(key));
+        REQUIRE((lower_bound == map.end()) == (expected.lower_bound(key) == expected.end()));
+        REQUIRE((upper_bound == map.end()) == (expected.upper_bound(key) == expected.end()));
+
+        if (lower_bound != map.end()) {
+            REQUIRE(*lower_bound == *expected.lower_bound(key));
+        }
+
+        if (upper_bound != map.end()) {
+            REQUIRE(*upper_bound == *expected.upper_bound(key));
+        }
+    }
+
+    for (int key : rand_iota(NUM_INSERTIONS / 4, *urbg_ptr)) {
+        if (key % 3 == 0) {
+            REQUIRE(map.erase(key) == expected.erase(key));
+        } else {
+            const auto found = map.find(key);
+            REQUIRE(found != map.end());
+
+            const auto next = map.erase(found);
+            const auto expected_next = expected.erase(expected.find(key));
+
+            REQUIRE((next == map.end()) == (expected_next == expected.end()));
+
+            if (next != map.end()) {
+                REQUIRE(*next == *expected_next);
+            }
+        }
+
+        REQUIRE(map.find(key) == map.end());
+    }
+
+    require_equal(map, expected);
+
+    map.erase(std::next(map.begin()), std::prev(map.end()));
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.begin()->first == expected.begin()->first);
+    REQUIRE(std::prev(map.end())->first == expected.rbegin()->first);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.begin() == map.end());
+}
+
+TEST_CASE("avl::map element access and assignment") {
+    avl::map<std::string, int> map = {{"b", 2}, {"a", 1}};
+
+    REQUIRE(map.at("a") == 1);
+    REQUIRE_THROWS_AS(map.at("c"), std::out_of_range);
+
+    map["c"] = 3;
+    ++map["a"];
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.at("a") == 2);
+
+    REQUIRE_FALSE(map.try_emplace("c", 4).second);
+    REQUIRE(map.at("c") == 3);
+    REQUIRE(map.try_emplace("d", 4).second);
+
+    REQUIRE_FALSE(map.insert_or_assign("d", 5).second);
+    REQUIRE(map.at("d") == 5);
+    REQUIRE(map.insert_or_assign("e", 6).second);
+
+    REQUIRE_FALSE(map.insert({"e", 7}).second);
+    REQUIRE(map.at("e") == 6);
+
+    const avl::map<std::string, int> copy = map;
+    avl::map<std::string, int> moved = std::move(map);
+
+    REQUIRE(copy.size() == 5);
+    REQUIRE(std::equal(copy.begin(), copy.end(), moved.begin()));
+
+    moved.erase("a");
+    map = moved;
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.begin()->first == "b");
+
+    swap(map, moved);
+    map = {{"z", 26}};
+    REQUIRE(map.size() == 1);
+    REQUIRE(moved.size() == 4);
+}
+
+TEST_CASE("avl::map transparent lookup") {
+    avl::map<std::string, int, StringLess> map = {{"apple", 1}, {"banana", 2}, {"cherry", 3}};
+
+    REQUIRE(map.find("banana")->second == 2);
+    REQUIRE(map.find("blueberry") == map.end());
+    REQUIRE(map.count("cherry") == 1);
+    REQUIRE(map.lower_bound("b")->first == "banana");
+    REQUIRE(map.upper_bound("banana")->first == "cherry");
+    REQUIRE(map.equal_range("apple").first == map.begin());
+}
+
+TEST_CASE("avl::map node handles") {
+    avl::map<int, std::string> from = {{1, "one"}, {2, "two"}, {3, "three"}};
+    avl::map<int, std::string> to = {{2, "deux"}};
+
+    auto handle = from.extract(1);
+    REQUIRE_FALSE(handle.empty());
+    REQUIRE(handle.key() == 1);
+    REQUIRE(handle.mapped() == "one");
+    REQUIRE(from.size() == 2);
+    REQUIRE(from.extract(4).empty());
+
+    const auto inserted = to.insert(std::move(handle));
+    REQUIRE(inserted.inserted);
+    REQUIRE(inserted.position->second == "one");
+    REQUIRE(inserted.node.empty());
+
+    const auto rejected = to.insert(from.extract(from.find(2)));
+    REQUIRE_FALSE(rejected.inserted);
+    REQUIRE(rejected.position->second == "deux");
+    REQUIRE(rejected.node.key() == 2);
+    REQUIRE(rejected.node.mapped() == "two");
+
+    REQUIRE(from.size() == 1);
+    REQUIRE(to.size() == 2);
+}
+
+TEST_CASE("avl::map node handle keys can be changed") {
+    avl::map<int, std::string> map = {{1, "one"}, {2, "two"}};
+
+    auto handle = map.extract(1);
+    handle.key() = 3;
+
+    REQUIRE(map.insert(std::move(handle)).inserted);
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.count(1) == 0);
+    REQUIRE(map.at(3) == "one");
+    REQUIRE(map.begin()->first == 2);
+}
+
+TEST_CASE("avl::map iterates, erases and extracts by position without comparing") {
+    const auto urbg_ptr = make_urbg();
+    std::size_t comparisons = 0;
+    avl::map<int, int, CountingLess> map{CountingLess(&comparisons)};
+    std::map<int, int> expected;
+
+    for (int key : rand_iota(NUM_INSERTIONS, *urbg_ptr)) {
+        map.emplace(key, key);
+        expected.emplace(key, key);
+    }
+
+    comparisons = 0;
+    require_equal(map, expected);
+    REQUIRE(comparisons == 0);
+
+    bool extract = false;
+
+    for (auto it = map.begin(); it != map.end(); extract = !extract) {
+        if (it->first % 3 == 0) {
+            ++it;
+        } else if (extract) {
+            expected.erase(it->first);
+            REQUIRE_FALSE(map.extract(it++).empty());
+        } else {
+            expected.erase(it->first);
+            it = map.erase(it);
+        }
+    }
+
+    REQUIRE(comparisons == 0);
+    require_equal(map, expected);
+    REQUIRE(comparisons == 0);
+}
+
+TEST_CASE("avl::map allocates through its allocator") {
+    using Allocator = CountingAllocator<std::pair<const int, int>>;
+
+    std::size_t live = 0;
+    std::map<int, int> expected;
+
+    {
+        avl::map<int, int, std::less<int>, Allocator> map{Allocator(&live)};
+
+        for (int key : iota(NUM_INSERTIONS)) {
+            map.emplace(key, key);
+            expected.emplace(key, key);
+        }
+
+        REQUIRE(live == NUM_INSERTIONS);
+
+        const auto copy = map;
+        REQUIRE(live == 2 * NUM_INSERTIONS);
+        require_equal(copy, expected);
+
+        auto handle = map.extract(0);
+        map.erase(1);
+        REQUIRE(live == 2 * NUM_INSERTIONS - 1);
+        REQUIRE(handle.get_allocator() == map.get_allocator());
+    }
+
+    REQUIRE(live == 0);
+}
+
+#ifdef HAS_MEMORY_RESOURCE
+TEST_CASE("avl::map with a polymorphic allocator") {
+    using Map = avl::map<int, std::pmr::string, std::less<int>,
+                         std::pmr::polymorphic_allocator<std::pair<const int, std::pmr::string>>>;
+
+    std::pmr::monotonic_buffer_resource resource;
+    Map map(&resource);
+
+    for (int key : iota(NUM_INSERTIONS)) {
+        map.try_emplace(key, "a string long enough to need a heap allocation");
+    }
+
+    REQUIRE(map.size() == NUM_INSERTIONS);
+
+    // uses-allocator construction passes the map's resource to the strings
+    for (const auto &kv : map) {
+        REQUIRE(kv.second.get_allocator().resource() == &resource);
+    }
+}
+#endif
@@ -0,0 +1,215 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_NODES = 1024;
+
+namespace {
+
+// checks that every child links back to the node that holds it
+bool parents_consistent(const AvlNode *node) {
+    if (!node) {
+        return true;
+    }
+
+    for (const AvlNode *child : {AVL_NODE_LEFT(node), AVL_NODE_RIGHT(node)}) {
+        if (child && reinterpret_cast<const AvlParentNode*>(child)->parent != node) {
+            return false;
+        }
+    }
+
+    return parents_consistent(AVL_NODE_LEFT(node)) && parents_consistent(AVL_NODE_RIGHT(node));
+}
+
+void new_tree(AvlTree &tree) {
+    AvlTree_new(&tree, parent_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_parents(&tree);
+}
+
+void require_contents(const AvlTree &tree, const std::set<int> &expected) {
+    REQUIRE(tree.len == expected.size());
+    REQUIRE(checked_height(tree.root) >= 0);
+    REQUIRE(parents_consistent(tree.root));
+
+    const AvlNode *first = tree.root;
+    const AvlNode *last = tree.root;
+
+    while (first && AVL_NODE_LEFT(first)) {
+        first = AVL_NODE_LEFT(first);
+    }
+
+    while (last && AVL_NODE_RIGHT(last)) {
+        last = AVL_NODE_RIGHT(last);
+    }
+
+    auto it = expected.begin();
+
+    for (const AvlNode *node = first; node; node = AvlTree_next(&tree, node), ++it) {
+        REQUIRE(it != expected.end());
+        REQUIRE(parent_int_node_key(node) == *it);
+    }
+
+    REQUIRE(it == expected.end());
+
+    auto rit = expected.rbegin();
+
+    for (const AvlNode *node = last; node; node = AvlTree_prev(&tree, node), ++rit) {
+        REQUIRE(rit != expected.rend());
+        REQUIRE(parent_int_node_key(node) == *rit);
+    }
+
+    REQUIRE(rit == expected.rend());
+}
+
+} // namespace
+
+TEST_CASE("parent tracking through insertion and removal") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<ParentIntNode> nodes =
+        make_int_nodes<ParentIntNode>(rand_iota(NUM_NODES, *urbg_ptr));
+    std::set<int> expected;
+    AvlTree tree;
+    AvlCursor end;
+
+    new_tree(tree);
+    AvlCursor_new(&end, &tree);
+
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (i % 2 == 0) {
+            AvlTree_insert(&tree, &nodes[i].base.node);
+        } else {
+            AvlTree_insert_hint(&tree, &end, &nodes[i].base.node);
+        }
+
+        expected.insert(nodes[i].key);
+        REQUIRE(parents_consistent(tree.root));
+    }
+
+    require_contents(tree, expected);
+
+    for (std::size_t i = 0; i < nodes.size(); i += 2) {
+        const int key = nodes[i].key;
+
+        if (i % 4 == 0) {
+            AvlTree_remove_node(&tree, &nodes[i].base.node);
+        } else {
+            REQUIRE(AvlTree_remove(&tree, &key, parent_int_node_het_compare, nullptr)
+                    == &nodes[i].base.node);
+        }
+
+        expected.erase(key);
+        REQUIRE(parents_consistent(tree.root));
+    }
+
+    require_contents(tree, expected);
+
+    // replacing an equal node must adopt its children
+    std::vector<ParentIntNode> replacements = make_int_nodes<ParentIntNode>({nodes[1].key});
+    REQUIRE(AvlTree_insert(&tree, &replacements[0].base.node) == &nodes[1].base.node);
+    require_contents(tree, expected);
+
+    while (tree.root) {
+        AvlTree_remove_node(&tree, tree.root);
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("parent tracking through bulk operations") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<ParentIntNode> evens =
+        make_int_nodes<ParentIntNode>(mapped(iota(NUM_NODES), [](int x) { return 2 * x; }));
+    std::vector<ParentIntNode> odds =
+        make_int_nodes<ParentIntNode>(mapped(iota(NUM_NODES), [](int x) { return 2 * x + 1; }));
+    std::vector<AvlNode*> even_ptrs;
+    std::set<int> expected;
+    AvlTree tree;
+    AvlTree other;
+
+    for (ParentIntNode &node : evens) {
+        even_ptrs.push_back(&node.base.node);
+        expected.insert(node.key);
+    }
+
+    new_tree(tree);
+    new_tree(other);
+
+    AvlTree_build_sorted(&tree, even_ptrs.data(), even_ptrs.size());
+    require_contents(tree, expected);
+
+    for (int key : rand_iota(NUM_NODES, *urbg_ptr)) {
+        AvlTree_insert(&other, &odds[static_cast<std::size_t>(key)].base.node);
+        expected.insert(2 * key + 1);
+    }
+
+    AvlTree_union(&tree, &other);
+    require_contents(tree, expected);
+
+    for (int key : {0, 1, 777, 1500, 2047, 3000}) {
+        const int hi = key + 50;
+
+        AvlTree_remove_range(&tree, &key, &hi, parent_int_node_het_compare, nullptr);
+        expected.erase(expected.lower_bound(key), expected.lower_bound(hi));
+        require_contents(tree, expected);
+    }
+
+    for (int key : {0, 1, 777, 1500, 2047, 3000}) {
+        AvlTree left;
+        AvlTree right;
+
+        AvlTree_split(&tree, &key, parent_int_node_het_compare, nullptr, &left, &right);
+        REQUIRE(parents_consistent(left.root));
+        REQUIRE(parents_consistent(right.root));
+
+        AvlTree_concat(&left, &right);
+        tree = left;
+        require_contents(tree, expected);
+    }
+
+    const int pivot_key = 1001;
+    AvlTree left;
+    AvlTree right;
+
+    AvlTree_split(&tree, &pivot_key, parent_int_node_het_compare, nullptr, &left, &right);
+    AvlNode *pivot = right.root;
+
+    while (AVL_NODE_LEFT(pivot)) {
+        pivot = AVL_NODE_LEFT(pivot);
+    }
+
+    AvlTree_remove_node(&right, pivot);
+    AvlTree_join(&left, pivot, &right);
+    tree = left;
+    require_contents(tree, expected);
+
+    AvlTree_drop(&tree);
+}
@@ -0,0 +1,235 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "avl_map.h"
+#include "int_node.h"
+#include "util.h"
+
+#include <cstdint>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+IntNode* new_pooled_node(AvlNodePool &pool, int key) {
+    return new (AvlNodePool_alloc(&pool)) IntNode(key);
+}
+
+void count_delete(AvlNode*, void *count_v) {
+    ++*static_cast<std::size_t*>(count_v);
+}
+
+} // namespace
+
+TEST_CASE("pool allocation is aligned and distinct") {
+    AvlNodePool pool;
+    std::set<void*> allocated;
+
+    AvlNodePool_new(&pool, 3, 7);
+
+    for (int i = 0; i < 100; ++i) {
+        void *const node = AvlNodePool_alloc(&pool);
+
+        REQUIRE(reinterpret_cast<std::uintptr_t>(node) % alignof(std::max_align_t) == 0);
+        REQUIRE(allocated.insert(node).second);
+    }
+
+    REQUIRE(pool.len == 100);
+
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("pool reuses freed nodes") {
+    AvlNodePool pool;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+
+    void *const first = AvlNodePool_alloc(&pool);
+    void *const second = AvlNodePool_alloc(&pool);
+
+    AvlNodePool_free(&pool, first);
+    REQUIRE(pool.len == 1);
+    REQUIRE(AvlNodePool_alloc(&pool) == first);
+
+    AvlNodePool_free(&pool, second);
+    AvlNodePool_free(&pool, first);
+    REQUIRE(pool.len == 0);
+
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("pool reset keeps the newest chunk") {
+    AvlNodePool pool;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 16);
+
+    for (int i = 0; i < 100; ++i) {
+        AvlNodePool_alloc(&pool);
+    }
+
+    void *const newest = pool.chunks;
+
+    AvlNodePool_reset(&pool);
+
+    REQUIRE(pool.len == 0);
+    REQUIRE(pool.chunks == newest);
+    REQUIRE_FALSE(pool.free_list);
+
+    for (int i = 0; i < 16; ++i) {
+        AvlNodePool_alloc(&pool);
+    }
+
+    REQUIRE(pool.chunks == newest);
+
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("clearing a pooled tree resets its pool") {
+    const auto urbg_ptr = make_urbg();
+    AvlNodePool pool;
+    AvlTree tree;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&tree, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    for (int round = 0; round < 3; ++round) {
+        for (int key : rand_iota(10000, *urbg_ptr)) {
+            REQUIRE_FALSE(AvlTree_insert(&tree, new_pooled_node(pool, key)));
+        }
+
+        const int removed_key = 42;
+        AvlNodePool_deleter(AvlTree_remove(&tree, &removed_key, int_node_het_compare, nullptr),
+                            &pool);
+
+        REQUIRE(pool.len == tree.len);
+
+        AvlTree_clear(&tree);
+
+        REQUIRE_FALSE(tree.root);
+        REQUIRE(tree.len == 0);
+        REQUIRE(pool.len == 0);
+        REQUIRE_FALSE(pool.free_list);
+    }
+
+    AvlTree_drop(&tree);
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("clearing a tree that shares its pool frees node by node") {
+    AvlNodePool pool;
+    AvlTree first;
+    AvlTree second;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&first, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+    AvlTree_new(&second, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    for (int key : iota(100)) {
+        REQUIRE_FALSE(AvlTree_insert(&first, new_pooled_node(pool, key)));
+        REQUIRE_FALSE(AvlTree_insert(&second, new_pooled_node(pool, key)));
+    }
+
+    AvlTree_clear(&first);
+
+    REQUIRE(pool.len == 100);
+
+    AvlTree_clear(&second);
+
+    REQUIRE(pool.len == 0);
+
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("pooled nodes with a custom deleter are visited") {
+    AvlNodePool pool;
+    AvlTree tree;
+    std::size_t num_deleted = 0;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&tree, int_node_compare, nullptr, count_delete, &num_deleted);
+
+    for (int key : iota(100)) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, new_pooled_node(pool, key)));
+    }
+
+    AvlTree_clear(&tree);
+
+    REQUIRE(num_deleted == 100);
+
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("parallel set operations on pooled trees") {
+    AvlNodePool pool;
+    AvlTree self;
+    AvlTree other;
+
+    AvlNodePool_new(&pool, sizeof(IntNode), 0);
+    AvlTree_new(&self, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+    AvlTree_new(&other, int_node_compare, nullptr, AvlNodePool_deleter, &pool);
+
+    for (int key : iota(100000)) {
+        if (key % 2 == 0) {
+            REQUIRE_FALSE(AvlTree_insert(&self, new_pooled_node(pool, key)));
+        }
+
+        if (key % 3 == 0) {
+            REQUIRE_FALSE(AvlTree_insert(&other, new_pooled_node(pool, key)));
+        }
+    }
+
+    AvlTree_union_parallel(&self, &other, 8);
+
+    REQUIRE(checked_height(self.root) >= 0);
+    REQUIRE(self.len == 50000 + 33334 - 16667);
+    REQUIRE(pool.len == self.len);
+    REQUIRE_FALSE(other.root);
+
+    AvlTree_drop(&self);
+    AvlTree_drop(&other);
+    AvlNodePool_drop(&pool);
+}
+
+TEST_CASE("pooled map with non-trivial values") {
+    avl::Map<int, std::string> map;
+
+    for (int i = 0; i < 1000; ++i) {
+        map.insert(i, std::string(64, 'a'));
+    }
+
+    for (int i = 0; i < 1000; i += 2) {
+        REQUIRE(map.remove(i));
+    }
+
+    REQUIRE(map.keys() == mapped(iota(500), [](int i) { return 2 * i + 1; }));
+
+    map.clear();
+
+    REQUIRE(map.keys().empty());
+}
@@ -0,0 +1,193 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_NODES = 1024;
+
+namespace {
+
+const AvlNode* leftmost(const AvlNode *node) {
+    while (node && AVL_NODE_LEFT(node)) {
+        node = AVL_NODE_LEFT(node);
+    }
+
+    return node;
+}
+
+const AvlNode* rightmost(const AvlNode *node) {
+    while (node && AVL_NODE_RIGHT(node)) {
+        node = AVL_NODE_RIGHT(node);
+    }
+
+    return node;
+}
+
+void require_extremes(const AvlTree &tree) {
+    REQUIRE(AvlTree_first(&tree) == leftmost(tree.root));
+    REQUIRE(AvlTree_last(&tree) == rightmost(tree.root));
+
+    if (tree.caches_extremes) {
+        REQUIRE(tree.first == leftmost(tree.root));
+        REQUIRE(tree.last == rightmost(tree.root));
+    }
+}
+
+} // namespace
+
+TEST_CASE("pop_first and pop_last") {
+    const bool caches_extremes = GENERATE(false, true);
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(NUM_NODES, *urbg_ptr));
+    std::set<int> expected;
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    if (caches_extremes) {
+        AvlTree_enable_extremes(&tree);
+    }
+
+    REQUIRE_FALSE(AvlTree_first(&tree));
+    REQUIRE_FALSE(AvlTree_last(&tree));
+    REQUIRE_FALSE(AvlTree_pop_first(&tree));
+    REQUIRE_FALSE(AvlTree_pop_last(&tree));
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert(&tree, &node);
+        expected.insert(node.key);
+        require_extremes(tree);
+    }
+
+    for (std::size_t i = 0; i < NUM_NODES; ++i) {
+        AvlNode *popped;
+
+        if (i % 3 == 0) {
+            popped = AvlTree_pop_last(&tree);
+            REQUIRE(int_node_key(popped) == *expected.rbegin());
+            expected.erase(std::prev(expected.end()));
+        } else {
+            popped = AvlTree_pop_first(&tree);
+            REQUIRE(int_node_key(popped) == *expected.begin());
+            expected.erase(expected.begin());
+        }
+
+        REQUIRE_FALSE(AVL_NODE_LEFT(popped));
+        REQUIRE_FALSE(AVL_NODE_RIGHT(popped));
+        REQUIRE(tree.len == expected.size());
+        REQUIRE(checked_height(tree.root) >= 0);
+        require_extremes(tree);
+    }
+
+    REQUIRE_FALSE(tree.root);
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("cached extremes through every kind of update") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(NUM_NODES, *urbg_ptr));
+    std::vector<IntNode> replacements = make_int_nodes(iota(NUM_NODES));
+    std::vector<IntNode> sorted_nodes = make_int_nodes(iota(NUM_NODES, static_cast<int>(NUM_NODES)));
+    std::vector<AvlNode*> sorted_ptrs;
+    AvlTree tree;
+    AvlTree other;
+    AvlCursor end;
+
+    for (IntNode &node : sorted_nodes) {
+        sorted_ptrs.push_back(&node);
+    }
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_new(&other, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_extremes(&tree);
+    AvlTree_enable_extremes(&other);
+    AvlCursor_new(&end, &tree);
+
+    for (IntNode &node : nodes) {
+        AvlTree_insert_hint(&tree, &end, &node);
+        require_extremes(tree);
+    }
+
+    // replacing the extremes must move the cached pointers along
+    AvlTree_insert(&tree, &replacements.front());
+    AvlTree_insert(&tree, &replacements.back());
+    require_extremes(tree);
+    REQUIRE(AvlTree_first(&tree) == &replacements.front());
+    REQUIRE(AvlTree_last(&tree) == &replacements.back());
+
+    for (int key : {0, static_cast<int>(NUM_NODES) - 1, 500}) {
+        AvlTree_remove(&tree, &key, int_node_het_compare, nullptr);
+        require_extremes(tree);
+    }
+
+    AvlTree_build_sorted(&other, sorted_ptrs.data(), sorted_ptrs.size());
+    require_extremes(other);
+
+    AvlTree_union(&tree, &other);
+    require_extremes(tree);
+    require_extremes(other);
+
+    for (int key : {-1, 1, 1000, 1500, 4000}) {
+        AvlTree left;
+        AvlTree right;
+
+        AvlTree_split(&tree, &key, int_node_het_compare, nullptr, &left, &right);
+        require_extremes(left);
+        require_extremes(right);
+
+        AvlTree_concat(&left, &right);
+        require_extremes(left);
+        tree = left;
+    }
+
+    for (int key : {-1, 1, 1000, 1500, 4000}) {
+        const int hi = key + 100;
+
+        AvlTree_remove_range(&tree, &key, &hi, int_node_het_compare, nullptr);
+        require_extremes(tree);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        AvlTree_insert(&other, AvlTree_pop_last(&tree));
+    }
+
+    require_extremes(tree);
+    require_extremes(other);
+
+    AvlTree_concat(&tree, &other);
+    require_extremes(tree);
+
+    AvlTree_clear(&tree);
+    require_extremes(tree);
+
+    AvlTree_drop(&tree);
+    AvlTree_drop(&other);
+}
@@ -0,0 +1,145 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+namespace {
+
+struct Scan {
+    std::vector<int> keys;
+    std::size_t limit = static_cast<std::size_t>(-1);
+};
+
+int collect(void *context, const AvlNode *node) {
+    Scan &scan = *static_cast<Scan*>(context);
+
+    if (scan.keys.size() == scan.limit) {
+        return 1;
+    }
+
+    scan.keys.push_back(int_node_key(node));
+
+    return 0;
+}
+
+int double_key(void*, AvlNode *node) {
+    IntNode &int_node = *static_cast<IntNode*>(node);
+    int_node.key *= 2;
+
+    return 0;
+}
+
+int counting_het_compare(const void *lhs, const AvlNode *rhs, void *count) {
+    ++*static_cast<std::size_t*>(count);
+
+    return int_node_het_compare(lhs, rhs, nullptr);
+}
+
+} // namespace
+
+TEST_CASE("range scan") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<IntNode> nodes = make_int_nodes(rand_iota(NUM_INSERTIONS, *urbg_ptr));
+    AvlTree tree;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+
+    for (int lo = -3; lo < static_cast<int>(NUM_INSERTIONS) + 3; lo += 61) {
+        for (int hi = lo - 2; hi < static_cast<int>(NUM_INSERTIONS) + 3; hi += 97) {
+            Scan scan;
+            std::size_t num_compares = 0;
+            std::vector<int> expected;
+
+            for (int i = std::max(lo, 0); i < std::min(hi, static_cast<int>(NUM_INSERTIONS)); ++i) {
+                expected.push_back(i);
+            }
+
+            REQUIRE(AvlTree_range(&tree, &lo, &hi, counting_het_compare, &num_compares,
+                                  collect, &scan) == 0);
+            REQUIRE(scan.keys == expected);
+
+            // one descent to lo plus one comparison against hi per node visited
+            REQUIRE(num_compares <= expected.size() + 1 + 2 * 16);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("range scan stops early") {
+    std::vector<IntNode> nodes = make_int_nodes(iota(NUM_INSERTIONS));
+    AvlTree tree;
+    Scan scan;
+    const int lo = 100;
+    const int hi = 1000;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+
+    scan.limit = 10;
+    REQUIRE(AvlTree_range(&tree, &lo, &hi, int_node_het_compare, nullptr, collect, &scan) == 1);
+    REQUIRE(scan.keys == iota(10, 100));
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("mutable range scan") {
+    std::vector<IntNode> nodes = make_int_nodes(iota(NUM_INSERTIONS));
+    AvlTree tree;
+    const int lo = 10;
+    const int hi = 20;
+
+    AvlTree_new(&tree, int_node_compare, nullptr, int_node_noop_delete, nullptr);
+
+    for (IntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+    }
+
+    // doubling [10, 20) keeps every key in order
+    REQUIRE(AvlTree_range_mut(&tree, &lo, &hi, int_node_het_compare, nullptr, double_key,
+                              nullptr) == 0);
+
+    for (int i = 0; i < static_cast<int>(NUM_INSERTIONS); ++i) {
+        const bool in_range = i >= lo && i < hi;
+
+        REQUIRE(nodes[static_cast<std::size_t>(i)].key == (in_range ? 2 * i : i));
+    }
+
+    AvlTree_drop(&tree);
+}
@@ -0,0 +1,144 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+constexpr std::size_t NUM_INSERTIONS = 2048;
+
+static_assert(sizeof(AvlNode) < sizeof(AvlSizedNode), "untracked nodes must not grow");
+
+namespace {
+
+void require_ranks(const AvlTree &tree, const std::vector<int> &contained) {
+    REQUIRE(tree.len == contained.size());
+
+    for (std::size_t i = 0; i < contained.size(); ++i) {
+        const AvlNode *const node = AvlTree_select(&tree, i, nullptr);
+
+        REQUIRE(node);
+        REQUIRE(sized_int_node_key(node) == contained[i]);
+        REQUIRE(AvlTree_rank(&tree, &contained[i], sized_int_node_het_compare, nullptr) == i);
+    }
+
+    REQUIRE_FALSE(AvlTree_select(&tree, contained.size(), nullptr));
+}
+
+} // namespace
+
+TEST_CASE("random insert, random remove, rank and select") {
+    const auto urbg_ptr = make_urbg();
+    const std::vector<int> keys = rand_iota(NUM_INSERTIONS, *urbg_ptr);
+    std::vector<SizedIntNode> nodes = make_int_nodes<SizedIntNode>(keys);
+    std::vector<int> contained;
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+        contained.insert(std::lower_bound(contained.begin(), contained.end(), node.key),
+                         node.key);
+
+        if (contained.size() % 256 == 0) {
+            require_ranks(tree, contained);
+        }
+    }
+
+    require_ranks(tree, contained);
+
+    for (int key : shuffled(std::vector<int>(keys), *urbg_ptr)) {
+        REQUIRE(AvlTree_remove(&tree, &key, sized_int_node_het_compare, nullptr));
+        contained.erase(std::lower_bound(contained.begin(), contained.end(), key));
+
+        if (contained.size() % 256 == 0) {
+            require_ranks(tree, contained);
+        }
+    }
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("rank of missing keys, select with cursor") {
+    std::vector<SizedIntNode> nodes = make_int_nodes<SizedIntNode>(
+        mapped(iota(NUM_INSERTIONS), [](int i) { return 2 * i; })
+    );
+    AvlTree tree;
+    AvlCursor cursor;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+    }
+
+    for (int i = -1; i < 2 * static_cast<int>(NUM_INSERTIONS); i += 2) {
+        REQUIRE(AvlTree_rank(&tree, &i, sized_int_node_het_compare, nullptr)
+                == static_cast<std::size_t>(i + 1) / 2);
+    }
+
+    // 99th percentile, then scan the rest
+    const std::size_t index = NUM_INSERTIONS * 99 / 100;
+    const AvlNode *node = AvlTree_select(&tree, index, &cursor);
+    std::size_t scanned = 0;
+
+    for (; node; node = AvlCursor_next(&cursor), ++scanned) {
+        REQUIRE(sized_int_node_key(node) == static_cast<int>(2 * (index + scanned)));
+    }
+
+    REQUIRE(scanned == NUM_INSERTIONS - index);
+
+    AvlTree_drop(&tree);
+}
+
+TEST_CASE("replacing a node keeps sizes") {
+    std::vector<SizedIntNode> nodes = make_int_nodes<SizedIntNode>(iota(64));
+    std::vector<SizedIntNode> replacements = make_int_nodes<SizedIntNode>(iota(64));
+    AvlTree tree;
+
+    AvlTree_new(&tree, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&tree);
+
+    for (SizedIntNode &node : nodes) {
+        REQUIRE_FALSE(AvlTree_insert(&tree, &node.base.node));
+    }
+
+    for (std::size_t i = 0; i < replacements.size(); ++i) {
+        REQUIRE(AvlTree_insert(&tree, &replacements[i].base.node) == &nodes[i].base.node);
+    }
+
+    for (std::size_t i = 0; i < replacements.size(); ++i) {
+        REQUIRE(AvlTree_select(&tree, i, nullptr) == &replacements[i].base.node);
+    }
+
+    AvlTree_drop(&tree);
+}
@@ -0,0 +1,275 @@
+//  MIT License
+//
+//  Copyright (c) 2019 Gregory Meyer
+//
+//  Permission is hereby granted, free of charge, to any person
+//  obtaining a copy of this software and associated documentation
+//  files (the "Software"), to deal in the Software without
+//  restriction, including without limitation the rights to use, copy,
+//  modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice (including
+//  the next paragraph) shall be included in all copies or substantial
+//  portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+//  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+//  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+
+#include "int_node.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+void count_delete(AvlNode*, void *count_v) {
+    ++*static_cast<std::atomic<std::size_t>*>(count_v);
+}
+
+void record_delete(AvlNode *node, void *deleted_v) {
+    static_cast<std::vector<int>*>(deleted_v)->push_back(int_node_key(node));
+}
+
+struct Operand {
+    Operand(std::vector<int> unsorted_keys, std::vector<int> &deleted)
+    : keys(sorted(std::move(unsorted_keys))), nodes(make_int_nodes(this->keys)) {
+        AvlTree_new(&tree, int_node_compare, nullptr, record_delete, &deleted);
+
+        for (IntNode &node : nodes) {
+            REQUIRE_FALSE(AvlTree_insert(&tree, &node));
+        }
+    }
+
+    bool owns(const AvlNode *node) const {
+        return node >= nodes.data() && node < nodes.data() + nodes.size();
+    }
+
+    std::vector<int> keys;
+    std::vector<IntNode> nodes;
+    AvlTree tree;
+};
+
+template <typename URBG>
+std::vector<int> random_subset(int n, double density, URBG &urbg) {
+    std::bernoulli_distribution keep(density);
+    std::vector<int> subset;
+
+    for (int i = 0; i < n; ++i) {
+        if (keep(urbg)) {
+            subset.push_back(i);
+        }
+    }
+
+    return shuffled(std::move(subset), urbg);
+}
+
+} // namespace
+
+TEST_CASE("union") {
+    const auto urbg_ptr = make_urbg();
+
+    for (double self_density : {0.0, 0.01, 0.5, 0.99}) {
+        for (double other_density : {0.0, 0.01, 0.5, 0.99}) {
+            std::vector<int> self_deleted;
+            std::vector<int> other_deleted;
+            Operand self(random_subset(1000, self_density, *urbg_ptr), self_deleted);
+            Operand other(random_subset(1000, other_density, *urbg_ptr), other_deleted);
+            std::vector<int> expected;
+            std::vector<int> duplicates;
+
+            std::set_union(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                           other.keys.end(), std::back_inserter(expected));
+            std::set_intersection(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                                  other.keys.end(), std::back_inserter(duplicates));
+
+            AvlTree_union(&self.tree, &other.tree);
+
+            require_valid(self.tree, expected);
+            require_valid(other.tree, {});
+            REQUIRE(self_deleted.empty());
+            REQUIRE(sorted(std::move(other_deleted)) == duplicates);
+
+            AvlCursor cursor;
+            AvlCursor_new(&cursor, &self.tree);
+
+            for (const AvlNode *node = AvlCursor_first(&cursor); node;
+                 node = AvlCursor_next(&cursor)) {
+                if (std::binary_search(duplicates.begin(), duplicates.end(),
+                                       int_node_key(node))) {
+                    REQUIRE(self.owns(node));
+                }
+            }
+
+            AvlTree_drop(&self.tree);
+        }
+    }
+}
+
+TEST_CASE("intersection") {
+    const auto urbg_ptr = make_urbg();
+
+    for (double self_density : {0.0, 0.01, 0.5, 0.99}) {
+        for (double other_density : {0.0, 0.01, 0.5, 0.99}) {
+            std::vector<int> self_deleted;
+            std::vector<int> other_deleted;
+            Operand self(random_subset(1000, self_density, *urbg_ptr), self_deleted);
+            Operand other(random_subset(1000, other_density, *urbg_ptr), other_deleted);
+            std::vector<int> expected;
+            std::vector<int> dropped;
+
+            std::set_intersection(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                                  other.keys.end(), std::back_inserter(expected));
+            std::set_difference(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                                other.keys.end(), std::back_inserter(dropped));
+
+            AvlTree_intersection(&self.tree, &other.tree);
+
+            require_valid(self.tree, expected);
+            require_valid(other.tree, {});
+            REQUIRE(sorted(std::move(self_deleted)) == dropped);
+            REQUIRE(sorted(std::move(other_deleted)) == other.keys);
+
+            self_deleted.clear();
+            AvlTree_drop(&self.tree);
+            REQUIRE(sorted(std::move(self_deleted)) == expected);
+        }
+    }
+}
+
+TEST_CASE("difference") {
+    const auto urbg_ptr = make_urbg();
+
+    for (double self_density : {0.0, 0.01, 0.5, 0.99}) {
+        for (double other_density : {0.0, 0.01, 0.5, 0.99}) {
+            std::vector<int> self_deleted;
+            std::vector<int> other_deleted;
+            Operand self(random_subset(1000, self_density, *urbg_ptr), self_deleted);
+            Operand other(random_subset(1000, other_density, *urbg_ptr), other_deleted);
+            std::vector<int> expected;
+            std::vector<int> dropped;
+
+            std::set_difference(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                                other.keys.end(), std::back_inserter(expected));
+            std::set_intersection(self.keys.begin(), self.keys.end(), other.keys.begin(),
+                                  other.keys.end(), std::back_inserter(dropped));
+
+            AvlTree_difference(&self.tree, &other.tree);
+
+            require_valid(self.tree, expected);
+            require_valid(other.tree, {});
+            REQUIRE(sorted(std::move(self_deleted)) == dropped);
+            REQUIRE(sorted(std::move(other_deleted)) == other.keys);
+
+            AvlTree_drop(&self.tree);
+        }
+    }
+}
+
+TEST_CASE("set operations keep sizes") {
+    const auto urbg_ptr = make_urbg();
+    std::vector<SizedIntNode> evens =
+        make_int_nodes<SizedIntNode>(mapped(iota(500), [](int i) { return 2 * i; }));
+    std::vector<SizedIntNode> small =
+        make_int_nodes<SizedIntNode>(shuffled(iota(300, 100), *urbg_ptr));
+    AvlTree self;
+    AvlTree other;
+
+    AvlTree_new(&self, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&self);
+    AvlTree_new(&other, sized_int_node_compare, nullptr, int_node_noop_delete, nullptr);
+    AvlTree_enable_sizes(&other);
+
+    for (SizedIntNode &node : evens) {
+        REQUIRE_FALSE(AvlTree_insert(&self, &node.base.node));
+    }
+
+    for (SizedIntNode &node : small) {
+        REQUIRE_FALSE(AvlTree_insert(&other, &node.base.node));
+    }
+
+    AvlTree_difference(&self, &other);
+
+    REQUIRE(self.len == 350);
+    REQUIRE(checked_height(self.root) >= 0);
+
+    for (std::size_t i = 0; i < self.len; ++i) {
+        const int expected = (i < 50) ? static_cast<int>(2 * i) : static_cast<int>(2 * i + 300);
+
+        REQUIRE(sized_int_node_key(AvlTree_select(&self, i, nullptr)) == expected);
+    }
+
+    AvlTree_drop(&self);
+}
+
+TEST_CASE("parallel set operations") {
+    const auto urbg_ptr = make_urbg();
+    constexpr int NUM_KEYS = 200000;
+    const std::vector<int> self_keys = sorted(random_subset(NUM_KEYS, 0.5, *urbg_ptr));
+    const std::vector<int> other_keys = sorted(random_subset(NUM_KEYS, 0.5, *urbg_ptr));
+    std::vector<int> expected_union;
+    std::vector<int> expected_intersection;
+    std::vector<int> expected_difference;
+
+    std::set_union(self_keys.begin(), self_keys.end(), other_keys.begin(), other_keys.end(),
+                   std::back_inserter(expected_union));
+    std::set_intersection(self_keys.begin(), self_keys.end(), other_keys.begin(),
+                          other_keys.end(), std::back_inserter(expected_intersection));
+    std::set_difference(self_keys.begin(), self_keys.end(), other_keys.begin(),
+                        other_keys.end(), std::back_inserter(expected_difference));
+
+    const auto check = [&](void (*op)(AvlTree*, AvlTree*, std::size_t),
+                           const std::vector<int> &expected) {
+        std::vector<SizedIntNode> self_nodes = make_int_nodes<SizedIntNode>(self_keys);
+        std::vector<SizedIntNode> other_nodes = make_int_nodes<SizedIntNode>(other_keys);
+        std::vector<AvlNode*> self_ptrs;
+        std::vector<AvlNode*> other_ptrs;
+        std::atomic<std::size_t> num_deleted(0);
+        AvlTree self;
+        AvlTree other;
+
+        for (SizedIntNode &node : self_nodes) {
+            self_ptrs.push_back(&node.base.node);
+        }
+
+        for (SizedIntNode &node : other_nodes) {
+            other_ptrs.push_back(&node.base.node);
+        }
+
+        AvlTree_new(&self, sized_int_node_compare, nullptr, count_delete, &num_deleted);
+        AvlTree_enable_sizes(&self);
+        AvlTree_build_sorted(&self, self_ptrs.data(), self_ptrs.size());
+        AvlTree_new(&other, sized_int_node_compare, nullptr, count_delete, &num_deleted);
+        AvlTree_enable_sizes(&other);
+        AvlTree_build_sorted(&other, other_ptrs.data(), other_ptrs.size());
+
+        op(&self, &other, 8);
+
+        REQUIRE(checked_height(self.root) >= 0);
+        REQUIRE(self.len == expected.size());
+        REQUIRE(num_deleted == self_keys.size() + other_keys.size() - expected.size());
+        REQUIRE_FALSE(other.root);
+
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(sized_int_node_key(AvlTree_select(&self, i, nullptr)) == expected[i]);
+        }
+
+        AvlTree_drop(&self);
+    };
+
+    check(AvlTree_union_parallel, expected_union);
+    check(AvlTree_intersection_parallel, expected_intersection);
+    check(AvlTree_difference_parallel, expected_difference);
+}